@@ -14,6 +14,11 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include <functional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
 #include "lib/json.h"
 #include "JsonObjects.h"
 #include "helpers.h"
@@ -140,6 +145,7 @@ JsonObjects::add_header_type(const cstring& name, Util::JsonArray*& fields, unsi
     if (max_length > 0)
         header_type->emplace("max_length", max_length);
     header_types->append(header_type);
+    header_type_by_name.emplace(name, header_type);
     return id;
 }
 
@@ -181,6 +187,7 @@ JsonObjects::add_header_type(const cstring& name) {
     auto temp = new Util::JsonArray();
     header_type->emplace("fields", temp);
     header_types->append(header_type);
+    header_type_by_name.emplace(name, header_type);
     return id;
 }
 
@@ -189,9 +196,10 @@ JsonObjects::add_header_type(const cstring& name) {
 void
 JsonObjects::add_header_field(const cstring& name, Util::JsonArray*& field) {
     CHECK_NULL(field);
-    Util::JsonObject* headerType = find_object_by_name(header_types, name);
+    Util::JsonObject* headerType = ::get(header_type_by_name, name);
+    BUG_CHECK(headerType != nullptr, "header '%1%' not found", name);
     Util::JsonArray* fields = headerType->get("fields")->to<Util::JsonArray>();
-    BUG_CHECK(fields != nullptr, "header '%1%' not found", name);
+    CHECK_NULL(fields);
     fields->append(field);
 }
 
@@ -270,9 +278,10 @@ void
 JsonObjects::add_enum(const cstring& enum_name, const cstring& entry_name,
                       const unsigned entry_value) {
     // look up enum in json by name
-    Util::JsonObject* enum_json = find_object_by_name(enums, enum_name);
+    Util::JsonObject* enum_json = ::get(enum_by_name, enum_name);
     if (enum_json == nullptr) {  // first entry in a new enum
         enum_json = new Util::JsonObject();
+        enum_by_name.emplace(enum_name, enum_json);
         enum_json->emplace("name", enum_name);
         auto entries = insert_array_field(enum_json, "entries");
         auto entry = new Util::JsonArray();
@@ -411,4 +420,122 @@ JsonObjects::add_extern(const cstring& name, const cstring& type,
     externs->append(extn);
 }
 
+namespace {
+// The contents of 'obj' except the keys in 'ignored'
+std::string contents(const Util::JsonObject* obj, std::set<cstring> ignored) {
+    Util::JsonObject copy;
+    for (auto it : *obj)
+        if (!ignored.count(it.first))
+            copy.emplace(it.first, it.second);
+    std::stringstream str;
+    copy.serialize(str);
+    return str.str();
+}
+
+// Removes the elements of 'array' with the same contents as an earlier
+// one; returns the kept element for the 'key' of each removed element.
+template<typename Key>
+std::map<Key, Key> removeDuplicates(Util::JsonArray* array, cstring key,
+                                    std::set<cstring> ignored,
+                                    std::function<Key(const Util::IJson*)> keyOf) {
+    std::map<Key, Key> replaced;
+    std::unordered_map<std::string, Key> kept;
+    Util::JsonArray unique;
+    for (auto e : *array) {
+        auto obj = e->to<Util::JsonObject>();
+        CHECK_NULL(obj);
+        auto k = keyOf(obj->get(key));
+        auto inserted = kept.emplace(contents(obj, ignored), k);
+        if (inserted.second)
+            unique.push_back(e);
+        else
+            replaced.emplace(k, inserted.first->second);
+    }
+    array->swap(unique);
+    return replaced;
+}
+
+unsigned getId(const Util::IJson* json) {
+    return json->to<Util::JsonValue>()->getInt();
+}
+
+cstring getName(const Util::IJson* json) {
+    return json->to<Util::JsonValue>()->getString();
+}
+}  // namespace
+
+void
+JsonObjects::deduplicate() {
+    // The name of a learn list is used by the control plane to identify
+    // the digest, so learn lists with different names are kept.
+    auto calcs = removeDuplicates<cstring>(
+        calculations, "name", {"name", "id", "source_info"}, getName);
+    auto lists = removeDuplicates<unsigned>(field_lists, "id", {"name", "id"}, getId);
+    auto learn = removeDuplicates<unsigned>(learn_lists, "id", {"id"}, getId);
+    LOG1("Removed " << calcs.size() << " calculations, " << lists.size() <<
+         " field lists and " << learn.size() << " learn lists identical to another one");
+
+    // The field list ids are the constant parameters of these primitives
+    static const std::map<cstring, std::pair<unsigned, bool>> listParameters = {
+        { "clone_ingress_pkt_to_egress", { 1, false } },
+        { "clone_egress_pkt_to_egress", { 1, false } },
+        { "resubmit", { 0, false } },
+        { "recirculate", { 0, false } },
+        { "generate_digest", { 1, true } },
+    };
+    for (auto a : *actions) {
+        auto primitives = a->to<Util::JsonObject>()->get("primitives")->to<Util::JsonArray>();
+        for (auto p : *primitives) {
+            auto primitive = p->to<Util::JsonObject>();
+            auto parameters = primitive->get("parameters")->to<Util::JsonArray>();
+            if (parameters == nullptr)
+                continue;
+            cstring op = getName(primitive->get("op"));
+            auto it = listParameters.find(op);
+            if (it != listParameters.end()) {
+                auto& replaced = it->second.second ? learn : lists;
+                unsigned index = it->second.first;
+                if (index >= parameters->size())
+                    continue;
+                // only constant ids can be rewritten
+                auto param = parameters->at(index)->to<Util::JsonObject>();
+                if (param == nullptr || param->get("type") == nullptr ||
+                    getName(param->get("type")) != "hexstr")
+                    continue;
+                auto value = param->get("value")->to<Util::JsonValue>();
+                if (value == nullptr || !value->isString())
+                    continue;
+                auto id = std::stoul(value->getString().c_str(), nullptr, 16);
+                auto r = replaced.find(id);
+                if (r != replaced.end()) {
+                    auto cst = new Util::JsonObject();
+                    cst->emplace("type", "hexstr");
+                    cst->emplace("value", stringRepr(r->second, 4));
+                    (*parameters)[index] = cst;
+                }
+                continue;
+            }
+            for (size_t i = 0; i < parameters->size(); i++) {
+                auto param = parameters->at(i)->to<Util::JsonObject>();
+                if (param == nullptr || param->get("type") == nullptr ||
+                    getName(param->get("type")) != "calculation")
+                    continue;
+                auto r = calcs.find(getName(param->get("value")));
+                if (r != calcs.end()) {
+                    auto calc = new Util::JsonObject();
+                    calc->emplace("type", "calculation");
+                    calc->emplace("value", r->second);
+                    (*parameters)[i] = calc;
+                }
+            }
+        }
+    }
+    for (auto c : *checksums) {
+        auto checksum = c->to<Util::JsonObject>();
+        auto r = calcs.find(getName(checksum->get("calculation")));
+        if (r != calcs.end())
+            (*checksum)["calculation"] = new Util::JsonValue(r->second);
+    }
+}
+
 }  // namespace BMV2
@@ -53,6 +53,10 @@ class JsonObjects {
     void add_extern_attribute(const cstring& name, const cstring& type,
                               const cstring& value, Util::JsonArray* attributes);
     void add_extern(const cstring& name, const cstring& type, Util::JsonArray*& attributes);
+    /// Removes the calculations, field lists and learn lists identical to
+    /// an earlier one and redirects the references to the earlier one.
+    /// This must run after the whole program has been converted.
+    void deduplicate();
     JsonObjects();
     Util::JsonArray* insert_array_field(Util::JsonObject* parent, cstring name);
     Util::JsonArray* append_array(Util::JsonArray* parent);
@@ -89,6 +93,11 @@ class JsonObjects {
     Util::JsonArray* register_arrays;
     Util::JsonArray* force_arith;
     Util::JsonArray* field_aliases;
+
+ private:
+    // Index of header_types and enums by name
+    std::map<cstring, Util::JsonObject*> header_type_by_name;
+    std::map<cstring, Util::JsonObject*> enum_by_name;
 };
 
 }  // namespace BMV2
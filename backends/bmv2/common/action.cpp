@@ -19,6 +19,27 @@ limitations under the License.
 
 namespace BMV2 {
 
+namespace {
+// True if 'expression' denotes the same object wherever it appears in an action.
+bool isFixedReference(const IR::Expression* expression) {
+    if (expression->is<IR::PathExpression>())
+        return true;
+    if (auto member = expression->to<IR::Member>())
+        return isFixedReference(member->expr);
+    if (auto index = expression->to<IR::ArrayIndex>())
+        return index->right->is<IR::Constant>() && isFixedReference(index->left);
+    return false;
+}
+
+bool isHeaderUnion(const Util::IJson* json) {
+    auto obj = json->to<Util::JsonObject>();
+    if (obj == nullptr || obj->get("type") == nullptr)
+        return false;
+    auto type = obj->get("type")->to<Util::JsonValue>();
+    return type != nullptr && type->isString() && type->getString() == "header_union";
+}
+}  // namespace
+
 cstring ActionConverter::jsonAssignment(const IR::Type* type, bool inParser) {
     if (!inParser && type->is<IR::Type_Varbits>())
         return "assign_VL";
@@ -41,9 +62,52 @@ cstring ActionConverter::jsonAssignment(const IR::Type* type, bool inParser) {
         return "assign";
 }
 
+size_t ActionConverter::fuseUnionCopy(const IR::Vector<IR::StatOrDecl>* body, size_t start,
+                                      Util::JsonArray* result) {
+    auto first = body->at(start)->to<IR::AssignmentStatement>();
+    auto left = first->left->to<IR::Member>();
+    auto right = first->right->to<IR::Member>();
+    if (left == nullptr || right == nullptr ||
+        !isFixedReference(left->expr) || !isFixedReference(right->expr))
+        return 0;
+    auto type = ctxt->typeMap->getType(left->expr, true)->to<IR::Type_HeaderUnion>();
+    if (type == nullptr ||
+        !P4::TypeMap::equivalent(type, ctxt->typeMap->getType(right->expr, true)))
+        return 0;
+
+    // The copies of the headers may come in any order, but nothing else
+    // may be interleaved with them.
+    std::set<cstring> copied;
+    size_t count = 0;
+    for (; count < type->fields.size() && start + count < body->size(); count++) {
+        auto assign = body->at(start + count)->to<IR::AssignmentStatement>();
+        auto l = assign == nullptr ? nullptr : assign->left->to<IR::Member>();
+        auto r = assign == nullptr ? nullptr : assign->right->to<IR::Member>();
+        if (l == nullptr || r == nullptr || l->member != r->member ||
+            !l->expr->equiv(*left->expr) || !r->expr->equiv(*right->expr) ||
+            !copied.insert(l->member.name).second)
+            return 0;
+    }
+    if (copied.size() != type->fields.size())
+        return 0;
+
+    auto dest = ctxt->conv->convertLeftValue(left->expr);
+    auto src = ctxt->conv->convert(right->expr);
+    if (!isHeaderUnion(dest) || !isHeaderUnion(src))
+        return 0;
+    LOG3("Fusing " << count << " header copies into a copy of " << left->expr);
+    auto primitive = mkPrimitive("assign_union", result);
+    auto parameters = mkParameters(primitive);
+    primitive->emplace_non_null("source_info", first->sourceInfoJsonObj());
+    parameters->append(dest);
+    parameters->append(src);
+    return count;
+}
+
 void ActionConverter::convertActionBody(const IR::Vector<IR::StatOrDecl>* body,
                                         Util::JsonArray* result) {
-    for (auto s : *body) {
+    for (size_t i = 0; i < body->size(); i++) {
+        auto s = body->at(i);
         // TODO(jafingerhut) - add line/col at all individual cases below,
         // or perhaps it can be done as a common case above or below
         // for all of them?
@@ -60,6 +124,10 @@ void ActionConverter::convertActionBody(const IR::Vector<IR::StatOrDecl>* body,
             primitive->emplace_non_null("source_info", s->sourceInfoJsonObj());
             break;
         } else if (s->is<IR::AssignmentStatement>()) {
+            if (auto fused = fuseUnionCopy(body, i, result)) {
+                i += fused - 1;
+                continue;
+            }
             const IR::Expression* l, *r;
             auto assign = s->to<IR::AssignmentStatement>();
             l = assign->left;
@@ -30,6 +30,12 @@ class ActionConverter : public Inspector {
     void convertActionParams(const IR::ParameterList *parameters,
                              Util::JsonArray* params);
     cstring jsonAssignment(const IR::Type* type, bool inParser);
+    /// The midend splits the copy of a header union into one copy per
+    /// header; if 'body' contains such copies starting at 'start' this
+    /// emits a single assign_union primitive and returns the number of
+    /// statements replaced, otherwise it returns 0.
+    size_t fuseUnionCopy(const IR::Vector<IR::StatOrDecl>* body, size_t start,
+                         Util::JsonArray* result);
     void postorder(const IR::P4Action* action) override;
 
  public:
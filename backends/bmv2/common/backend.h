@@ -17,8 +17,10 @@ limitations under the License.
 #ifndef BACKENDS_BMV2_COMMON_BACKEND_H_
 #define BACKENDS_BMV2_COMMON_BACKEND_H_
 
+#include <sstream>
 #include "controlFlowGraph.h"
 #include "expression.h"
+#include "fragmentCache.h"
 #include "frontends/common/model.h"
 #include "frontends/p4/coreLibrary.h"
 #include "helpers.h"
@@ -34,7 +36,7 @@ limitations under the License.
 #include "midend/convertEnums.h"
 #include "midend/actionSynthesis.h"
 #include "midend/removeLeftSlices.h"
-#include "sharedActionSelectorCheck.h"
+#include "midend/specializeActions.h"
 #include "options.h"
 
 namespace BMV2 {
@@ -55,6 +57,8 @@ class Backend {
     P4::P4CoreLibrary&               corelib;
     BMV2::JsonObjects*               json;
     ExpressionConverter*             conv;
+    ExpressionPeephole*              peephole;
+    FragmentCache*                   cache = nullptr;
     const IR::ToplevelBlock*         toplevel;
 
  public:
@@ -62,8 +66,15 @@ class Backend {
             P4::ConvertEnums::EnumMapping* enumMap) :
         options(options),
         refMap(refMap), typeMap(typeMap), enumMap(enumMap),
-        corelib(P4::P4CoreLibrary::instance), json(new BMV2::JsonObjects()) {
+        corelib(P4::P4CoreLibrary::instance), json(new BMV2::JsonObjects()),
+        peephole(options.expressionPeephole ? new ExpressionPeephole() : nullptr) {
         refMap->setIsV1(options.isv1());
+        if (!options.jsonCache.isNullOrEmpty()) {
+            std::stringstream settings;
+            settings << options.compilerVersion << " externs " << options.emitExterns
+                     << " peephole " << options.expressionPeephole;
+            cache = new FragmentCache(options.jsonCache, settings.str());
+        }
         }
     void serialize(std::ostream& out) const { json->toplevel->serialize(out); }
     virtual void convert(const IR::ToplevelBlock* block) = 0;
@@ -0,0 +1,260 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "coalesceScalars.h"
+
+namespace BMV2 {
+
+namespace {
+// Appends the statements in 'statement' to 'result', flattening blocks.
+// Returns false if the statements are not straight-line code.
+bool flatten(const IR::StatOrDecl* statement, IR::Vector<IR::StatOrDecl>& result) {
+    if (auto block = statement->to<IR::BlockStatement>()) {
+        bool linear = true;
+        for (auto c : block->components)
+            linear = flatten(c, result) && linear;
+        return linear;
+    }
+    result.push_back(statement);
+    return statement->is<IR::AssignmentStatement>() ||
+           statement->is<IR::MethodCallStatement>() ||
+           statement->is<IR::EmptyStatement>() ||
+           statement->is<IR::Declaration>();
+}
+}  // namespace
+
+Visitor::profile_t CoalesceScalars::init_apply(const IR::Node* node) {
+    variables.clear();
+    pinned.clear();
+    uses.clear();
+    structure->scalarVariableFields.clear();
+    return Inspector::init_apply(node);
+}
+
+const std::set<const IR::Declaration_Variable*>&
+CoalesceScalars::usedBy(const IR::Node* node) {
+    auto it = uses.find(node);
+    if (it != uses.end())
+        return it->second;
+    auto& result = uses[node];
+    forAllMatching<IR::PathExpression>(node, [this, &result](const IR::PathExpression* pe) {
+        auto decl = refMap->getDeclaration(pe->path, true);
+        if (auto var = decl->to<IR::Declaration_Variable>()) {
+            result.insert(var);
+        } else if (decl->is<IR::P4Table>() || decl->is<IR::P4Action>()) {
+            // the table keys and the actions run by the table
+            auto& inner = usedBy(decl->getNode());
+            result.insert(inner.begin(), inner.end());
+        }
+    });
+    return result;
+}
+
+bool CoalesceScalars::isAssignment(const IR::StatOrDecl* statement,
+                                   const IR::Declaration_Variable* decl) const {
+    auto assign = statement->to<IR::AssignmentStatement>();
+    if (assign == nullptr)
+        return false;
+    auto left = assign->left->to<IR::PathExpression>();
+    if (left == nullptr || refMap->getDeclaration(left->path, true) != decl)
+        return false;
+    bool reads = false;
+    forAllMatching<IR::PathExpression>(assign->right, [&](const IR::PathExpression* pe) {
+        if (refMap->getDeclaration(pe->path, true) == decl)
+            reads = true;
+    });
+    return !reads;
+}
+
+std::set<const IR::Declaration_Variable*>
+CoalesceScalars::referenced(const IR::Node* node) const {
+    std::set<const IR::Declaration_Variable*> result;
+    forAllMatching<IR::PathExpression>(node, [this, &result](const IR::PathExpression* pe) {
+        if (auto var = refMap->getDeclaration(pe->path, true)->to<IR::Declaration_Variable>())
+            result.insert(var);
+    });
+    return result;
+}
+
+void CoalesceScalars::assignedFirst(const IR::Vector<IR::StatOrDecl>& statements,
+                                    const std::set<const IR::Declaration_Variable*>& declared) {
+    std::set<const IR::Declaration_Variable*> seen;
+    for (auto s : statements) {
+        if (s->is<IR::Declaration>())
+            continue;
+        for (auto var : usedBy(s)) {
+            if (!declared.count(var) || !seen.insert(var).second)
+                continue;
+            auto it = variables.find(var);
+            if (it != variables.end())
+                it->second->assignedFirst = isAssignment(s, var);
+        }
+    }
+}
+
+bool CoalesceScalars::interfere(const Variable* a, const Variable* b) const {
+    if (a->action != nullptr && a->action == b->action)
+        return a->first <= b->last && b->first <= a->last;
+    if (a->action != nullptr && b->action != nullptr)
+        // only one action runs at a time
+        return false;
+    if (a->action == nullptr && b->action == nullptr)
+        return a->block == b->block;
+    auto local = a->action != nullptr ? a : b;
+    auto global = a->action != nullptr ? b : a;
+    // an action declared at the top level may be invoked by any control
+    return local->block == global->block ||
+           (local->block == nullptr && global->block->is<IR::P4Control>());
+}
+
+void CoalesceScalars::postorder(const IR::Declaration_Variable* decl) {
+    auto type = typeMap->getType(decl, true);
+    if (!type->is<IR::Type_Bits>() && !type->is<IR::Type_Boolean>() &&
+        !type->is<IR::Type_Error>())
+        return;
+    auto var = new Variable();
+    var->decl = decl;
+    var->type = type->toString();
+    var->action = findContext<IR::P4Action>();
+    if (auto control = findContext<IR::P4Control>())
+        var->block = control;
+    else
+        var->block = findContext<IR::P4Parser>();
+    variables.emplace(decl, var);
+}
+
+void CoalesceScalars::postorder(const IR::ListExpression* list) {
+    forAllMatching<IR::PathExpression>(list, [this](const IR::PathExpression* pe) {
+        if (auto var = refMap->getDeclaration(pe->path, true)->to<IR::Declaration_Variable>())
+            pinned.insert(var);
+    });
+}
+
+void CoalesceScalars::actionLifetimes(const IR::P4Action* action) {
+    IR::Vector<IR::StatOrDecl> statements;
+    bool linear = flatten(action->body, statements);
+    std::set<const IR::Declaration_Variable*> locals;
+    for (auto it : variables)
+        if (it.second->action == action)
+            locals.insert(it.first);
+    if (locals.empty())
+        return;
+    if (!linear) {
+        // the variables live while the action runs
+        for (auto var : locals)
+            variables.at(var)->last = statements.size();
+        return;
+    }
+    for (unsigned i = 0; i < statements.size(); i++) {
+        for (auto var : usedBy(statements.at(i))) {
+            auto it = variables.find(var);
+            if (it == variables.end() || it->second->action != action)
+                continue;
+            auto v = it->second;
+            if (!v->used)
+                v->first = i;
+            v->last = i;
+            v->used = true;
+        }
+    }
+    assignedFirst(statements, locals);
+}
+
+void CoalesceScalars::postorder(const IR::P4Action* action) {
+    // the actions of a control are handled with the control
+    if (findContext<IR::P4Control>() == nullptr)
+        actionLifetimes(action);
+}
+
+void CoalesceScalars::postorder(const IR::P4Control* control) {
+    // The frontend moves the declarations of the actions to the
+    // control: a variable of the control which only one action
+    // uses belongs to that action.
+    std::map<const IR::Declaration_Variable*, std::set<const IR::P4Action*>> users;
+    auto outside = referenced(control->body);
+    for (auto l : control->controlLocals) {
+        if (auto action = l->to<IR::P4Action>()) {
+            for (auto var : referenced(action))
+                users[var].insert(action);
+        } else if (!l->is<IR::Declaration_Variable>()) {
+            auto vars = referenced(l->getNode());
+            outside.insert(vars.begin(), vars.end());
+        }
+    }
+
+    IR::Vector<IR::StatOrDecl> statements;
+    std::set<const IR::Declaration_Variable*> locals;
+    for (auto l : control->controlLocals) {
+        auto decl = l->to<IR::Declaration_Variable>();
+        if (decl == nullptr)
+            continue;
+        auto it = variables.find(decl);
+        if (it != variables.end() && !outside.count(decl) && users[decl].size() == 1) {
+            it->second->action = *users[decl].begin();
+            continue;
+        }
+        statements.push_back(decl);
+        locals.insert(decl);
+    }
+    for (auto l : control->controlLocals)
+        if (auto action = l->to<IR::P4Action>())
+            actionLifetimes(action);
+    flatten(control->body, statements);
+    assignedFirst(statements, locals);
+}
+
+void CoalesceScalars::end_apply(const IR::Node*) {
+    for (auto var : pinned) {
+        auto it = variables.find(var);
+        if (it != variables.end())
+            it->second->pinned = true;
+    }
+
+    // variables sharing each field, for each type
+    std::map<cstring, std::vector<std::vector<const Variable*>>> fields;
+    unsigned shared = 0;
+    for (auto it : variables) {
+        auto v = it.second;
+        cstring field = v->decl->name.name;
+        if (v->assignedFirst && !v->pinned) {
+            bool placed = false;
+            auto& candidates = fields[v->type];
+            for (auto& f : candidates) {
+                bool free = true;
+                for (auto other : f) {
+                    if (interfere(v, other)) {
+                        free = false;
+                        break;
+                    }
+                }
+                if (free) {
+                    field = f.front()->decl->name.name;
+                    f.push_back(v);
+                    placed = true;
+                    shared++;
+                    break;
+                }
+            }
+            if (!placed)
+                candidates.push_back({v});
+        }
+        LOG2("Scalar " << v->decl->name << " stored in " << field);
+        structure->scalarVariableFields.emplace(v->decl, field);
+    }
+    LOG1(shared << " of " << variables.size() << " scalar variables share a field");
+}
+
+}  // namespace BMV2
@@ -0,0 +1,96 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef BACKENDS_BMV2_COMMON_COALESCESCALARS_H_
+#define BACKENDS_BMV2_COMMON_COALESCESCALARS_H_
+
+#include "ir/ir.h"
+#include "frontends/p4/typeMap.h"
+#include "frontends/common/resolveReferences/referenceMap.h"
+#include "programStructure.h"
+
+namespace BMV2 {
+
+/**
+Assigns the scalar local variables (bit<>, bool and error), which are
+all fields of the scalars metadata object, to shared fields, like a
+register allocator: two variables of the same type share a field if
+their lifetimes never overlap.  The lifetimes are approximated as follows:
+- a variable declared in an action only lives while the action runs;
+  if the action body is straight-line code it only lives from the first
+  to the last statement using it.  The frontend moves these declarations
+  to the control, so a variable of a control used by a single action,
+  and nowhere else, is treated as a variable of that action
+- a variable declared in a parser or control lives while the parser or
+  control runs, including the actions it invokes.
+bmv2 zero-initializes the scalars for each packet; to preserve this
+only variables that are always assigned before they are used may share
+a field.  Variables used in lists (which may become field lists read
+at the end of the pipeline) never share a field.
+
+The result is stored in ProgramStructure::scalarVariableFields.
+*/
+class CoalesceScalars : public Inspector {
+    P4::ReferenceMap* refMap;
+    P4::TypeMap*      typeMap;
+    ProgramStructure* structure;
+
+    struct Variable {
+        const IR::Declaration_Variable* decl;
+        cstring             type;
+        const IR::Node*     block;   // enclosing parser or control, may be null
+        const IR::P4Action* action;  // enclosing action, may be null
+        // statements of the action using the variable
+        unsigned first = 0, last = 0;
+        bool used = false;
+        bool assignedFirst = false;  // always assigned before being used
+        bool pinned = false;
+    };
+    ordered_map<const IR::Declaration_Variable*, Variable*> variables;
+    std::set<const IR::Declaration_Variable*> pinned;
+    // Variables used by each table or action, including the actions of a table
+    std::map<const IR::Node*, std::set<const IR::Declaration_Variable*>> uses;
+
+    const std::set<const IR::Declaration_Variable*>& usedBy(const IR::Node* node);
+    /// The variables referred to by 'node', not following tables and actions
+    std::set<const IR::Declaration_Variable*> referenced(const IR::Node* node) const;
+    bool isAssignment(const IR::StatOrDecl* statement,
+                      const IR::Declaration_Variable* decl) const;
+    /// Decides which of the variables 'declared' are assigned before
+    /// being used by 'statements'
+    void assignedFirst(const IR::Vector<IR::StatOrDecl>& statements,
+                       const std::set<const IR::Declaration_Variable*>& declared);
+    void actionLifetimes(const IR::P4Action* action);
+    bool interfere(const Variable* a, const Variable* b) const;
+
+ public:
+    CoalesceScalars(P4::ReferenceMap* refMap, P4::TypeMap* typeMap,
+                    ProgramStructure* structure) :
+            refMap(refMap), typeMap(typeMap), structure(structure)
+    { CHECK_NULL(refMap); CHECK_NULL(typeMap); CHECK_NULL(structure);
+      setName("CoalesceScalars"); }
+
+    Visitor::profile_t init_apply(const IR::Node* node) override;
+    void postorder(const IR::Declaration_Variable* decl) override;
+    void postorder(const IR::ListExpression* list) override;
+    void postorder(const IR::P4Action* action) override;
+    void postorder(const IR::P4Control* control) override;
+    void end_apply(const IR::Node* node) override;
+};
+
+}  // namespace BMV2
+
+#endif  /* BACKENDS_BMV2_COMMON_COALESCESCALARS_H_ */
@@ -16,7 +16,7 @@ limitations under the License.
 
 #include "control.h"
 #include "extern.h"
-#include "sharedActionSelectorCheck.h"
+#include "tableEntries.h"
 
 namespace BMV2 {
 
@@ -25,117 +25,22 @@ void ControlConverter::convertTableEntries(const IR::P4Table *table,
     auto entriesList = table->getEntries();
     if (entriesList == nullptr) return;
 
-    auto entries = mkArrayField(jsonTable, "entries");
-    int entryPriority = 1;  // default priority is defined by index position
-    for (auto e : entriesList->entries) {
-        // TODO(jafingerhut) - add line/col here?
-        auto entry = new Util::JsonObject();
-
-        auto keyset = e->getKeys();
-        auto matchKeys = mkArrayField(entry, "match_key");
-        int keyIndex = 0;
-        for (auto k : keyset->components) {
-            auto key = new Util::JsonObject();
-            auto tableKey = table->getKey()->keyElements.at(keyIndex);
-            auto keyWidth = tableKey->expression->type->width_bits();
-            auto k8 = ROUNDUP(keyWidth, 8);
-            auto matchType = getKeyMatchType(tableKey);
-            key->emplace("match_type", matchType);
-            if (matchType == corelib.exactMatch.name) {
-                if (k->is<IR::Constant>())
-                    key->emplace("key", stringRepr(k->to<IR::Constant>()->value, k8));
-                else if (k->is<IR::BoolLiteral>())
-                    // booleans are converted to ints
-                    key->emplace("key", stringRepr(k->to<IR::BoolLiteral>()->value ? 1 : 0, k8));
-                else
-                    ::error("%1% unsupported exact key expression", k);
-            } else if (matchType == corelib.ternaryMatch.name) {
-                if (k->is<IR::Mask>()) {
-                    auto km = k->to<IR::Mask>();
-                    key->emplace("key", stringRepr(km->left->to<IR::Constant>()->value, k8));
-                    key->emplace("mask", stringRepr(km->right->to<IR::Constant>()->value, k8));
-                } else if (k->is<IR::Constant>()) {
-                    key->emplace("key", stringRepr(k->to<IR::Constant>()->value, k8));
-                    key->emplace("mask", stringRepr(Util::mask(keyWidth), k8));
-                } else if (k->is<IR::DefaultExpression>()) {
-                    key->emplace("key", stringRepr(0, k8));
-                    key->emplace("mask", stringRepr(0, k8));
-                } else {
-                    ::error("%1% unsupported ternary key expression", k);
-                }
-            } else if (matchType == corelib.lpmMatch.name) {
-                if (k->is<IR::Mask>()) {
-                    auto km = k->to<IR::Mask>();
-                    key->emplace("key", stringRepr(km->left->to<IR::Constant>()->value, k8));
-                    auto trailing_zeros = [](unsigned long n) { return n ? __builtin_ctzl(n) : 0; };
-                    auto count_ones = [](unsigned long n) { return n ? __builtin_popcountl(n) : 0;};
-                    unsigned long mask = km->right->to<IR::Constant>()->value.get_ui();
-                    auto len = trailing_zeros(mask);
-                    if (len + count_ones(mask) != keyWidth)  // any remaining 0s in the prefix?
-                        ::error("%1% invalid mask for LPM key", k);
-                    else
-                        key->emplace("prefix_length", keyWidth - len);
-                } else if (k->is<IR::Constant>()) {
-                    key->emplace("key", stringRepr(k->to<IR::Constant>()->value, k8));
-                    key->emplace("prefix_length", keyWidth);
-                } else if (k->is<IR::DefaultExpression>()) {
-                    key->emplace("key", stringRepr(0, k8));
-                    key->emplace("prefix_length", 0);
-                } else {
-                    ::error("%1% unsupported LPM key expression", k);
-                }
-            } else if (matchType == "range") {
-                if (k->is<IR::Range>()) {
-                    auto kr = k->to<IR::Range>();
-                    key->emplace("start", stringRepr(kr->left->to<IR::Constant>()->value, k8));
-                    key->emplace("end", stringRepr(kr->right->to<IR::Constant>()->value, k8));
-                } else if (k->is<IR::DefaultExpression>()) {
-                    key->emplace("start", stringRepr(0, k8));
-                    key->emplace("end", stringRepr((1 << keyWidth)-1, k8));  // 2^N -1
-                } else {
-                    ::error("%1% invalid range key expression", k);
-                }
-            } else {
-                ::error("unkown key match type '%1%' for key %2%", matchType, k);
-            }
-            matchKeys->append(key);
-            keyIndex++;
-        }
-
-        auto action = new Util::JsonObject();
-        auto actionRef = e->getAction();
-        if (!actionRef->is<IR::MethodCallExpression>())
-            ::error("%1%: invalid action in entries list", actionRef);
-        auto actionCall = actionRef->to<IR::MethodCallExpression>();
-        auto method = actionCall->method->to<IR::PathExpression>()->path;
-        auto decl = ctxt->refMap->getDeclaration(method, true);
-        auto actionDecl = decl->to<IR::P4Action>();
-        unsigned id = get(ctxt->structure->ids, actionDecl);
-        action->emplace("action_id", id);
-        auto actionData = mkArrayField(action, "action_data");
-        for (auto arg : *actionCall->arguments) {
-            actionData->append(stringRepr(arg->expression->to<IR::Constant>()->value, 0));
-        }
-        entry->emplace("action_entry", action);
-
-        auto priorityAnnotation = e->getAnnotation("priority");
-        if (priorityAnnotation != nullptr) {
-            if (priorityAnnotation->expr.size() > 1)
-                ::error("invalid priority value %1%", priorityAnnotation->expr);
-            auto priValue = priorityAnnotation->expr.front();
-            if (!priValue->is<IR::Constant>())
-                ::error("invalid priority value %1%. must be constant", priorityAnnotation->expr);
-            entry->emplace("priority", priValue->to<IR::Constant>()->value);
-        } else {
-            entry->emplace("priority", entryPriority);
-        }
-        entryPriority += 1;
-
-        entries->append(entry);
+    // The entries are written when the JSON is serialized; only the
+    // information they need from the program is computed here.
+    std::vector<TableEntries::Key> keys;
+    for (auto ke : table->getKey()->keyElements)
+        keys.push_back({ getKeyMatchType(ke), ke->expression->type->width_bits() });
+    std::map<cstring, unsigned> actionIds;
+    for (auto a : table->getActionList()->actionList) {
+        auto decl = ctxt->refMap->getDeclaration(a->getPath(), true);
+        if (auto action = decl->to<IR::P4Action>())
+            actionIds.emplace(a->getName().name, get(ctxt->structure->ids, action));
     }
+    auto entries = new TableEntries(entriesList, keys, actionIds);
+    entries->check();
+    jsonTable->emplace("entries", entries);
 }
 
-
 /**
     Computes the type of the key based on the declaration in the path.
 
@@ -162,8 +67,7 @@ bool
 ControlConverter::handleTableImplementation(const IR::Property* implementation,
                                             const IR::Key* key,
                                             Util::JsonObject* table,
-                                            Util::JsonArray* action_profiles,
-                                            BMV2::SharedActionSelectorCheck&) {
+                                            Util::JsonArray* action_profiles) {
     if (implementation == nullptr) {
         table->emplace("type", "simple");
         return true;
@@ -190,7 +94,7 @@ ControlConverter::handleTableImplementation(const IR::Property* implementation,
         auto ecc = cc->to<P4::ExternConstructorCall>();
         auto implementationType = ecc->type;
         auto arguments = ecc->cce->arguments;
-        apname = implementation->controlPlaneName(ctxt->refMap->newName("action_profile"));
+        apname = implementation->controlPlaneName(ctxt->newName("action_profile"));
         action_profile = new Util::JsonObject();
         action_profiles->append(action_profile);
         action_profile->emplace("name", apname);
@@ -282,8 +186,7 @@ ControlConverter::handleTableImplementation(const IR::Property* implementation,
 
 Util::IJson*
 ControlConverter::convertTable(const CFG::TableNode* node,
-                               Util::JsonArray* action_profiles,
-                               BMV2::SharedActionSelectorCheck& selector_check) {
+                               Util::JsonArray* action_profiles) {
     auto table = node->table;
     LOG3("Processing " << dbp(table));
     auto result = new Util::JsonObject();
@@ -366,26 +269,9 @@ ControlConverter::convertTable(const CFG::TableNode* node,
     ctxt->conv->simpleExpressionsOnly = false;
 
     auto impl = table->properties->getProperty("implementation");
-    bool simple = handleTableImplementation(impl, key, result, action_profiles, selector_check);
-
-    unsigned size = 0;
-    auto sz = table->properties->getProperty("size");
-    if (sz != nullptr) {
-        if (sz->value->is<IR::ExpressionValue>()) {
-            auto expr = sz->value->to<IR::ExpressionValue>()->expression;
-            if (!expr->is<IR::Constant>()) {
-                ::error("%1% must be a constant", sz);
-                size = 0;
-            } else {
-                size = expr->to<IR::Constant>()->asInt();
-            }
-        } else {
-            ::error("%1%: expected a number", sz);
-        }
-    }
-    if (size == 0)
-        size = BMV2::TableAttributes::defaultTableSize;
+    bool simple = handleTableImplementation(impl, key, result, action_profiles);
 
+    unsigned size = BMV2::TableAttributes::tableSize(table, true);
     result->emplace("max_size", size);
     auto ctrs = table->properties->getProperty("counters");
     if (ctrs != nullptr) {
@@ -426,15 +312,7 @@ ControlConverter::convertTable(const CFG::TableNode* node,
                     ::error("%1%: expected an instance", decl->getNode());
                     return result;
                 }
-                cstring ctrname = decl->controlPlaneName();
-                auto it = ctxt->structure->directCounterMap.find(ctrname);
-                LOG3("Looking up " << ctrname);
-                if (it != ctxt->structure->directCounterMap.end()) {
-                   ::error("%1%: Direct counters cannot be attached to multiple tables %2% and %3%",
-                           decl, it->second, table);
-                   return result;
-                }
-                ctxt->structure->directCounterMap.emplace(ctrname, table);
+                // DiscoverStructure has bound the counter to the table
             } else {
                 ::error("%1%: expected a counter", ctrs);
             }
@@ -487,8 +365,7 @@ ControlConverter::convertTable(const CFG::TableNode* node,
                     ::error("%1%: expected an instance", decl->getNode());
                     return result;
                 }
-                ctxt->structure->directMeterMap.setTable(decl, table);
-                ctxt->structure->directMeterMap.setSize(decl, size);
+                // DiscoverStructure has bound the meter to the table
                 BUG_CHECK(decl->is<IR::Declaration_Instance>(),
                           "%1%: expected an instance", decl->getNode());
                 cstring name = decl->controlPlaneName();
@@ -538,7 +415,7 @@ ControlConverter::convertTable(const CFG::TableNode* node,
     CFG::Node* defaultLabelDestination = nullptr;  // if the "default" label is executed
     // Note: the "default" label is not the default_action.
     bool hitMiss = false;
-    for (auto s : node->successors.edges) {
+    for (auto s : node->successors) {
         if (s->isUnconditional())
             nextDestination = s->endpoint;
         else if (s->isBool())
@@ -561,7 +438,7 @@ ControlConverter::convertTable(const CFG::TableNode* node,
     }
 
     std::set<cstring> labelsDone;
-    for (auto s : node->successors.edges) {
+    for (auto s : node->successors) {
         cstring label;
         if (s->isBool()) {
             label = s->getBool() ? "__HIT__" : "__MISS__";
@@ -654,7 +531,7 @@ Util::IJson* ControlConverter::convertIf(const CFG::IfNode* node, cstring prefix
     auto j = ctxt->conv->convert(node->statement->condition, true, false);
     CHECK_NULL(j);
     result->emplace("expression", j);
-    for (auto e : node->successors.edges) {
+    for (auto e : node->successors) {
         Util::IJson* dest = nodeName(e->endpoint);
         cstring label = Util::toString(e->getBool());
         label += "_next";
@@ -670,7 +547,7 @@ bool ControlConverter::preorder(const IR::P4Control* cont) {
     result->emplace("id", nextId("control"));
     result->emplace_non_null("source_info", cont->sourceInfoJsonObj());
 
-    auto cfg = new CFG();
+    auto cfg = new CFG(name);
     cfg->build(cont, ctxt->refMap, ctxt->typeMap);
     bool success = cfg->checkImplementable();
     if (!success)
@@ -680,7 +557,7 @@ bool ControlConverter::preorder(const IR::P4Control* cont) {
         result->emplace("init_table", Util::JsonValue::null);
     } else {
         BUG_CHECK(cfg->entryPoint->successors.size() == 1, "Expected 1 start node for %1%", cont);
-        auto start = (*(cfg->entryPoint->successors.edges.begin()))->endpoint;
+        auto start = cfg->entryPoint->successors.front()->endpoint;
         result->emplace("init_table", nodeName(start));
     }
 
@@ -689,10 +566,6 @@ bool ControlConverter::preorder(const IR::P4Control* cont) {
     auto conditionals = mkArrayField(result, "conditionals");
     ctxt->action_profiles = action_profiles;
 
-    SharedActionSelectorCheck selector_check(ctxt->refMap, ctxt->typeMap);
-    cont->apply(selector_check);
-    ctxt->selector_check = &selector_check;
-
     std::set<const IR::P4Table*> done;
 
     // Tables are created prior to the other local declarations
@@ -705,7 +578,7 @@ bool ControlConverter::preorder(const IR::P4Control* cont) {
                 // the CFG is implementable.
                 continue;
             done.emplace(tn->table);
-            auto j = convertTable(tn, action_profiles, selector_check);
+            auto j = convertTable(tn, action_profiles);
             if (::errorCount() > 0)
                 return false;
             tables->append(j);
@@ -27,7 +27,6 @@ limitations under the License.
 #include "midend/convertEnums.h"
 #include "expression.h"
 #include "helpers.h"
-#include "sharedActionSelectorCheck.h"
 
 namespace BMV2 {
 
@@ -38,14 +37,12 @@ class ControlConverter : public Inspector {
 
  protected:
     Util::IJson* convertTable(const CFG::TableNode* node,
-                              Util::JsonArray* action_profiles,
-                              BMV2::SharedActionSelectorCheck& selector_check);
+                              Util::JsonArray* action_profiles);
     void convertTableEntries(const IR::P4Table *table, Util::JsonObject *jsonTable);
     cstring getKeyMatchType(const IR::KeyElement *ke);
     /// Return 'true' if the table is 'simple'
     bool handleTableImplementation(const IR::Property* implementation, const IR::Key* key,
-                                   Util::JsonObject* table, Util::JsonArray* action_profiles,
-                                   BMV2::SharedActionSelectorCheck& selector_check);
+                                   Util::JsonObject* table, Util::JsonArray* action_profiles);
     Util::IJson* convertIf(const CFG::IfNode* node, cstring prefix);
 
  public:
@@ -16,6 +16,8 @@ limitations under the License.
 
 #include "controlFlowGraph.h"
 
+#include <unordered_map>
+
 #include "ir/ir.h"
 #include "frontends/p4/fromv1.0/v1model.h"
 #include "frontends/p4/typeMap.h"
@@ -28,8 +30,6 @@ limitations under the License.
 
 namespace BMV2 {
 
-unsigned CFG::Node::crtId = 0;
-
 void CFG::EdgeSet::dbprint(std::ostream& out) const {
     for (auto s : edges)
         out << " " << s;
@@ -52,8 +52,11 @@ void CFG::Edge::dbprint(std::ostream& out) const {
     }
 }
 
-void CFG::Node::dbprint(std::ostream& out) const
-{ out << name << " =>" << successors; }
+void CFG::Node::dbprint(std::ostream& out) const {
+    out << name << " =>";
+    for (auto s : successors)
+        out << " " << s;
+}
 
 void CFG::dbprint(std::ostream& out, CFG::Node* node, std::set<CFG::Node*> &done) const {
     if (done.find(node) != done.end())
@@ -80,11 +83,11 @@ void CFG::dbprint(std::ostream& out) const {
 
 void CFG::Node::computeSuccessors() {
     for (auto e : predecessors.edges)
-        e->getNode()->successors.emplace(e->clone(this));
+        e->getNode()->successors.push_back(e->clone(this));
 }
 
-bool CFG::dfs(Node* node, std::set<Node*> &visited,
-              std::set<const IR::P4Table*> &stack) const {
+bool CFG::dfs(Node* node, std::vector<bool> &visited,
+              std::unordered_set<const IR::P4Table*> &stack) const {
     const IR::P4Table* table = nullptr;
     if (node->is<TableNode>()) {
         table = node->to<TableNode>()->table;
@@ -95,60 +98,36 @@ bool CFG::dfs(Node* node, std::set<Node*> &visited,
             return false;
         }
     }
-    if (visited.find(node) != visited.end())
+    if (visited[node->id])
         return true;
     if (table != nullptr)
         stack.emplace(table);
-    for (auto e : node->successors.edges) {
+    for (auto e : node->successors) {
         bool success = dfs(e->endpoint, visited, stack);
         if (!success) return false;
     }
     if (table != nullptr)
         stack.erase(table);
-    visited.emplace(node);
-    return true;
-}
-
-bool CFG::EdgeSet::isDestination(const CFG::Node* node) const {
-    for (auto e : edges) {
-        auto dest = e->endpoint;
-        if (dest == node) return true;
-        auto td = dest->to<TableNode>();
-        auto tn = node->to<TableNode>();
-        if (td != nullptr && tn != nullptr &&
-            td->table == tn->table)
-            return true;
-    }
-
-    return false;
-}
-
-bool CFG::EdgeSet::checkSame(const CFG::EdgeSet& other) const {
-    if (size() != other.size())
-        return false;
-    // This algorithm is quadratic, but we expect these graphs to be very small
-    for (auto e : edges) {
-        if (!other.isDestination(e->endpoint))
-            return false;
-    }
-    for (auto e : other.edges) {
-        if (!isDestination(e->endpoint))
-            return false;
-    }
+    visited[node->id] = true;
     return true;
 }
 
 // We check whether a table always jumps to the same destination,
 // even if it appears multiple times in the CFG.
-bool CFG::checkMergeable(std::set<TableNode*> nodes) const {
-    TableNode* first = nullptr;
+bool CFG::checkMergeable(const std::vector<TableNode*>& nodes,
+                         const std::vector<unsigned>& same) const {
+    auto destinations = [&same](const TableNode* tn) {
+        std::unordered_set<unsigned> result;
+        for (auto e : tn->successors)
+            result.emplace(same[e->endpoint->id]);
+        return result;
+    };
+    auto first = nodes.front();
+    auto expected = destinations(first);
     for (auto tn : nodes) {
-        if (first == nullptr) {
-            first = tn;
+        if (tn == first)
             continue;
-        }
-        bool same = first->successors.checkSame(tn->successors);
-        if (!same) {
+        if (tn->successors.size() != first->successors.size() || destinations(tn) != expected) {
             ::error("Program is not supported by this target, because "
                     "table %1% has multiple successors", tn->table);
             return false;
@@ -158,22 +137,28 @@ bool CFG::checkMergeable(std::set<TableNode*> nodes) const {
 }
 
 bool CFG::checkImplementable() const {
-    std::set<Node*> visited;
-    std::set<const IR::P4Table*> stack;
+    std::vector<bool> visited(allNodes.size());
+    std::unordered_set<const IR::P4Table*> stack;
     for (auto n : allNodes) {
         bool success = dfs(n, visited, stack);
         if (!success) return false;
     }
 
-    std::map<const IR::P4Table*, std::set<TableNode*>> tableNodes;
+    // Nodes which refer to the same table are the same destination.
+    std::vector<unsigned> same(allNodes.size());
+    std::unordered_map<const IR::P4Table*, unsigned> firstNode;
+    ordered_map<const IR::P4Table*, std::vector<TableNode*>> tableNodes;
     for (auto n : allNodes) {
-        if (auto tn = n->to<TableNode>())
-            tableNodes[tn->table].emplace(tn);
+        same[n->id] = n->id;
+        if (auto tn = n->to<TableNode>()) {
+            same[n->id] = firstNode.emplace(tn->table, n->id).first->second;
+            tableNodes[tn->table].push_back(tn);
+        }
     }
     for (auto it : tableNodes) {
         if (it.second.size() == 1)
             continue;
-        bool success = checkMergeable(it.second);
+        bool success = checkMergeable(it.second, same);
         if (!success)
             return false;
     }
@@ -184,8 +169,8 @@ bool CFG::checkImplementable() const {
 namespace {
 class CFGBuilder : public Inspector {
     CFG*                    cfg;
-    /// predecessors of current CFG node
-    const CFG::EdgeSet*     live;
+    /// predecessors of current CFG node; owned by the builder
+    CFG::EdgeSet*           live;
     P4::ReferenceMap*       refMap;
     P4::TypeMap*            typeMap;
 
@@ -235,11 +220,12 @@ class CFGBuilder : public Inspector {
         // If branch
         live = new CFG::EdgeSet(new CFG::Edge(node, true));
         visit(statement->ifTrue);
-        auto afterTrue = live;
-        if (afterTrue == nullptr)
+        auto result = live;
+        if (result == nullptr)
             // error
             return false;
-        auto result = new CFG::EdgeSet(afterTrue);
+        // 'result' is not shared, so the else edges are added to it in place;
+        // copying it would make deeply nested conditionals quadratic.
         // Else branch
         if (statement->ifFalse != nullptr) {
             live = new CFG::EdgeSet(new CFG::Edge(node, false));
@@ -293,7 +279,7 @@ class CFGBuilder : public Inspector {
  public:
     CFGBuilder(CFG* cfg, P4::ReferenceMap* refMap, P4::TypeMap* typeMap) :
             cfg(cfg), live(nullptr), refMap(refMap), typeMap(typeMap) {}
-    const CFG::EdgeSet* run(const IR::Statement* body, const CFG::EdgeSet* predecessors) {
+    const CFG::EdgeSet* run(const IR::Statement* body, CFG::EdgeSet* predecessors) {
         CHECK_NULL(body); CHECK_NULL(predecessors);
         live = predecessors;
         body->apply(*this);
@@ -17,6 +17,8 @@ limitations under the License.
 #ifndef BACKENDS_BMV2_COMMON_CONTROLFLOWGRAPH_H_
 #define BACKENDS_BMV2_COMMON_CONTROLFLOWGRAPH_H_
 
+#include <unordered_set>
+#include <vector>
 #include "ir/ir.h"
 #include "frontends/p4/typeMap.h"
 #include "frontends/common/resolveReferences/referenceMap.h"
@@ -44,31 +46,22 @@ class CFG final : public IHasDbPrint {
         void dbprint(std::ostream& out) const;
         void emplace(CFG::Edge* edge) { edges.emplace(edge); }
         size_t size() const { return edges.size(); }
-        /// Checks whether the two edge sets represent the same set of
-        /// nodes.  Importantly, two TableNodes are equivalent if they
-        /// refer to the same table (pointer equality is not enough).
-        bool checkSame(const EdgeSet& other) const;
-        /// Check if this destination appears in this edgeset.
-        /// Importantly, a TableNode is a destination if it points to
-        /// the same table as an existin destination (pointer equality
-        /// is not enough).
-        bool isDestination(const CFG::Node* destination) const;
     };
 
     class Node : public IHasDbPrint {
      protected:
         friend class CFG;
 
-        static unsigned crtId;
         EdgeSet         predecessors;
-        explicit Node(cstring name) : id(crtId++), name(name) {}
-        Node() : id(crtId++), name("node_" + Util::toString(id)) {}
+        Node(unsigned id, cstring name) : id(id), name(name) {}
         virtual ~Node() {}
 
      public:
-        const unsigned id;
-        const cstring  name;
-        EdgeSet        successors;
+        /// Index of the node in CFG::allNodes
+        const unsigned      id;
+        const cstring       name;
+        /// Computed from the predecessors once the graph is built
+        std::vector<Edge*>  successors;
 
         void dbprint(std::ostream& out) const;
         void addPredecessors(const EdgeSet* set);
@@ -84,21 +77,22 @@ class CFG final : public IHasDbPrint {
      public:
         const IR::P4Table* table;
         const IR::Expression*      invocation;
-        explicit TableNode(const IR::P4Table* table, const IR::Expression* invocation)
-        : Node(table->controlPlaneName()), table(table), invocation(invocation)
+        TableNode(unsigned id, const IR::P4Table* table, const IR::Expression* invocation)
+        : Node(id, table->controlPlaneName()), table(table), invocation(invocation)
         { CHECK_NULL(table); CHECK_NULL(invocation); }
     };
 
     class IfNode final : public Node {
      public:
         const IR::IfStatement* statement;
-        explicit IfNode(const IR::IfStatement* statement) : statement(statement)
+        IfNode(unsigned id, cstring name, const IR::IfStatement* statement) :
+                Node(id, name), statement(statement)
         { CHECK_NULL(statement); }
     };
 
     class DummyNode final : public Node {
      public:
-        explicit DummyNode(cstring name) : Node(name) {}
+        DummyNode(unsigned id, cstring name) : Node(id, name) {}
     };
 
  protected:
@@ -149,22 +143,30 @@ class CFG final : public IHasDbPrint {
     Node* entryPoint;
     Node* exitPoint;
     const IR::P4Control* container;
-    ordered_set<Node*> allNodes;
+    /// Indexed by the node ids
+    std::vector<Node*> allNodes;
 
-    CFG() : entryPoint(nullptr), exitPoint(nullptr), container(nullptr) {}
+    /// The conditionals are named after 'prefix'; BMv2 requires their
+    /// names to be unique across all controls.
+    explicit CFG(cstring prefix = "") :
+            entryPoint(nullptr), exitPoint(nullptr), container(nullptr), prefix(prefix) {}
     Node* makeNode(const IR::P4Table* table, const IR::Expression* invocation) {
-        auto result = new TableNode(table, invocation);
-        allNodes.emplace(result);
+        auto result = new TableNode(allNodes.size(), table, invocation);
+        allNodes.push_back(result);
         return result;
     }
     Node* makeNode(const IR::IfStatement* statement) {
-        auto result = new IfNode(statement);
-        allNodes.emplace(result);
+        unsigned id = allNodes.size();
+        cstring name = "node_" + Util::toString(id);
+        if (!prefix.isNullOrEmpty())
+            name = prefix + "." + name;
+        auto result = new IfNode(id, name, statement);
+        allNodes.push_back(result);
         return result;
     }
     Node* makeNode(cstring name) {
-        auto result = new DummyNode(name);
-        allNodes.emplace(result);
+        auto result = new DummyNode(allNodes.size(), name);
+        allNodes.push_back(result);
         return result;
     }
     void build(const IR::P4Control* cc,
@@ -182,14 +184,19 @@ class CFG final : public IHasDbPrint {
     bool checkImplementable() const;
 
  private:
-    bool dfs(Node* node, std::set<Node*> &visited,
-             std::set<const IR::P4Table*> &stack) const;
+    cstring prefix;
+
+    bool dfs(Node* node, std::vector<bool> &visited,
+             std::unordered_set<const IR::P4Table*> &stack) const;
     /// This is a set of table nodes that all represent the same
     /// table.  Check whether they could logically be merged into
     /// a single table node from a control-flow point of view.
-    /// This requires their successor edgesets to be "compatible" with
-    /// each other.  This is a constraint specific to BMv2.
-    bool checkMergeable(std::set<TableNode*> nodes) const;
+    /// This requires their successors to be the same nodes, where
+    /// two TableNodes are the same if they refer to the same table;
+    /// 'same' maps each node id to the id of the first node which is
+    /// the same.  This is a constraint specific to BMv2.
+    bool checkMergeable(const std::vector<TableNode*>& nodes,
+                        const std::vector<unsigned>& same) const;
 };
 
 }  // namespace BMV2
@@ -540,6 +540,13 @@ void ExpressionConverter::postorder(const IR::Operation_Unary* expression)  {
     e->emplace("right", fixLocal(r));
 }
 
+cstring ExpressionConverter::scalarField(const IR::Declaration_Variable* var) const {
+    auto it = structure->scalarVariableFields.find(var);
+    if (it == structure->scalarVariableFields.end())
+        return var->name.name;
+    return it->second;
+}
+
 void ExpressionConverter::postorder(const IR::PathExpression* expression)  {
     // This is useful for action bodies mostly
     auto decl = refMap->getDeclaration(expression->path, true);
@@ -575,7 +582,7 @@ void ExpressionConverter::postorder(const IR::PathExpression* expression)  {
             result->emplace("type", "field");
             auto e = mkArrayField(result, "value");
             e->append(scalarsName);
-            e->append(var->name);
+            e->append(scalarField(var));
         } else if (type->is<IR::Type_Varbits>()) {
             // varbits are synthesized in separate metadata instances
             // with a single field each, where the field is named
@@ -597,7 +604,7 @@ void ExpressionConverter::postorder(const IR::PathExpression* expression)  {
             r->emplace("type", "field");
             auto f = mkArrayField(r, "value");
             f->append(scalarsName);
-            f->append(var->name);
+            f->append(scalarField(var));
         } else if (type->is<IR::Type_Stack>()) {
             result->emplace("type", "header_stack");
             result->emplace("value", var->name);
@@ -605,7 +612,7 @@ void ExpressionConverter::postorder(const IR::PathExpression* expression)  {
             result->emplace("type", "field");
             auto f = mkArrayField(result, "value");
             f->append(scalarsName);
-            f->append(var->name);
+            f->append(scalarField(var));
         } else {
             BUG("%1%: type not yet handled", type);
         }
@@ -649,6 +656,22 @@ ExpressionConverter::convert(const IR::Expression* e, bool doFixup, bool wrap, b
         result = obj;
     }
 
+    if (peephole != nullptr) {
+        ExpressionPeephole::LeafWidths widths;
+        forAllMatching<IR::Expression>(expr, [this, &widths](const IR::Expression* leaf) {
+            if (!leaf->is<IR::Member>() && !leaf->is<IR::PathExpression>())
+                return;
+            auto type = typeMap->getType(leaf);
+            auto tb = type == nullptr ? nullptr : type->to<IR::Type_Bits>();
+            if (tb == nullptr || tb->isSigned)
+                return;
+            auto json = ::get(map, leaf);
+            if (json != nullptr)
+                widths.emplace(json, tb->size);
+        });
+        result = peephole->optimize(result, widths);
+    }
+
     std::set<cstring> to_wrap({"expression", "stack_field"});
 
     // This is weird, but that's how it is: expression and stack_field must be wrapped in
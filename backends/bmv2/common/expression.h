@@ -26,6 +26,7 @@ limitations under the License.
 #include "frontends/p4/enumInstance.h"
 #include "frontends/p4/methodInstance.h"
 #include "frontends/p4/typeMap.h"
+#include "expressionPeephole.h"
 #include "programStructure.h"
 
 namespace BMV2 {
@@ -74,7 +75,11 @@ class ExpressionConverter : public Inspector {
     /// If this is 'true' we fail to convert complex expressions.
     /// This is used for table key expressions, for example.
     bool simpleExpressionsOnly;
+    /// If not null the converted expressions are simplified by the peephole.
+    ExpressionPeephole* peephole = nullptr;
 
+    /// The field of the scalars metadata object holding a scalar variable
+    cstring scalarField(const IR::Declaration_Variable* var) const;
     /// Non-null if the expression refers to a parameter from the enclosing control
     const IR::Parameter* enclosingParamReference(const IR::Expression* expression);
 
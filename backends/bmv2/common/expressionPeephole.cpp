@@ -0,0 +1,301 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <algorithm>
+
+#include "expressionPeephole.h"
+#include "helpers.h"
+
+#ifdef MULTITHREAD
+#include <mutex>
+#endif  // MULTITHREAD
+
+namespace BMV2 {
+
+namespace {
+bool isType(const Util::IJson* json, const char* type) {
+    auto obj = json == nullptr ? nullptr : json->to<Util::JsonObject>();
+    if (obj == nullptr)
+        return false;
+    auto t = obj->get("type");
+    if (t == nullptr)
+        return false;
+    auto v = t->to<Util::JsonValue>();
+    return v != nullptr && v->isString() && v->getString() == type;
+}
+
+// The operation of an expression node, or nullptr
+const Util::JsonObject* operation(const Util::IJson* json) {
+    if (!isType(json, "expression"))
+        return nullptr;
+    auto value = json->to<Util::JsonObject>()->get("value");
+    auto op = value == nullptr ? nullptr : value->to<Util::JsonObject>();
+    if (op == nullptr || op->get("op") == nullptr)
+        return nullptr;
+    return op;
+}
+
+cstring opName(const Util::JsonObject* operation) {
+    auto v = operation->get("op")->to<Util::JsonValue>();
+    if (v == nullptr || !v->isString())
+        return "";
+    return v->getString();
+}
+
+bool constant(const Util::IJson* json, mpz_class& value) {
+    if (!isType(json, "hexstr"))
+        return false;
+    auto obj = json->to<Util::JsonObject>();
+    if (obj->get("bitwidth") != nullptr)
+        return false;
+    auto v = obj->get("value")->to<Util::JsonValue>();
+    if (v == nullptr || !v->isString())
+        return false;
+    std::string s = v->getString().c_str();
+    bool negative = !s.empty() && s[0] == '-';
+    if (negative)
+        s = s.substr(1);
+    if (s.compare(0, 2, "0x") != 0 || value.set_str(s.substr(2), 16) != 0)
+        return false;
+    if (negative)
+        value = -value;
+    return true;
+}
+
+bool boolean(const Util::IJson* json, bool& value) {
+    if (!isType(json, "bool"))
+        return false;
+    auto v = json->to<Util::JsonObject>()->get("value")->to<Util::JsonValue>();
+    if (v == nullptr || !v->isBool())
+        return false;
+    value = v->getBool();
+    return true;
+}
+
+Util::JsonObject* hexstr(mpz_class value) {
+    auto result = new Util::JsonObject();
+    result->emplace("type", "hexstr");
+    result->emplace("value", stringRepr(value));
+    return result;
+}
+
+Util::JsonObject* boolean(bool value) {
+    auto result = new Util::JsonObject();
+    result->emplace("type", "bool");
+    result->emplace("value", value);
+    return result;
+}
+
+unsigned bitLength(const mpz_class& value) {
+    return mpz_sizeinbase(value.get_mpz_t(), 2);
+}
+
+#ifdef MULTITHREAD
+std::mutex statsLock;
+#endif  // MULTITHREAD
+}  // namespace
+
+Util::IJson* ExpressionPeephole::optimize(Util::IJson* json, const LeafWidths& widths) {
+    Stats local;
+    auto result = simplify(json, widths, local);
+#ifdef MULTITHREAD
+    std::lock_guard<std::mutex> acquire(statsLock);
+#endif
+    stats.casts += local.casts;
+    stats.masks += local.masks;
+    stats.folded += local.folded;
+    stats.wrappers += local.wrappers;
+    return result;
+}
+
+void ExpressionPeephole::report() const {
+    LOG1("Expression peephole removed " << stats.casts << " casts, " << stats.masks <<
+         " masks, " << stats.folded << " constant operations and " << stats.wrappers <<
+         " wrappers");
+}
+
+Util::IJson* ExpressionPeephole::simplify(Util::IJson* json, const LeafWidths& widths,
+                                          Stats& local) const {
+    if (!isType(json, "expression"))
+        return json;
+    auto value = json->to<Util::JsonObject>()->get("value");
+    auto op = value == nullptr ? nullptr : value->to<Util::JsonObject>();
+    if (op == nullptr)
+        return json;
+    if (op->get("op") == nullptr) {
+        // an expression node wrapping another node
+        local.wrappers++;
+        return simplify(value, widths, local);
+    }
+
+    cstring name = opName(op);
+    auto left = op->get("left");
+    auto right = op->get("right");
+    auto cond = op->get("cond");
+    auto l = left == nullptr ? nullptr : simplify(left, widths, local);
+    auto r = right == nullptr ? nullptr : simplify(right, widths, local);
+    auto c = cond == nullptr ? nullptr : simplify(cond, widths, local);
+
+    if (name == "d2b" || name == "b2d") {
+        if (auto inner = operation(r)) {
+            cstring innerName = opName(inner);
+            auto operand = inner->get("right");
+            if (name == "d2b" && innerName == "b2d") {
+                local.casts += 2;
+                return operand;
+            }
+            if (name == "b2d" && innerName == "d2b") {
+                int width = bound(operand, widths);
+                if (width >= 0 && width <= 1) {
+                    local.casts += 2;
+                    return operand;
+                }
+            }
+        }
+    }
+
+    bool b;
+    if (name == "?" && boolean(c, b)) {
+        local.folded++;
+        return b ? l : r;
+    }
+    if (auto folded = fold(name, l, r)) {
+        local.folded++;
+        return folded;
+    }
+
+    if (name == "&") {
+        mpz_class mask;
+        for (auto operands : { std::make_pair(l, r), std::make_pair(r, l) }) {
+            if (!constant(operands.second, mask) || mask <= 0 || (mask & (mask + 1)) != 0)
+                continue;
+            int width = bound(operands.first, widths);
+            if (width >= 0 && static_cast<unsigned>(width) <= bitLength(mask)) {
+                local.masks++;
+                return operands.first;
+            }
+        }
+    }
+
+    if (l == left && r == right && c == cond)
+        return json;
+    auto e = new Util::JsonObject();
+    for (auto it : *op) {
+        auto v = it.second;
+        if (it.first == "left")
+            v = l;
+        else if (it.first == "right")
+            v = r;
+        else if (it.first == "cond")
+            v = c;
+        e->emplace(it.first, v);
+    }
+    auto result = new Util::JsonObject();
+    result->emplace("type", "expression");
+    result->emplace("value", e);
+    return result;
+}
+
+Util::IJson* ExpressionPeephole::fold(cstring op, const Util::IJson* left,
+                                      const Util::IJson* right) const {
+    mpz_class a, b;
+    if (constant(left, a) && constant(right, b)) {
+        if (a < 0 || b < 0)
+            return nullptr;
+        mpz_class v;
+        if (op == "+")
+            v = a + b;
+        else if (op == "-")
+            v = a - b;
+        else if (op == "*")
+            v = a * b;
+        else if (op == "&")
+            v = a & b;
+        else if (op == "|")
+            v = a | b;
+        else if (op == "^")
+            v = a ^ b;
+        else if (op == "<<" && b < 4096)
+            v = a << b.get_ui();
+        else if (op == ">>")
+            v = b < 4096 ? mpz_class(a >> b.get_ui()) : mpz_class(0);
+        else if (op == "==")
+            return boolean(a == b);
+        else if (op == "!=")
+            return boolean(a != b);
+        else if (op == "<")
+            return boolean(a < b);
+        else if (op == "<=")
+            return boolean(a <= b);
+        else if (op == ">")
+            return boolean(a > b);
+        else if (op == ">=")
+            return boolean(a >= b);
+        else
+            return nullptr;
+        if (v < 0)
+            return nullptr;
+        return hexstr(v);
+    }
+
+    bool x, y;
+    if (op == "d2b" && constant(right, b))
+        return boolean(b != 0);
+    if (op == "b2d" && boolean(right, y))
+        return hexstr(y ? 1 : 0);
+    if (op == "not" && boolean(right, y))
+        return boolean(!y);
+    if (boolean(left, x) && boolean(right, y)) {
+        if (op == "and")
+            return boolean(x && y);
+        if (op == "or")
+            return boolean(x || y);
+    }
+    return nullptr;
+}
+
+int ExpressionPeephole::bound(const Util::IJson* json, const LeafWidths& widths) const {
+    auto it = widths.find(json);
+    if (it != widths.end())
+        return it->second;
+    mpz_class v;
+    if (constant(json, v))
+        return v < 0 ? -1 : bitLength(v);
+    auto op = operation(json);
+    if (op == nullptr)
+        return -1;
+    cstring name = opName(op);
+    if (name == "b2d")
+        return 1;
+    int l = op->get("left") == nullptr ? -1 : bound(op->get("left"), widths);
+    int r = op->get("right") == nullptr ? -1 : bound(op->get("right"), widths);
+    if (name == "&") {
+        if (l < 0)
+            return r;
+        if (r < 0)
+            return l;
+        return std::min(l, r);
+    }
+    if (name == "|" || name == "^" || name == "?")
+        return l < 0 || r < 0 ? -1 : std::max(l, r);
+    if (name == ">>")
+        return l;
+    if (name == "usat_cast" && constant(op->get("right"), v))
+        return v.get_si();
+    return -1;
+}
+
+}  // namespace BMV2
@@ -0,0 +1,65 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef BACKENDS_BMV2_COMMON_EXPRESSIONPEEPHOLE_H_
+#define BACKENDS_BMV2_COMMON_EXPRESSIONPEEPHOLE_H_
+
+#include <map>
+#include "lib/gmputil.h"
+#include "lib/json.h"
+
+namespace BMV2 {
+
+/**
+Simplifies the JSON expression trees produced by the ExpressionConverter;
+simple_switch evaluates every node of these trees for each packet:
+- d2b(b2d(e)) becomes e; b2d(d2b(e)) becomes e if e is 0 or 1
+- e & mask is replaced by e if mask is 2^k-1 and e fits in k bits
+- operations on constants are folded
+- expression nodes wrapping another expression node or a leaf are
+  replaced by their contents.
+The JSON nodes may be shared by several trees, so they are never changed:
+new nodes are created instead.
+*/
+class ExpressionPeephole {
+ public:
+    struct Stats {
+        unsigned casts = 0;
+        unsigned masks = 0;
+        unsigned folded = 0;
+        unsigned wrappers = 0;
+    };
+
+    /// Upper bound of the width of the values of leaf nodes (fields,
+    /// variables, action parameters); only unsigned values are included.
+    using LeafWidths = std::map<const Util::IJson*, unsigned>;
+
+    Util::IJson* optimize(Util::IJson* json, const LeafWidths& widths);
+    /// Total number of nodes removed
+    Stats getStats() const { return stats; }
+    void report() const;
+
+ private:
+    Stats stats;
+
+    Util::IJson* simplify(Util::IJson* json, const LeafWidths& widths, Stats& local) const;
+    Util::IJson* fold(cstring op, const Util::IJson* left, const Util::IJson* right) const;
+    int bound(const Util::IJson* json, const LeafWidths& widths) const;
+};
+
+}  // namespace BMV2
+
+#endif  /* BACKENDS_BMV2_COMMON_EXPRESSIONPEEPHOLE_H_ */
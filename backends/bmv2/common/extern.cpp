@@ -149,7 +149,7 @@ ExternConverter::createCalculation(ConversionContext* ctxt,
                                    cstring algo, const IR::Expression* fields,
                                    Util::JsonArray* calculations, bool withPayload,
                                    const IR::Node* sourcePositionNode = nullptr) {
-    cstring calcName = ctxt->refMap->newName("calc_");
+    cstring calcName = ctxt->newName("calc_");
     auto calc = new Util::JsonObject();
     calc->emplace("name", calcName);
     calc->emplace("id", nextId("calculations"));
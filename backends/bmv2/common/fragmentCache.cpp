@@ -0,0 +1,118 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <sys/stat.h>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include "fragmentCache.h"
+#include "frontends/p4/toP4/toP4.h"
+
+namespace BMV2 {
+
+namespace {
+// 64-bit FNV-1a; unlike std::hash it does not depend on the build of the compiler
+uint64_t fnv1a(const std::string& data, uint64_t hash = 14695981039346656037ULL) {
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string toP4(const IR::Node* node) {
+    std::stringstream stream;
+    P4::ToP4 toP4(&stream, false);
+    node->apply(toP4);
+    return stream.str();
+}
+}  // namespace
+
+FragmentCache::FragmentCache(cstring directory, cstring settings) :
+        directory(directory), settings(settings) {
+    // the directory may exist already
+    (void)mkdir(directory.c_str(), 0777);
+}
+
+uint64_t FragmentCache::environment(const ConversionContext* ctxt) const {
+    auto it = environments.find(ctxt);
+    if (it != environments.end())
+        return it->second;
+    std::stringstream env;
+    env << settings << std::endl;
+    for (auto obj : ctxt->toplevel->getProgram()->declarations)
+        if (!obj->is<IR::P4Parser>() && !obj->is<IR::P4Control>())
+            env << toP4(obj);
+    // the tables refer to the actions by id
+    for (auto a : ctxt->structure->ids)
+        env << a.first->controlPlaneName() << " " << a.second << std::endl;
+    auto result = fnv1a(env.str());
+    environments.emplace(ctxt, result);
+    return result;
+}
+
+cstring FragmentCache::fileName(cstring key) const {
+    return directory + "/" + key + ".json";
+}
+
+cstring FragmentCache::key(const ConversionContext* ctxt, const IR::Node* part,
+                           unsigned index) const {
+    std::stringstream text;
+    text << index << std::endl;
+    // The JSON records the source positions and fragments of the nodes of
+    // the part, which change with the code before them and with their text.
+    forAllMatching<IR::Node>(part, [&text](const IR::Node* node) {
+        if (auto position = node->sourceInfoJsonObj())
+            text << position->toString() << std::endl;
+    });
+    text << toP4(part);
+    forAllMatching<IR::Declaration_Variable>(part, [ctxt, &text](
+            const IR::Declaration_Variable* decl) {
+        auto it = ctxt->structure->scalarVariableFields.find(decl);
+        if (it != ctxt->structure->scalarVariableFields.end())
+            text << decl->name << " " << it->second << std::endl;
+    });
+    std::stringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << fnv1a(text.str(), environment(ctxt));
+    return key.str();
+}
+
+Util::JsonObject* FragmentCache::load(cstring key) const {
+    cstring file = fileName(key);
+    std::ifstream in(file.c_str());
+    if (!in)
+        return nullptr;
+    try {
+        return Util::IJson::parse(in)->to<Util::JsonObject>();
+    } catch (std::logic_error& e) {
+        ::warning("%1%: ignoring malformed cached JSON: %2%", file, e.what());
+        return nullptr;
+    }
+}
+
+void FragmentCache::store(cstring key, const Util::JsonObject* fragment) const {
+    // write to a temporary file first, so that readers never see partial files
+    cstring file = fileName(key);
+    cstring temp = file + ".tmp";
+    std::ofstream out(temp.c_str());
+    fragment->serialize(out);
+    out.close();
+    if (!out || std::rename(temp.c_str(), file.c_str()) != 0)
+        ::warning("%1%: could not write the JSON cache", file);
+}
+
+}  // namespace BMV2
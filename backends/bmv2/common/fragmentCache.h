@@ -0,0 +1,63 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef BACKENDS_BMV2_COMMON_FRAGMENTCACHE_H_
+#define BACKENDS_BMV2_COMMON_FRAGMENTCACHE_H_
+
+#include <cstdint>
+#include <map>
+#include "ir/ir.h"
+#include "lib/json.h"
+#include "helpers.h"
+
+namespace BMV2 {
+
+/**
+Stores the JSON of the parts of a program (parsers, controls and
+deparsers, see ParallelConversion) in a directory, so that a later
+compilation can reuse the JSON of the parts that did not change.
+
+The key of a part is a hash of the source positions and fragments of
+its nodes, of its P4 code after the midend, of the declarations outside
+parsers and controls, of the action ids, of the scalar fields of its
+variables and of the compiler settings.  The fragments use ids local to the part,
+which are renumbered when they are merged into the program, so the
+cached JSON stays valid when other parts change.
+*/
+class FragmentCache {
+    cstring directory;
+    cstring settings;
+    // hash of everything outside the parts which the parts depend on
+    mutable std::map<const ConversionContext*, uint64_t> environments;
+
+    uint64_t environment(const ConversionContext* ctxt) const;
+    cstring fileName(cstring key) const;
+
+ public:
+    /// 'settings' describes the options affecting the generated JSON.
+    FragmentCache(cstring directory, cstring settings);
+
+    /// 'index' is the position of the part in the conversion order; the
+    /// same control may be converted twice, e.g. as ingress and egress.
+    cstring key(const ConversionContext* ctxt, const IR::Node* part, unsigned index) const;
+    /// The fragment stored under 'key', or nullptr.
+    Util::JsonObject* load(cstring key) const;
+    void store(cstring key, const Util::JsonObject* fragment) const;
+};
+
+}  // namespace BMV2
+
+#endif  /* BACKENDS_BMV2_COMMON_FRAGMENTCACHE_H_ */
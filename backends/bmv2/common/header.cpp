@@ -304,16 +304,29 @@ Visitor::profile_t HeaderConverter::init_apply(const IR::Node* node) {
                 continue;  // already seen
             visitedHeaders.emplace(headerName);
             addHeaderType(hdrType);
-        } else if (type->is<IR::Type_Bits>()) {
-            auto tb = type->to<IR::Type_Bits>();
-            addHeaderField(scalarsTypeName, v->name.name, tb->size, tb->isSigned);
-            scalars_width += tb->size;
-        } else if (type->is<IR::Type_Boolean>()) {
-            addHeaderField(scalarsTypeName, v->name.name, boolWidth, false);
-            scalars_width += boolWidth;
-        } else if (type->is<IR::Type_Error>()) {
-            addHeaderField(scalarsTypeName, v->name.name, errorWidth, 0);
-            scalars_width += errorWidth;
+        } else if (type->is<IR::Type_Bits>() || type->is<IR::Type_Boolean>() ||
+                   type->is<IR::Type_Error>()) {
+            // Variables which never live at the same time share a field
+            cstring field = v->name.name;
+            auto it = ctxt->structure->scalarVariableFields.find(v);
+            if (it != ctxt->structure->scalarVariableFields.end())
+                field = it->second;
+            unsigned width;
+            bool isSigned = false;
+            if (auto tb = type->to<IR::Type_Bits>()) {
+                width = tb->size;
+                isSigned = tb->isSigned;
+            } else if (type->is<IR::Type_Boolean>()) {
+                width = boolWidth;
+            } else {
+                width = errorWidth;
+            }
+            if (!scalarFields.insert(field).second) {
+                coalesced_width += width;
+                continue;
+            }
+            addHeaderField(scalarsTypeName, field, width, isSigned);
+            scalars_width += width;
         } else if (type->is<IR::Type_Set>()) {
             continue;  // ignore: this is probably a value_set
         } else {
@@ -334,6 +347,8 @@ void HeaderConverter::end_apply(const IR::Node*) {
         cstring name = ctxt->refMap->newName("_padding");
         addHeaderField(scalarsTypeName, name, 8-padding, false);
     }
+    LOG1("scalars_width " << scalars_width + coalesced_width << " bits, " <<
+         scalars_width << " after coalescing variables");
 }
 
 /**
@@ -39,6 +39,8 @@ class HeaderConverter : public Inspector {
     const unsigned       boolWidth = 1;    // convert booleans to 1-bit integers
     const unsigned       errorWidth = 32;  // convert errors to 32-bit integers
     unsigned             scalars_width = 0;
+    unsigned             coalesced_width = 0;  // variables sharing scalar fields
+    std::set<cstring>    scalarFields;
 
  protected:
     Util::JsonArray* pushNewArray(Util::JsonArray* parent);
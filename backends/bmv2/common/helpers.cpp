@@ -16,6 +16,10 @@ limitations under the License.
 
 #include "helpers.h"
 
+#ifdef MULTITHREAD
+#include <mutex>
+#endif  // MULTITHREAD
+
 namespace BMV2 {
 
 /// constant definition for bmv2
@@ -27,6 +31,27 @@ const unsigned TableAttributes::defaultTableSize = 1024;
 const cstring V1ModelProperties::jsonMetadataParameterName = "standard_metadata";
 const cstring V1ModelProperties::validField = "$valid$";
 
+unsigned TableAttributes::tableSize(const IR::P4Table* table, bool reportErrors) {
+    unsigned size = 0;
+    auto sz = table->properties->getProperty("size");
+    if (sz != nullptr) {
+        if (sz->value->is<IR::ExpressionValue>()) {
+            auto expr = sz->value->to<IR::ExpressionValue>()->expression;
+            if (!expr->is<IR::Constant>()) {
+                if (reportErrors)
+                    ::error("%1% must be a constant", sz);
+            } else {
+                size = expr->to<IR::Constant>()->asInt();
+            }
+        } else if (reportErrors) {
+            ::error("%1%: expected a number", sz);
+        }
+    }
+    if (size == 0)
+        size = defaultTableSize;
+    return size;
+}
+
 Util::IJson* nodeName(const CFG::Node* node) {
     if (node->name.isNullOrEmpty())
         return Util::JsonValue::null;
@@ -77,9 +102,83 @@ cstring stringRepr(mpz_class value, unsigned bytes) {
     return sign + "0x" + filler + r;
 }
 
-unsigned nextId(cstring group) {
+void writeHex(std::ostream& out, const mpz_class& value, unsigned bytes) {
+    if (mpz_sizeinbase(value.get_mpz_t(), 2) > 8 * sizeof(unsigned long)) {
+        out << stringRepr(value, bytes);
+        return;
+    }
+    static const char hexDigits[] = "0123456789abcdef";
+    char buffer[2 * sizeof(unsigned long)];
+    // the absolute value
+    unsigned long v = mpz_get_ui(value.get_mpz_t());
+    unsigned size = sizeof(buffer), start = size;
+    do {
+        buffer[--start] = hexDigits[v & 0xf];
+        v >>= 4;
+    } while (v != 0);
+    unsigned digits = size - start;
+    BUG_CHECK(bytes == 0 || digits <= bytes * 2,
+              "Cannot represent %1% on %2% bytes", value, bytes);
+    if (value < 0)
+        out << '-';
+    out << "0x";
+    for (unsigned i = digits; i < bytes * 2; i++)
+        out << '0';
+    out.write(buffer + start, digits);
+}
+
+namespace {
+// The innermost IdScope of the current thread
+#ifdef MULTITHREAD
+__thread IdScope* currentIdScope = nullptr;
+#else
+IdScope* currentIdScope = nullptr;
+#endif  // MULTITHREAD
+
+std::map<cstring, unsigned>& globalCounters() {
     static std::map<cstring, unsigned> counters;
-    return counters[group]++;
+    return counters;
+}
+
+#ifdef MULTITHREAD
+std::mutex idLock;
+#endif  // MULTITHREAD
+}  // namespace
+
+IdScope::IdScope() : enclosing(currentIdScope) {
+    currentIdScope = this;
+}
+
+IdScope::~IdScope() {
+    BUG_CHECK(currentIdScope == this, "IdScope destroyed out of order");
+    currentIdScope = enclosing;
+}
+
+unsigned nextId(cstring group) {
+    if (currentIdScope != nullptr)
+        return currentIdScope->next(group);
+    return reserveIds(group, 1);
+}
+
+unsigned reserveIds(cstring group, unsigned count) {
+    if (currentIdScope != nullptr)
+        return currentIdScope->reserve(group, count);
+#ifdef MULTITHREAD
+    std::lock_guard<std::mutex> acquire(idLock);
+#endif
+    auto& counter = globalCounters()[group];
+    unsigned first = counter;
+    counter += count;
+    return first;
+}
+
+cstring ConversionContext::newName(cstring base) {
+    if (generatedNames == nullptr)
+        return refMap->newName(base);
+    // '@' cannot appear in a P4 identifier
+    cstring name = base + "@" + Util::toString(generatedNames->size());
+    generatedNames->push_back(name);
+    return name;
 }
 
 }  // namespace BMV2
@@ -26,7 +26,6 @@ limitations under the License.
 #include "expression.h"
 #include "frontends/common/model.h"
 #include "programStructure.h"
-#include "sharedActionSelectorCheck.h"
 
 namespace BMV2 {
 
@@ -51,6 +50,10 @@ class MatchImplementation {
 class TableAttributes {
  public:
     static const unsigned defaultTableSize;
+    /// The max_size of @table: the value of its size property, or
+    /// defaultTableSize.  Invalid size properties are reported if
+    /// @reportErrors is set.
+    static unsigned tableSize(const IR::P4Table* table, bool reportErrors);
 };
 
 class V1ModelProperties {
@@ -82,13 +85,20 @@ struct ConversionContext {
 
     // for action profile conversion
     Util::JsonArray*                 action_profiles;
-    SharedActionSelectorCheck*       selector_check;
+    // if not null, newName returns provisional names and records them here
+    std::vector<cstring>*            generatedNames = nullptr;
 
     ConversionContext(P4::ReferenceMap* refMap, P4::TypeMap* typeMap,
                       const IR::ToplevelBlock* toplevel, ProgramStructure* structure,
                       ExpressionConverter* conv, JsonObjects* json) :
         refMap(refMap), typeMap(typeMap), toplevel(toplevel), structure(structure),
         conv(conv), json(json) { }
+
+    /// Same as refMap->newName.  While a part of the program is converted
+    /// (see ParallelConversion) the name is provisional: it is unique in
+    /// the part, and replaced by refMap->newName(base) when the part is
+    /// merged, so the names do not depend on the conversion order.
+    cstring newName(cstring base);
 };
 
 using BlockTypeMap = std::map<const IR::Block*, const IR::Type*>;
@@ -99,8 +109,38 @@ Util::JsonArray* mkParameters(Util::JsonObject* object);
 Util::JsonObject* mkPrimitive(cstring name, Util::JsonArray* appendTo);
 Util::JsonObject* mkPrimitive(cstring name);
 cstring stringRepr(mpz_class value, unsigned bytes = 0);
+/// Writes stringRepr(value, bytes) to 'out'; values which fit in a
+/// machine word are formatted without allocating memory.
+void writeHex(std::ostream& out, const mpz_class& value, unsigned bytes = 0);
 unsigned nextId(cstring group);
 
+/// While an IdScope is live, nextId() called by the same thread allocates
+/// ids from the counters of the scope instead of the global counters.
+/// This allows independent parts of the program to be converted on their
+/// own; the ids they allocated are made global using reserveIds().
+class IdScope {
+    std::map<cstring, unsigned> counters;
+    IdScope* enclosing;
+
+ public:
+    IdScope();
+    ~IdScope();
+    IdScope(const IdScope&) = delete;
+    IdScope& operator=(const IdScope&) = delete;
+
+    unsigned next(cstring group) { return counters[group]++; }
+    unsigned reserve(cstring group, unsigned count) {
+        unsigned first = counters[group];
+        counters[group] += count;
+        return first; }
+    /// Number of ids allocated in each group
+    const std::map<cstring, unsigned>& allocated() const { return counters; }
+};
+
+/// Allocates 'count' consecutive ids of 'group' from the innermost IdScope
+/// of the thread, or from the global counters; returns the first one.
+unsigned reserveIds(cstring group, unsigned count);
+
 }  // namespace BMV2
 
 #endif /* BACKENDS_BMV2_COMMON_HELPERS_H_ */
@@ -38,7 +38,8 @@ DirectMeterMap::DirectMeterInfo* DirectMeterMap::getInfo(const IR::IDeclaration*
  */
 void DirectMeterMap::setTable(const IR::IDeclaration* meter, const IR::P4Table* table) {
     auto info = getInfo(meter);
-    CHECK_NULL(info);
+    if (info == nullptr)
+        info = createInfo(meter);
     if (info->table != nullptr)
         ::error("%1%: Direct meters cannot be attached to multiple tables %2% and %3%",
                 meter, table, info->table);
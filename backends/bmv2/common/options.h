@@ -28,6 +28,12 @@ class BMV2Options : public CompilerOptions {
     bool emitExterns = false;
     // file to output to
     cstring outputFile = nullptr;
+    // simplify the expressions in the generated JSON
+    bool expressionPeephole = true;
+    // directory caching the JSON of parsers and controls
+    cstring jsonCache = nullptr;
+    // reorder, merge and simplify the table keys
+    bool tableKeyLayout = false;
 
     BMV2Options() {
         registerOption("--emit-externs", nullptr,
@@ -37,6 +43,17 @@ class BMV2Options : public CompilerOptions {
         registerOption("-o", "outfile",
                 [this](const char* arg) { outputFile = arg; return true; },
                 "Write output to outfile");
+        registerOption("--no-expression-peephole", nullptr,
+                [this](const char*) { expressionPeephole = false; return true; },
+                "[BMv2 back-end] Do not simplify the expressions in the generated JSON");
+        registerOption("--json-cache", "dir",
+                [this](const char* arg) { jsonCache = arg; return true; },
+                "[BMv2 back-end] Reuse the JSON of the parsers and controls which did not\n"
+                "change since the previous compilation; the JSON is cached in dir");
+        registerOption("--table-key-layout", nullptr,
+                [this](const char*) { tableKeyLayout = true; return true; },
+                "[BMv2 back-end] Reorder, merge and simplify the table keys to make the\n"
+                "lookups cheaper; this changes the control-plane API of the tables");
     }
 };
 
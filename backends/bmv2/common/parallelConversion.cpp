@@ -0,0 +1,279 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "config.h"
+#include "parallelConversion.h"
+
+#ifdef MULTITHREAD
+#include <exception>
+#include <thread>
+#if HAVE_LIBGC
+#define GC_THREADS
+#include <gc/gc.h>
+#endif  /* HAVE_LIBGC */
+#endif  // MULTITHREAD
+
+namespace BMV2 {
+
+namespace {
+// The arrays of the program JSON that a part may add to, with the group of their ids
+struct {
+    const char*                    name;
+    Util::JsonArray* JsonObjects::*array;
+    const char*                    group;
+} fragmentArrays[] = {
+    { "parsers", &JsonObjects::parsers, "parser" },
+    { "parse_vsets", &JsonObjects::parse_vsets, "parse_vsets" },
+    { "deparsers", &JsonObjects::deparsers, "deparser" },
+    { "pipelines", &JsonObjects::pipelines, "control" },
+    { "counter_arrays", &JsonObjects::counters, "counter_arrays" },
+    { "meter_arrays", &JsonObjects::meter_arrays, "meter_arrays" },
+    { "register_arrays", &JsonObjects::register_arrays, "register_arrays" },
+    { "calculations", &JsonObjects::calculations, "calculations" },
+    { "checksums", &JsonObjects::checksums, "checksums" },
+    { "field_lists", &JsonObjects::field_lists, "field_lists" },
+    { "learn_lists", &JsonObjects::learn_lists, "learn_lists" },
+    { "extern_instances", &JsonObjects::externs, "extern_instances" },
+};
+// Replaces the strings in 'json' which are keys of 'names'; returns the result.
+Util::IJson* renameStrings(Util::IJson* json, const std::map<cstring, cstring>& names) {
+    if (json == nullptr)
+        return json;
+    if (auto value = json->to<Util::JsonValue>()) {
+        if (value->isString()) {
+            auto it = names.find(value->getString());
+            if (it != names.end())
+                return new Util::JsonValue(it->second);
+        }
+    } else if (auto array = json->to<Util::JsonArray>()) {
+        for (auto& e : *array)
+            e = renameStrings(e, names);
+    } else if (auto object = json->to<Util::JsonObject>()) {
+        for (auto& f : *object)
+            f.second = renameStrings(f.second, names);
+    }
+    return json;
+}
+}  // namespace
+
+struct ParallelConversion::Fragment {
+    JsonObjects* json = new JsonObjects();
+    /// Number of ids allocated in each group while converting
+    std::map<cstring, unsigned> ids;
+    /// Names generated while converting
+    std::vector<cstring> names;
+};
+
+void ParallelConversion::convert(Fragment* fragment, Converter converter) const {
+    IdScope scope;
+    auto typeMap = ctxt->typeMap;
+#ifdef MULTITHREAD
+    typeMap = new P4::TypeMap(*typeMap);
+#endif
+    auto local = new ConversionContext(ctxt->refMap, typeMap, ctxt->toplevel,
+                                       ctxt->structure, newConverter(typeMap), fragment->json);
+    local->generatedNames = &fragment->names;
+    converter(local);
+    fragment->ids = scope.allocated();
+}
+
+bool ParallelConversion::load(Fragment* fragment, cstring key) const {
+    auto cached = cache->load(key);
+    if (cached == nullptr)
+        return false;
+    auto names = cached->get("names");
+    auto ids = cached->get("ids");
+    auto arrays = cached->get("arrays");
+    if (names == nullptr || !names->is<Util::JsonArray>() ||
+        ids == nullptr || !ids->is<Util::JsonObject>() ||
+        arrays == nullptr || !arrays->is<Util::JsonObject>())
+        return false;
+    // The names generated for the part are provisional (see newName).
+    for (auto n : *names->to<Util::JsonArray>()) {
+        auto name = n->to<Util::JsonValue>();
+        if (name == nullptr || !name->isString() || name->getString().find('@') == nullptr)
+            return false;
+    }
+    for (auto a : fragmentArrays) {
+        auto array = arrays->to<Util::JsonObject>()->get(a.name);
+        if (array == nullptr || !array->is<Util::JsonArray>())
+            return false;
+    }
+    for (auto group : *ids->to<Util::JsonObject>()) {
+        auto count = group.second->to<Util::JsonValue>();
+        if (count == nullptr || !count->isNumber())
+            return false;
+    }
+
+    for (auto a : fragmentArrays)
+        for (auto e : *arrays->to<Util::JsonObject>()->get(a.name)->to<Util::JsonArray>())
+            (fragment->json->*a.array)->append(e);
+    for (auto group : *ids->to<Util::JsonObject>())
+        fragment->ids.emplace(group.first, group.second->to<Util::JsonValue>()->getInt());
+    for (auto n : *names->to<Util::JsonArray>())
+        fragment->names.push_back(n->to<Util::JsonValue>()->getString());
+    return true;
+}
+
+void ParallelConversion::store(const Fragment* fragment, cstring key) const {
+    auto result = new Util::JsonObject();
+    auto names = mkArrayField(result, "names");
+    for (auto n : fragment->names)
+        names->append(n);
+    auto ids = new Util::JsonObject();
+    for (auto group : fragment->ids)
+        ids->emplace(group.first, group.second);
+    result->emplace("ids", ids);
+    auto arrays = new Util::JsonObject();
+    for (auto a : fragmentArrays)
+        arrays->emplace(a.name, fragment->json->*a.array);
+    result->emplace("arrays", arrays);
+    cache->store(key, result);
+}
+
+void ParallelConversion::merge(Fragment* fragment) {
+    // The final names are generated in the order of the parts.
+    std::map<cstring, cstring> names;
+    for (auto n : fragment->names) {
+        std::string provisional = n.c_str();
+        names.emplace(n, ctxt->refMap->newName(provisional.substr(0, provisional.rfind('@'))));
+    }
+    if (!names.empty())
+        for (auto a : fragmentArrays)
+            renameStrings(fragment->json->*a.array, names);
+
+    std::map<cstring, unsigned> base;
+    for (auto group : fragment->ids)
+        base.emplace(group.first, reserveIds(group.first, group.second));
+
+    std::map<cstring, unsigned> renumbered;
+    auto renumber = [&base, &renumbered](Util::JsonArray* array, cstring group) {
+        for (auto e : *array) {
+            auto obj = e->to<Util::JsonObject>();
+            CHECK_NULL(obj);
+            auto id = obj->get("id")->to<Util::JsonValue>();
+            CHECK_NULL(id);
+            (*obj)["id"] = new Util::JsonValue(base[group] + id->getInt());
+            renumbered[group]++;
+        }
+    };
+    auto nested = [&renumber](Util::JsonArray* array, cstring field, cstring group) {
+        for (auto e : *array) {
+            auto inner = e->to<Util::JsonObject>()->get(field);
+            if (inner != nullptr)
+                renumber(inner->to<Util::JsonArray>(), group);
+        }
+    };
+
+    auto from = fragment->json;
+    auto to = ctxt->json;
+    nested(from->parsers, "parse_states", "parse_states");
+    nested(from->pipelines, "tables", "tables");
+    nested(from->pipelines, "conditionals", "conditionals");
+    nested(from->pipelines, "action_profiles", "action_profiles");
+    for (auto a : fragmentArrays) {
+        renumber(from->*a.array, a.group);
+        for (auto e : *(from->*a.array))
+            (to->*a.array)->append(e);
+    }
+    for (auto group : fragment->ids)
+        BUG_CHECK(renumbered[group.first] == group.second,
+                  "%1%: %2% ids allocated, %3% renumbered",
+                  group.first, group.second, renumbered[group.first]);
+
+    for (auto e : *from->parsers) {
+        auto parser = e->to<Util::JsonObject>();
+        to->map_parser.emplace(parser->get("id")->to<Util::JsonValue>()->getInt(), parser);
+        for (auto s : *parser->get("parse_states")->to<Util::JsonArray>()) {
+            auto state = s->to<Util::JsonObject>();
+            to->map_parser_state.emplace(
+                state->get("id")->to<Util::JsonValue>()->getInt(), state);
+        }
+    }
+}
+
+void ParallelConversion::run() {
+    std::vector<Fragment*> fragments;
+    for (size_t i = 0; i < converters.size(); i++)
+        fragments.push_back(new Fragment());
+
+    // Cached fragments are loaded first, so that the names they use are
+    // not generated again for the other parts.
+    std::vector<cstring> keys(converters.size());
+    std::vector<bool> cached(converters.size(), false);
+    if (cache != nullptr) {
+        unsigned hits = 0;
+        for (size_t i = 0; i < converters.size(); i++) {
+            keys.at(i) = cache->key(ctxt, parts.at(i), i);
+            cached.at(i) = load(fragments.at(i), keys.at(i));
+            if (cached.at(i))
+                hits++;
+        }
+        LOG1("Reusing the cached JSON of " << hits << " of " << converters.size() << " parts");
+    }
+
+#ifdef MULTITHREAD
+#if HAVE_LIBGC
+    GC_allow_register_threads();
+#endif  /* HAVE_LIBGC */
+    std::vector<std::exception_ptr> failures(converters.size());
+    std::vector<std::thread> threads;
+    for (size_t n = 0; n < converters.size(); n++) {
+        size_t i = reverse ? converters.size() - 1 - n : n;
+        if (cached.at(i))
+            continue;
+        threads.emplace_back([this, i, &fragments, &failures]() {
+#if HAVE_LIBGC
+            struct GC_stack_base stack;
+            GC_get_stack_base(&stack);
+            GC_register_my_thread(&stack);
+#endif  /* HAVE_LIBGC */
+            try {
+                convert(fragments.at(i), converters.at(i));
+            } catch (...) {
+                failures.at(i) = std::current_exception();
+            }
+#if HAVE_LIBGC
+            GC_unregister_my_thread();
+#endif  /* HAVE_LIBGC */
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+    for (auto f : failures)
+        if (f)
+            std::rethrow_exception(f);
+#else
+    for (size_t n = 0; n < converters.size(); n++) {
+        size_t i = reverse ? converters.size() - 1 - n : n;
+        if (!cached.at(i))
+            convert(fragments.at(i), converters.at(i));
+    }
+#endif  // MULTITHREAD
+
+    // The fragments are stored before merge renumbers their ids.
+    if (cache != nullptr && errorCount() == 0) {
+        for (size_t i = 0; i < converters.size(); i++)
+            if (!cached.at(i))
+                store(fragments.at(i), keys.at(i));
+    }
+    for (auto f : fragments)
+        merge(f);
+    parts.clear();
+    converters.clear();
+}
+
+}  // namespace BMV2
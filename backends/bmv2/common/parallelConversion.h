@@ -0,0 +1,86 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef BACKENDS_BMV2_COMMON_PARALLELCONVERSION_H_
+#define BACKENDS_BMV2_COMMON_PARALLELCONVERSION_H_
+
+#include <functional>
+#include "fragmentCache.h"
+#include "helpers.h"
+
+namespace BMV2 {
+
+/**
+Converts independent parts of a program (parsers, controls, deparsers)
+to JSON.  Each part is converted into its own JSON fragment, using its
+own expression converter and allocating ids from its own IdScope.  The
+fragments are then merged into the program JSON in the order in which
+the parts were added, and their ids are renumbered, so the output does
+not depend on the order in which the parts were converted.
+
+If the compiler is built with MULTITHREAD (the ENABLE_MULTITHREAD CMake
+option) the parts are converted concurrently, each with a private copy
+of the type map (expression conversion records the types of the
+expressions it creates).  Otherwise they are converted one after the
+other.  The names generated for a part are provisional until it is
+merged (see ConversionContext::newName).
+
+All actions must be converted before: the controls refer to their ids.
+
+If a FragmentCache is set, the fragments of the parts that did not
+change since they were stored are read from the cache instead.
+*/
+class ParallelConversion {
+ public:
+    /// Converts one part of the program using the given context
+    using Converter = std::function<void(ConversionContext*)>;
+    /// Creates an expression converter for one part of the program
+    using ConverterFactory = std::function<ExpressionConverter*(P4::TypeMap*)>;
+
+    ParallelConversion(ConversionContext* ctxt, ConverterFactory newConverter) :
+            ctxt(ctxt), newConverter(newConverter)
+    { CHECK_NULL(ctxt); }
+
+    /// 'part' is the IR of the part converted by 'converter'.
+    void add(const IR::Node* part, Converter converter) {
+        parts.push_back(part);
+        converters.push_back(converter);
+    }
+    void setCache(FragmentCache* cache) { this->cache = cache; }
+    /// Starts converting from the last part; the result is the same.
+    void setReverseOrder(bool reverse) { this->reverse = reverse; }
+    /// Converts all the parts that were added and merges the results.
+    void run();
+
+ private:
+    struct Fragment;
+
+    ConversionContext*     ctxt;
+    ConverterFactory       newConverter;
+    FragmentCache*         cache = nullptr;
+    bool                   reverse = false;
+    std::vector<const IR::Node*> parts;
+    std::vector<Converter> converters;
+
+    void convert(Fragment* fragment, Converter converter) const;
+    bool load(Fragment* fragment, cstring key) const;
+    void store(const Fragment* fragment, cstring key) const;
+    void merge(Fragment* fragment);
+};
+
+}  // namespace BMV2
+
+#endif  /* BACKENDS_BMV2_COMMON_PARALLELCONVERSION_H_ */
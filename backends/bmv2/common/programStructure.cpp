@@ -14,10 +14,57 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include <algorithm>
+
 #include "programStructure.h"
+#include "helpers.h"
 
 namespace BMV2 {
 
+namespace {
+bool checkSameKeyExpr(const IR::Expression* expr0, const IR::Expression* expr1) {
+    if (expr0->node_type_name() != expr1->node_type_name())
+        return false;
+    if (auto pe0 = expr0->to<IR::PathExpression>()) {
+        auto pe1 = expr1->to<IR::PathExpression>();
+        return pe0->path->name == pe1->path->name &&
+            pe0->path->absolute == pe1->path->absolute;
+    } else if (auto mem0 = expr0->to<IR::Member>()) {
+        auto mem1 = expr1->to<IR::Member>();
+        return checkSameKeyExpr(mem0->expr, mem1->expr) && mem0->member == mem1->member;
+    } else if (auto l0 = expr0->to<IR::Literal>()) {
+        auto l1 = expr1->to<IR::Literal>();
+        return *l0 == *l1;
+    } else if (auto ai0 = expr0->to<IR::ArrayIndex>()) {
+        auto ai1 = expr1->to<IR::ArrayIndex>();
+        return checkSameKeyExpr(ai0->left, ai1->left) && checkSameKeyExpr(ai0->right, ai1->right);
+    }
+    return false;
+}
+
+// The instance a table property refers to, or nullptr; the errors are
+// reported when the table is converted.
+const IR::Declaration_Instance* propertyInstance(const IR::P4Table* table, cstring name,
+                                                 P4::ReferenceMap* refMap,
+                                                 const IR::PathExpression** path) {
+    auto property = table->properties->getProperty(name);
+    if (property == nullptr || !property->value->is<IR::ExpressionValue>())
+        return nullptr;
+    auto pe = property->value->to<IR::ExpressionValue>()->expression->to<IR::PathExpression>();
+    if (pe == nullptr)
+        return nullptr;
+    *path = pe;
+    return refMap->getDeclaration(pe->path, true)->to<IR::Declaration_Instance>();
+}
+}  // namespace
+
+const SelectorInput*
+ProgramStructure::getSelectorInput(const IR::Declaration_Instance* selector) const {
+    auto it = selectorInputs.find(selector);
+    if (it == selectorInputs.end()) return nullptr;  // selector never used
+    return &it->second;
+}
+
 void DiscoverStructure::postorder(const IR::ParameterList *paramList) {
     bool inAction = findContext<IR::P4Action>() != nullptr;
     unsigned index = 0;
@@ -35,6 +82,77 @@ void DiscoverStructure::postorder(const IR::P4Action *action) {
     structure->actions.emplace(action, control);
 }
 
+void DiscoverStructure::postorder(const IR::P4Table *table) {
+    discoverImplementation(table);
+    discoverDirectCounter(table);
+    discoverDirectMeter(table);
+}
+
+// When several tables share a selector, they must use the same input for
+// the selection algorithm.
+void DiscoverStructure::discoverImplementation(const IR::P4Table* table) {
+    const IR::PathExpression* path = nullptr;
+    auto decl = propertyInstance(table, "implementation", refMap, &path);
+    if (decl == nullptr)
+        return;
+    auto type = typeMap->getType(path, true);
+    if (!type->is<IR::Type_Extern>() ||
+        type->to<IR::Type_Extern>()->name != TableImplementation::actionSelectorName)
+        return;
+
+    SelectorInput input;
+    if (auto key = table->getKey()) {
+        for (auto ke : key->keyElements) {
+            auto mt = refMap->getDeclaration(ke->matchType->path, true)
+                    ->to<IR::Declaration_ID>();
+            BUG_CHECK(mt != nullptr, "%1%: could not find declaration", ke->matchType);
+            if (mt->name.name != MatchImplementation::selectorMatchTypeName) continue;
+            input.push_back(ke->expression);
+        }
+    }
+    auto it = structure->selectorInputs.find(decl);
+    if (it == structure->selectorInputs.end()) {
+        structure->selectorInputs.emplace(decl, input);
+        return;
+    }
+    if (it->second.size() != input.size() ||
+        !std::equal(input.begin(), input.end(), it->second.begin(), checkSameKeyExpr))
+        ::error("Action selector '%1%' is used by multiple tables with different selector inputs",
+                decl);
+}
+
+void DiscoverStructure::discoverDirectCounter(const IR::P4Table* table) {
+    const IR::PathExpression* path = nullptr;
+    auto decl = propertyInstance(table, "counters", refMap, &path);
+    if (decl == nullptr)
+        return;
+    cstring name = decl->controlPlaneName();
+    auto it = structure->directCounterMap.find(name);
+    if (it != structure->directCounterMap.end()) {
+        ::error("%1%: Direct counters cannot be attached to multiple tables %2% and %3%",
+                decl, it->second, table);
+        return;
+    }
+    structure->directCounterMap.emplace(name, table);
+}
+
+void DiscoverStructure::discoverDirectMeter(const IR::P4Table* table) {
+    const IR::PathExpression* path = nullptr;
+    auto decl = propertyInstance(table, "meters", refMap, &path);
+    if (decl == nullptr)
+        return;
+    auto type = typeMap->getType(path, true);
+    if (type->is<IR::Type_SpecializedCanonical>())
+        type = type->to<IR::Type_SpecializedCanonical>()->baseType;
+    if (!type->is<IR::Type_Extern>() || type->to<IR::Type_Extern>()->name != "direct_meter")
+        return;
+
+    // same as the max_size of the table; errors are reported by convertTable
+    unsigned size = TableAttributes::tableSize(table, false);
+    structure->directMeterMap.setTable(decl, table);
+    structure->directMeterMap.setSize(decl, size);
+}
+
 void DiscoverStructure::postorder(const IR::Declaration_Variable *decl) {
     structure->variables.push_back(decl);
 }
@@ -17,11 +17,14 @@ limitations under the License.
 #ifndef BACKENDS_BMV2_COMMON_PROGRAMSTRUCTURE_H_
 #define BACKENDS_BMV2_COMMON_PROGRAMSTRUCTURE_H_
 
+#include "frontends/common/resolveReferences/referenceMap.h"
+#include "frontends/p4/typeMap.h"
 #include "metermap.h"
 
 namespace BMV2 {
 
 using ResourceMap = ordered_map<const IR::Node*, const IR::CompileTimeValue*>;
+using SelectorInput = std::vector<const IR::Expression *>;
 
 // Represents all the compile-time information about a P4-16 program that
 // is common to all bmv2 targets (simple switch and psa switch).
@@ -44,26 +47,59 @@ class ProgramStructure {
     // in the scalarsName metadata object, so we may need to rename
     // these fields.  This map holds the new names.
     std::map<const IR::StructField *, cstring> scalarMetadataFields;
+    // Scalar local variables which do not live at the same time may share
+    // a field of the scalars metadata object (see CoalesceScalars).
+    // This map holds the field of each variable.
+    std::map<const IR::Declaration_Variable *, cstring> scalarVariableFields;
     // All the direct meters.
     DirectMeterMap directMeterMap;
     // All the direct counters.
     ordered_map<cstring, const IR::P4Table *> directCounterMap;
+    // The input of each action selector used by some table: bmv2 considers
+    // that it belongs to the selector, while v1model.p4 considers that it
+    // belongs to the key of the tables.
+    std::map<const IR::Declaration_Instance *, SelectorInput> selectorInputs;
     // All match kinds
     std::set<cstring>  match_kinds;
     // map IR node to compile-time allocated resource blocks.
     ResourceMap resourceMap;
 
     ProgramStructure() {}
+
+    /// The input of an action selector, or nullptr if no table uses it.
+    const SelectorInput* getSelectorInput(const IR::Declaration_Instance* selector) const;
 };
 
+/**
+Fills a ProgramStructure in a single walk of the program: the actions
+and their controls, the parameters, variables, error codes and match
+kinds, the inputs of the action selectors and the tables of the direct
+counters and meters.  The architecture-specific subclasses also find
+the parsers and controls of the program during the same walk.
+
+The direct counters and meters are bound to their tables here, rather
+than while the tables are converted, so that the controls can be
+converted concurrently, or loaded from the FragmentCache, without
+updating shared state.
+*/
 class DiscoverStructure : public Inspector {
+    void discoverImplementation(const IR::P4Table* table);
+    void discoverDirectCounter(const IR::P4Table* table);
+    void discoverDirectMeter(const IR::P4Table* table);
+
  public:
+    P4::ReferenceMap* refMap;
+    P4::TypeMap*      typeMap;
     ProgramStructure *structure;
 
-    explicit DiscoverStructure(ProgramStructure *structure) :
-        structure(structure) { setName("DiscoverStructure"); }
+    DiscoverStructure(P4::ReferenceMap* refMap, P4::TypeMap* typeMap,
+                      ProgramStructure *structure) :
+            refMap(refMap), typeMap(typeMap), structure(structure)
+    { CHECK_NULL(refMap); CHECK_NULL(typeMap); CHECK_NULL(structure);
+      setName("DiscoverStructure"); }
     void postorder(const IR::ParameterList *paramList) override;
     void postorder(const IR::P4Action *action) override;
+    void postorder(const IR::P4Table *table) override;
     void postorder(const IR::Declaration_Variable *decl) override;
     void postorder(const IR::Type_Error *errors) override;
     void postorder(const IR::Declaration_MatchKind* kind) override;
@@ -0,0 +1,201 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "tableEntries.h"
+#include "helpers.h"
+#include "frontends/p4/coreLibrary.h"
+#include "lib/indent.h"
+#include "lib/nullstream.h"
+
+namespace BMV2 {
+
+namespace {
+// Writes a JSON object formatted like Util::JsonObject::serialize
+class ObjectWriter {
+    std::ostream& out;
+    bool first = true;
+
+ public:
+    explicit ObjectWriter(std::ostream& out) : out(out) { out << "{" << IndentCtl::indent; }
+    /// Writes the label of a field; the caller writes its value
+    std::ostream& field(const char* label) {
+        if (!first)
+            out << ",";
+        first = false;
+        return out << IndentCtl::endl << "\"" << label << "\" : ";
+    }
+    void hexField(const char* label, const mpz_class& value, unsigned bytes) {
+        field(label) << "\"";
+        writeHex(out, value, bytes);
+        out << "\"";
+    }
+    void close() { out << IndentCtl::unindent << IndentCtl::endl << "}"; }
+};
+}  // namespace
+
+void TableEntries::writeKey(std::ostream& out, const Key& key,
+                            const IR::Expression* k) const {
+    auto& corelib = P4::P4CoreLibrary::instance;
+    auto keyWidth = key.width;
+    auto k8 = ROUNDUP(keyWidth, 8);
+    ObjectWriter json(out);
+    json.field("match_type") << "\"" << key.matchType << "\"";
+    if (key.matchType == corelib.exactMatch.name) {
+        if (k->is<IR::Constant>())
+            json.hexField("key", k->to<IR::Constant>()->value, k8);
+        else if (k->is<IR::BoolLiteral>())
+            // booleans are converted to ints
+            json.hexField("key", k->to<IR::BoolLiteral>()->value ? 1 : 0, k8);
+        else
+            ::error("%1% unsupported exact key expression", k);
+    } else if (key.matchType == corelib.ternaryMatch.name) {
+        if (k->is<IR::Mask>()) {
+            auto km = k->to<IR::Mask>();
+            json.hexField("key", km->left->to<IR::Constant>()->value, k8);
+            json.hexField("mask", km->right->to<IR::Constant>()->value, k8);
+        } else if (k->is<IR::Constant>()) {
+            json.hexField("key", k->to<IR::Constant>()->value, k8);
+            json.hexField("mask", Util::mask(keyWidth), k8);
+        } else if (k->is<IR::DefaultExpression>()) {
+            json.hexField("key", 0, k8);
+            json.hexField("mask", 0, k8);
+        } else {
+            ::error("%1% unsupported ternary key expression", k);
+        }
+    } else if (key.matchType == corelib.lpmMatch.name) {
+        if (k->is<IR::Mask>()) {
+            auto km = k->to<IR::Mask>();
+            json.hexField("key", km->left->to<IR::Constant>()->value, k8);
+            auto trailing_zeros = [](unsigned long n) { return n ? __builtin_ctzl(n) : 0; };
+            auto count_ones = [](unsigned long n) { return n ? __builtin_popcountl(n) : 0;};
+            unsigned long mask = km->right->to<IR::Constant>()->value.get_ui();
+            auto len = trailing_zeros(mask);
+            if (len + count_ones(mask) != keyWidth)  // any remaining 0s in the prefix?
+                ::error("%1% invalid mask for LPM key", k);
+            else
+                json.field("prefix_length") << keyWidth - len;
+        } else if (k->is<IR::Constant>()) {
+            json.hexField("key", k->to<IR::Constant>()->value, k8);
+            json.field("prefix_length") << keyWidth;
+        } else if (k->is<IR::DefaultExpression>()) {
+            json.hexField("key", 0, k8);
+            json.field("prefix_length") << 0;
+        } else {
+            ::error("%1% unsupported LPM key expression", k);
+        }
+    } else if (key.matchType == "range") {
+        if (k->is<IR::Range>()) {
+            auto kr = k->to<IR::Range>();
+            json.hexField("start", kr->left->to<IR::Constant>()->value, k8);
+            json.hexField("end", kr->right->to<IR::Constant>()->value, k8);
+        } else if (k->is<IR::DefaultExpression>()) {
+            json.hexField("start", 0, k8);
+            json.hexField("end", Util::mask(keyWidth), k8);  // 2^N -1
+        } else {
+            ::error("%1% invalid range key expression", k);
+        }
+    } else {
+        ::error("unkown key match type '%1%' for key %2%", key.matchType, k);
+    }
+    json.close();
+}
+
+void TableEntries::writeEntry(std::ostream& out, const IR::Entry* e, int priority) const {
+    // TODO(jafingerhut) - add line/col here?
+    ObjectWriter entry(out);
+    auto& matchKey = entry.field("match_key");
+    auto& keyset = e->getKeys()->components;
+    if (keyset.empty()) {
+        matchKey << "[]";
+    } else {
+        matchKey << "[" << IndentCtl::indent;
+        for (size_t i = 0; i < keyset.size(); i++) {
+            if (i > 0)
+                out << ",";
+            out << IndentCtl::endl;
+            writeKey(out, keys.at(i), keyset.at(i));
+        }
+        out << IndentCtl::unindent << IndentCtl::endl << "]";
+    }
+
+    entry.field("action_entry");
+    ObjectWriter action(out);
+    auto actionRef = e->getAction();
+    auto actionCall = actionRef->to<IR::MethodCallExpression>();
+    auto method = actionCall == nullptr ? nullptr : actionCall->method->to<IR::PathExpression>();
+    auto id = method == nullptr ? actionIds.end() : actionIds.find(method->path->name.name);
+    if (id == actionIds.end()) {
+        ::error("%1%: invalid action in entries list", actionRef);
+    } else {
+        action.field("action_id") << id->second;
+        auto& actionData = action.field("action_data");
+        actionData << "[";
+        bool first = true;
+        for (auto arg : *actionCall->arguments) {
+            if (!first)
+                actionData << ", ";
+            first = false;
+            actionData << "\"";
+            if (arg->expression->is<IR::Constant>())
+                writeHex(actionData, arg->expression->to<IR::Constant>()->value);
+            else if (arg->expression->is<IR::BoolLiteral>())
+                writeHex(actionData, arg->expression->to<IR::BoolLiteral>()->value ? 1 : 0);
+            else
+                ::error("%1%: argument must evaluate to a constant integer", arg);
+            actionData << "\"";
+        }
+        actionData << "]";
+    }
+    action.close();
+
+    auto priorityAnnotation = e->getAnnotation("priority");
+    if (priorityAnnotation != nullptr) {
+        if (priorityAnnotation->expr.size() > 1)
+            ::error("invalid priority value %1%", priorityAnnotation->expr);
+        auto priValue = priorityAnnotation->expr.front();
+        if (!priValue->is<IR::Constant>())
+            ::error("invalid priority value %1%. must be constant", priorityAnnotation->expr);
+        else
+            entry.field("priority") << priValue->to<IR::Constant>()->value;
+    } else {
+        entry.field("priority") << priority;
+    }
+    entry.close();
+}
+
+void TableEntries::serialize(std::ostream& out) const {
+    // same layout as Util::JsonArray::serialize
+    if (entries->entries.empty()) {
+        out << "[]";
+        return;
+    }
+    out << "[" << IndentCtl::indent;
+    int entryPriority = 1;  // default priority is defined by index position
+    for (auto e : entries->entries) {
+        if (entryPriority > 1)
+            out << ",";
+        out << IndentCtl::endl;
+        writeEntry(out, e, entryPriority++);
+    }
+    out << IndentCtl::unindent << IndentCtl::endl << "]";
+}
+
+void TableEntries::check() const {
+    nullstream out;
+    serialize(out);
+}
+
+}  // namespace BMV2
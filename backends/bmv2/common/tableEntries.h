@@ -0,0 +1,62 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef BACKENDS_BMV2_COMMON_TABLEENTRIES_H_
+#define BACKENDS_BMV2_COMMON_TABLEENTRIES_H_
+
+#include <map>
+#include <vector>
+#include "ir/ir.h"
+#include "lib/json.h"
+
+namespace BMV2 {
+
+/**
+The JSON array of the 'const entries' of a table.  The entries are
+converted and written one at a time when the array is serialized, so
+tables with many entries are never held in memory as JSON objects, and
+their keys are not stored as cstrings.
+*/
+class TableEntries final : public Util::IJson {
+ public:
+    struct Key {
+        cstring matchType;
+        int     width;
+    };
+
+ private:
+    const IR::EntriesList*        entries;
+    /// The match type and width of each key element of the table
+    std::vector<Key>              keys;
+    /// The ids of the actions of the table, by name
+    std::map<cstring, unsigned>   actionIds;
+
+    void writeKey(std::ostream& out, const Key& key, const IR::Expression* k) const;
+    void writeEntry(std::ostream& out, const IR::Entry* entry, int priority) const;
+
+ public:
+    TableEntries(const IR::EntriesList* entries, std::vector<Key> keys,
+                 std::map<cstring, unsigned> actionIds) :
+            entries(entries), keys(keys), actionIds(actionIds) { CHECK_NULL(entries); }
+    void serialize(std::ostream& out) const override;
+    /// Converts the entries without writing them, to report their errors
+    /// while the program is converted.
+    void check() const;
+};
+
+}  // namespace BMV2
+
+#endif  /* BACKENDS_BMV2_COMMON_TABLEENTRIES_H_ */
@@ -0,0 +1,261 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <algorithm>
+#include <set>
+
+#include "tableKeyLayout.h"
+#include "frontends/p4/coreLibrary.h"
+#include "frontends/p4/tableKeyNames.h"
+
+namespace BMV2 {
+
+namespace {
+// The single value matched by a keyset, or nullptr
+const IR::Expression* singleValue(const IR::Expression* keyset, int width) {
+    if (keyset->is<IR::Constant>() || keyset->is<IR::BoolLiteral>())
+        return keyset;
+    if (auto mask = keyset->to<IR::Mask>()) {
+        auto value = mask->left->to<IR::Constant>();
+        auto bits = mask->right->to<IR::Constant>();
+        if (value != nullptr && bits != nullptr && bits->value == Util::mask(width))
+            return value;
+    } else if (auto range = keyset->to<IR::Range>()) {
+        auto low = range->left->to<IR::Constant>();
+        auto high = range->right->to<IR::Constant>();
+        if (low != nullptr && high != nullptr && low->value == high->value)
+            return low;
+    }
+    return nullptr;
+}
+
+// The representation of a single value, or nullptr
+cstring valueString(const IR::Expression* value) {
+    if (auto constant = value->to<IR::Constant>())
+        return constant->value.get_str(16);
+    if (auto literal = value->to<IR::BoolLiteral>())
+        return literal->value ? "true" : "false";
+    return nullptr;
+}
+
+// Fields, possibly of header stack elements, which have a generated name
+bool isField(const IR::Expression* expression) {
+    if (expression->is<IR::PathExpression>())
+        return true;
+    if (auto member = expression->to<IR::Member>())
+        return isField(member->expr);
+    if (auto index = expression->to<IR::ArrayIndex>())
+        return index->right->is<IR::Constant>() && isField(index->left);
+    return false;
+}
+
+cstring explicitName(const IR::KeyElement* element) {
+    auto annotation = element->getAnnotation(IR::Annotation::nameAnnotation);
+    if (annotation == nullptr || annotation->expr.size() != 1)
+        return nullptr;
+    auto name = annotation->expr[0]->to<IR::StringLiteral>();
+    return name == nullptr ? nullptr : name->value;
+}
+}  // namespace
+
+cstring DoTableKeyLayout::generatedName(const IR::Expression* expression) const {
+    P4::KeyNameGenerator generator(typeMap);
+    (void)expression->apply(generator);
+    return generator.getName(expression);
+}
+
+bool DoTableKeyLayout::makeExact(std::vector<Column>& columns) const {
+    auto exact = P4::P4CoreLibrary::instance.exactMatch;
+    std::map<size_t, std::vector<const IR::Expression*>> values;
+    for (size_t i = 0; i < columns.size(); i++) {
+        auto& column = columns.at(i);
+        if (column.matchType == exact.name)
+            continue;
+        int width = typeMap->getType(column.element->expression, true)->width_bits();
+        for (auto keyset : column.values) {
+            auto value = singleValue(keyset, width);
+            if (value == nullptr)
+                return false;
+            values[i].push_back(value);
+        }
+    }
+    if (values.empty())
+        return false;
+
+    // entries with the same key could not all be added to an exact table
+    std::set<std::vector<cstring>> keys;
+    for (size_t e = 0; e < columns.front().values.size(); e++) {
+        std::vector<cstring> key;
+        for (size_t i = 0; i < columns.size(); i++) {
+            auto it = values.find(i);
+            cstring value = valueString(it == values.end() ? columns.at(i).values.at(e)
+                                                           : it->second.at(e));
+            if (value == nullptr)
+                return false;
+            key.push_back(value);
+        }
+        if (!keys.insert(key).second)
+            return false;
+    }
+
+    for (auto& it : values) {
+        auto& column = columns.at(it.first);
+        auto element = column.element;
+        LOG2("Key element " << element << " is matched as exact");
+        column.element = new IR::KeyElement(
+            element->srcInfo, element->annotations, element->expression,
+            new IR::PathExpression(new IR::Path(exact.Id(), true)));
+        column.matchType = exact.name;
+        column.values = it.second;
+    }
+    return true;
+}
+
+bool DoTableKeyLayout::merge(std::vector<Column>& columns) const {
+    auto exact = P4::P4CoreLibrary::instance.exactMatch.name;
+    bool changed = false;
+    for (size_t i = 0; i + 1 < columns.size(); ) {
+        auto& high = columns.at(i);
+        auto& low = columns.at(i + 1);
+        auto hs = high.element->expression->to<IR::Slice>();
+        auto ls = low.element->expression->to<IR::Slice>();
+        bool mergeable = high.matchType == exact && low.matchType == exact &&
+                hs != nullptr && ls != nullptr && isField(hs->e0) &&
+                hs->e0->equiv(*ls->e0) && hs->getL() == ls->getH() + 1 &&
+                // the annotations would be lost
+                high.element->annotations->annotations.size() == 1 &&
+                low.element->annotations->annotations.size() == 1 &&
+                explicitName(high.element) != nullptr &&
+                explicitName(high.element) == generatedName(hs) &&
+                explicitName(low.element) == generatedName(ls);
+        for (size_t e = 0; mergeable && e < high.values.size(); e++)
+            mergeable = high.values.at(e)->is<IR::Constant>() &&
+                        low.values.at(e)->is<IR::Constant>();
+        if (!mergeable) {
+            i++;
+            continue;
+        }
+
+        int h = hs->getH();
+        int l = ls->getL();
+        int lowWidth = ls->getH() - l + 1;
+        const IR::Expression* expression = hs->e0;
+        if (l != 0 || h != typeMap->getType(hs->e0, true)->width_bits() - 1)
+            expression = new IR::Slice(hs->srcInfo + ls->srcInfo, hs->e0, h, l);
+        cstring name = generatedName(expression);
+        auto annotations = new IR::Annotations();
+        annotations->addAnnotation(IR::Annotation::nameAnnotation,
+                                   new IR::StringLiteral(expression->srcInfo, name));
+        auto element = new IR::KeyElement(high.element->srcInfo + low.element->srcInfo,
+                                          annotations, expression, high.element->matchType);
+        LOG2("Merged key elements " << high.element << " and " << low.element <<
+             " into " << element);
+
+        auto type = IR::Type_Bits::get(h - l + 1);
+        std::vector<const IR::Expression*> values;
+        for (size_t e = 0; e < high.values.size(); e++) {
+            auto hv = high.values.at(e)->to<IR::Constant>();
+            auto lv = low.values.at(e)->to<IR::Constant>();
+            mpz_class value = (hv->value << lowWidth) | lv->value;
+            values.push_back(new IR::Constant(hv->srcInfo + lv->srcInfo, type, value, hv->base));
+        }
+        columns.at(i) = Column{ element, exact, values };
+        columns.erase(columns.begin() + i + 1);
+        changed = true;
+    }
+    return changed;
+}
+
+const IR::Node* DoTableKeyLayout::preorder(IR::P4Table* table) {
+    prune();
+    auto key = table->getKey();
+    if (key == nullptr || key->keyElements.empty())
+        return table;
+    auto entriesProperty =
+            table->properties->getProperty(IR::TableProperties::entriesPropertyName);
+    const IR::EntriesList* entries = nullptr;
+    if (entriesProperty != nullptr) {
+        entries = entriesProperty->value->to<IR::EntriesList>();
+        if (entries == nullptr)
+            return table;
+    }
+
+    std::vector<Column> columns;
+    for (size_t i = 0; i < key->keyElements.size(); i++) {
+        auto element = key->keyElements.at(i);
+        auto decl = refMap->getDeclaration(element->matchType->path, true)
+                ->to<IR::Declaration_ID>();
+        if (decl == nullptr)
+            return table;
+        Column column{ element, decl->name.name, {} };
+        if (entries != nullptr) {
+            for (auto e : entries->entries) {
+                if (e->keys->components.size() != key->keyElements.size())
+                    return table;
+                column.values.push_back(e->keys->components.at(i));
+            }
+        }
+        columns.push_back(column);
+    }
+
+    bool changed = false;
+    if (entries != nullptr && entriesProperty->isConstant && !entries->entries.empty())
+        changed = makeExact(columns);
+    auto exact = P4::P4CoreLibrary::instance.exactMatch.name;
+    auto isExact = [exact](const Column& column) { return column.matchType == exact; };
+    if (!std::is_partitioned(columns.begin(), columns.end(), isExact)) {
+        std::stable_partition(columns.begin(), columns.end(), isExact);
+        changed = true;
+    }
+    changed = merge(columns) || changed;
+    if (!changed)
+        return table;
+    LOG1("Changed the key layout of " << table->controlPlaneName());
+
+    IR::Vector<IR::KeyElement> elements;
+    for (auto& column : columns)
+        elements.push_back(column.element);
+    auto newKey = new IR::Key(key->srcInfo, elements);
+    IR::EntriesList* newEntries = nullptr;
+    if (entries != nullptr) {
+        IR::Vector<IR::Entry> newEntryVector;
+        for (size_t e = 0; e < entries->entries.size(); e++) {
+            auto entry = entries->entries.at(e);
+            IR::Vector<IR::Expression> keys;
+            for (auto& column : columns)
+                keys.push_back(column.values.at(e));
+            newEntryVector.push_back(new IR::Entry(
+                entry->srcInfo, entry->annotations,
+                new IR::ListExpression(entry->keys->srcInfo, keys), entry->action));
+        }
+        newEntries = new IR::EntriesList(entries->srcInfo, newEntryVector);
+    }
+
+    auto properties = new IR::TableProperties();
+    for (auto prop : table->properties->properties) {
+        if (prop->name == IR::TableProperties::keyPropertyName)
+            prop = new IR::Property(prop->srcInfo, prop->name, prop->annotations,
+                                    newKey, prop->isConstant);
+        else if (prop == entriesProperty)
+            prop = new IR::Property(prop->srcInfo, prop->name, prop->annotations,
+                                    newEntries, prop->isConstant);
+        properties->push_back(prop);
+    }
+    table->properties = properties;
+    return table;
+}
+
+}  // namespace BMV2
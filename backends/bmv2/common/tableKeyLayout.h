@@ -0,0 +1,81 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef BACKENDS_BMV2_COMMON_TABLEKEYLAYOUT_H_
+#define BACKENDS_BMV2_COMMON_TABLEKEYLAYOUT_H_
+
+#include "ir/ir.h"
+#include "frontends/common/resolveReferences/referenceMap.h"
+#include "frontends/p4/typeChecking/typeChecker.h"
+#include "frontends/p4/typeMap.h"
+
+namespace BMV2 {
+
+/**
+Rewrites the keys of the tables so that simple_switch builds and
+looks up the keys with less work:
+- a table with const entries whose ternary, lpm and range elements
+  are only matched against single values becomes an exact table,
+  if no two entries have the same key;
+- the exact elements are placed before the other elements;
+- adjacent exact elements that are contiguous slices of the same
+  field are merged into one element, if their names were generated
+  from their expressions; the merged element gets the generated name
+  of the merged expression.
+The const entries of the tables are rewritten to match the new keys.
+
+This changes the control-plane API of the tables, so it must run
+before the P4Runtime API is generated, which then describes the new
+keys; the match fields keep their names, except the merged ones.
+*/
+class DoTableKeyLayout final : public Transform {
+    P4::ReferenceMap* refMap;
+    P4::TypeMap*      typeMap;
+
+    /// A key element with the values it is matched against by each entry
+    struct Column {
+        const IR::KeyElement*                 element;
+        cstring                               matchType;
+        std::vector<const IR::Expression*>    values;
+    };
+
+    bool makeExact(std::vector<Column>& columns) const;
+    bool merge(std::vector<Column>& columns) const;
+    cstring generatedName(const IR::Expression* expression) const;
+
+ public:
+    DoTableKeyLayout(P4::ReferenceMap* refMap, P4::TypeMap* typeMap) :
+            refMap(refMap), typeMap(typeMap)
+    { CHECK_NULL(refMap); CHECK_NULL(typeMap); setName("DoTableKeyLayout"); }
+    const IR::Node* preorder(IR::P4Table* table) override;
+};
+
+class TableKeyLayout final : public PassManager {
+    P4::ReferenceMap refMap;
+    P4::TypeMap      typeMap;
+
+ public:
+    explicit TableKeyLayout(bool isv1) {
+        refMap.setIsV1(isv1);
+        passes.push_back(new P4::TypeChecking(&refMap, &typeMap));
+        passes.push_back(new DoTableKeyLayout(&refMap, &typeMap));
+        setName("TableKeyLayout");
+    }
+};
+
+}  // namespace BMV2
+
+#endif  /* BACKENDS_BMV2_COMMON_TABLEKEYLAYOUT_H_ */
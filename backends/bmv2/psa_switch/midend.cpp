@@ -39,6 +39,7 @@ limitations under the License.
 #include "midend/removeUnusedParameters.h"
 #include "midend/simplifyKey.h"
 #include "midend/simplifySelectCases.h"
+#include "midend/optimizeSelectCases.h"
 #include "midend/simplifySelectList.h"
 #include "midend/removeSelectBooleans.h"
 #include "midend/validateProperties.h"
@@ -46,6 +47,7 @@ limitations under the License.
 #include "midend/orderArguments.h"
 #include "midend/predication.h"
 #include "midend/expandLookahead.h"
+#include "midend/fuseParserStates.h"
 #include "midend/expandEmit.h"
 #include "midend/tableHit.h"
 #include "midend/midEndLast.h"
@@ -78,7 +80,8 @@ PsaSwitchMidEnd::PsaSwitchMidEnd(CompilerOptions& options) : MidEnd(options) {
         new P4::NestedStructs(&refMap, &typeMap),
         new P4::SimplifySelectList(&refMap, &typeMap),
         new P4::RemoveSelectBooleans(&refMap, &typeMap),
-        new P4::Predication(&refMap),
+        new P4::OptimizeSelectCases(&refMap, &typeMap),
+        new P4::Predication(&refMap, true),
         new P4::MoveDeclarations(),  // more may have been introduced
         new P4::ConstantFolding(&refMap, &typeMap),
         new P4::LocalCopyPropagation(&refMap, &typeMap),
@@ -93,6 +96,7 @@ PsaSwitchMidEnd::PsaSwitchMidEnd(CompilerOptions& options) : MidEnd(options) {
         new P4::CompileTimeOperations(),
         new P4::TableHit(&refMap, &typeMap),
         new P4::RemoveLeftSlices(&refMap, &typeMap),
+        new P4::FuseParserStates(),
         new P4::TypeChecking(&refMap, &typeMap),
         new P4::MidEndLast(),
         evaluator,
@@ -19,14 +19,20 @@ limitations under the License.
 
 namespace BMV2 {
 
-void PsaProgramStructure::create(ConversionContext* ctxt) {
+void PsaProgramStructure::create(ConversionContext* ctxt,
+                                 ParallelConversion::ConverterFactory newConverter,
+                                 FragmentCache* cache) {
     createTypes(ctxt);
     createHeaders(ctxt);
     createExterns();
-    createParsers(ctxt);
     createActions(ctxt);
-    createControls(ctxt);
-    createDeparsers(ctxt);
+    // The parsers, the controls and the deparsers are independent of each other
+    ParallelConversion units(ctxt, newConverter);
+    units.setCache(cache);
+    createParsers(&units);
+    createControls(&units);
+    createDeparsers(&units);
+    units.run();
     createGlobals();
 }
 
@@ -144,10 +150,11 @@ void PsaProgramStructure::createHeaders(ConversionContext* ctxt) {
     }
 }
 
-void PsaProgramStructure::createParsers(ConversionContext* ctxt) {
-    auto cvt = new ParserConverter(ctxt);
+void PsaProgramStructure::createParsers(ParallelConversion* units) {
     for (auto kv : parsers) {
-        kv.second->apply(*cvt);
+        auto parser = kv.second;
+        units->add(parser, [parser](ConversionContext* ctxt) {
+            parser->apply(*new ParserConverter(ctxt)); });
     }
 }
 
@@ -171,22 +178,23 @@ void PsaProgramStructure::createActions(ConversionContext* ctxt) {
     }
 }
 
-void PsaProgramStructure::createControls(ConversionContext* ctxt) {
-    auto cvt = new BMV2::ControlConverter(ctxt, "ingress", true);
+void PsaProgramStructure::createControls(ParallelConversion* units) {
     auto ingress = pipelines.at("ingress");
-    ingress->apply(*cvt);
+    units->add(ingress, [ingress](ConversionContext* ctxt) {
+        ingress->apply(*new BMV2::ControlConverter(ctxt, "ingress", true)); });
 
-    cvt = new BMV2::ControlConverter(ctxt, "egress", true);
     auto egress = pipelines.at("egress");
-    egress->apply(*cvt);
+    units->add(egress, [egress](ConversionContext* ctxt) {
+        egress->apply(*new BMV2::ControlConverter(ctxt, "egress", true)); });
 }
 
-void PsaProgramStructure::createDeparsers(ConversionContext* ctxt) {
-    auto cvt = new DeparserConverter(ctxt);
+void PsaProgramStructure::createDeparsers(ParallelConversion* units) {
     auto ingress = deparsers.at("ingress");
-    ingress->apply(*cvt);
+    units->add(ingress, [ingress](ConversionContext* ctxt) {
+        ingress->apply(*new DeparserConverter(ctxt)); });
     auto egress = deparsers.at("egress");
-    egress->apply(*cvt);
+    units->add(egress, [egress](ConversionContext* ctxt) {
+        egress->apply(*new DeparserConverter(ctxt)); });
 }
 
 void PsaProgramStructure::createGlobals() {
@@ -410,6 +418,7 @@ void PsaSwitchBackend::convert(const IR::ToplevelBlock* tlb) {
         new P4::ClearTypeMap(typeMap),  // because the user metadata type has changed
         // new P4::SynthesizeActions(refMap, typeMap, new SkipControls(&non_pipeline_controls)),
         new P4::MoveActionsToTables(refMap, typeMap),
+        new P4::SpecializeConstantActions(refMap, typeMap),
         new P4::TypeChecking(refMap, typeMap),
         new P4::SimplifyControlFlow(refMap, typeMap),
         new LowerExpressions(typeMap),
@@ -428,11 +437,13 @@ void PsaSwitchBackend::convert(const IR::ToplevelBlock* tlb) {
     toplevel->apply(*new BMV2::BuildResourceMap(&structure.resourceMap));
 
     PassManager toJson = {
-        new DiscoverStructure(&structure),
         new InspectPsaProgram(refMap, typeMap, &structure),
-        new ConvertPsaToJson(refMap, typeMap, toplevel, json, &structure)
+        new ConvertPsaToJson(refMap, typeMap, toplevel, json, &structure, peephole, cache)
     };
     program->apply(toJson);
+    json->deduplicate();
+    if (peephole != nullptr)
+        peephole->report();
 
     json->add_program_info(options.file);
     json->add_meta_info();
@@ -800,7 +811,7 @@ CONVERT_EXTERN_INSTANCE(ActionSelector) {
     }
     auto algo = convertHashAlgorithm(hash->to<IR::Declaration_ID>()->name);
     selector->emplace("algo", algo);
-    auto input = ctxt->selector_check->get_selector_input(
+    auto input = ctxt->structure->getSelectorInput(
         c->to<IR::Declaration_Instance>());
     if (input == nullptr) {
         // the selector is never used by any table, we cannot figure out its
@@ -27,6 +27,7 @@ limitations under the License.
 #include "frontends/p4/enumInstance.h"
 #include "frontends/p4/methodInstance.h"
 #include "frontends/p4/typeMap.h"
+#include "frontends/p4/typeChecking/typeChecker.h"
 #include "frontends/p4/simplify.h"
 #include "frontends/p4/unusedDeclarations.h"
 #include "backends/bmv2/common/action.h"
@@ -36,6 +37,7 @@ limitations under the License.
 #include "backends/bmv2/common/header.h"
 #include "backends/bmv2/common/helpers.h"
 #include "backends/bmv2/common/lower.h"
+#include "backends/bmv2/common/parallelConversion.h"
 #include "backends/bmv2/common/parser.h"
 #include "backends/bmv2/common/programStructure.h"
 
@@ -94,15 +96,16 @@ class PsaProgramStructure : public ProgramStructure {
         CHECK_NULL(typeMap);
     }
 
-    void create(ConversionContext* ctxt);
+    void create(ConversionContext* ctxt, ParallelConversion::ConverterFactory newConverter,
+                FragmentCache* cache = nullptr);
     void createStructLike(ConversionContext* ctxt, const IR::Type_StructLike* st);
     void createTypes(ConversionContext* ctxt);
     void createHeaders(ConversionContext* ctxt);
-    void createParsers(ConversionContext* ctxt);
+    void createParsers(ParallelConversion* units);
     void createExterns();
     void createActions(ConversionContext* ctxt);
-    void createControls(ConversionContext* ctxt);
-    void createDeparsers(ConversionContext* ctxt);
+    void createControls(ParallelConversion* units);
+    void createDeparsers(ParallelConversion* units);
     void createGlobals();
 
     bool hasVisited(const IR::Type_StructLike* st) {
@@ -133,17 +136,12 @@ class ParsePsaArchitecture : public Inspector {
     }
 };
 
-class InspectPsaProgram : public Inspector {
-    P4::ReferenceMap* refMap;
-    P4::TypeMap* typeMap;
+class InspectPsaProgram : public DiscoverStructure {
     PsaProgramStructure *pinfo;
 
  public:
     InspectPsaProgram(P4::ReferenceMap* refMap, P4::TypeMap* typeMap, PsaProgramStructure *pinfo)
-        : refMap(refMap), typeMap(typeMap), pinfo(pinfo) {
-        CHECK_NULL(refMap);
-        CHECK_NULL(typeMap);
-        CHECK_NULL(pinfo);
+        : DiscoverStructure(refMap, typeMap, pinfo), pinfo(pinfo) {
         setName("InspectPsaProgram");
     }
 
@@ -165,12 +163,15 @@ class ConvertPsaToJson : public Inspector {
     const IR::ToplevelBlock *toplevel;
     JsonObjects *json;
     PsaProgramStructure *structure;
+    ExpressionPeephole *peephole;
+    FragmentCache *cache;
 
     ConvertPsaToJson(P4::ReferenceMap *refMap, P4::TypeMap *typeMap,
                      const IR::ToplevelBlock *toplevel,
-                     JsonObjects *json, PsaProgramStructure *structure)
+                     JsonObjects *json, PsaProgramStructure *structure,
+                     ExpressionPeephole *peephole = nullptr, FragmentCache *cache = nullptr)
         : refMap(refMap), typeMap(typeMap), toplevel(toplevel), json(json),
-          structure(structure) {
+          structure(structure), peephole(peephole), cache(cache) {
         CHECK_NULL(refMap);
         CHECK_NULL(typeMap);
         CHECK_NULL(toplevel);
@@ -181,8 +182,13 @@ class ConvertPsaToJson : public Inspector {
         cstring scalarsName = refMap->newName("scalars");
         // This visitor is used in multiple passes to convert expression to json
         auto conv = new PsaSwitchExpressionConverter(refMap, typeMap, structure, scalarsName);
+        conv->peephole = peephole;
         auto ctxt = new ConversionContext(refMap, typeMap, toplevel, structure, conv, json);
-        structure->create(ctxt);
+        structure->create(ctxt, [this, scalarsName](P4::TypeMap* types) {
+            auto unitConv = new PsaSwitchExpressionConverter(refMap, types, structure,
+                                                             scalarsName);
+            unitConv->peephole = peephole;
+            return unitConv; }, cache);
     }
 };
 
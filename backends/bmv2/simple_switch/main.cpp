@@ -29,6 +29,7 @@ limitations under the License.
 #include "lib/log.h"
 #include "lib/nullstream.h"
 #include "backends/bmv2/common/JsonObjects.h"
+#include "backends/bmv2/common/tableKeyLayout.h"
 #include "backends/bmv2/simple_switch/midend.h"
 #include "backends/bmv2/simple_switch/simpleSwitch.h"
 
@@ -59,6 +60,12 @@ int main(int argc, char *const argv[]) {
         P4::FrontEnd frontend;
         frontend.addDebugHook(hook);
         program = frontend.run(options, program);
+        // before the P4Runtime API is generated from the program
+        if (program != nullptr && ::errorCount() == 0 && options.tableKeyLayout) {
+            BMV2::TableKeyLayout layout(options.isv1());
+            layout.addDebugHook(hook);
+            program = program->apply(layout);
+        }
     } catch (const Util::P4CExceptionBase &bug) {
         std::cerr << bug.what() << std::endl;
         return 1;
@@ -28,6 +28,8 @@ limitations under the License.
 #include "frontends/p4/uniqueNames.h"
 #include "frontends/p4/unusedDeclarations.h"
 #include "midend/actionSynthesis.h"
+#include "midend/commonSubexpressions.h"
+#include "midend/deadFields.h"
 #include "midend/complexComparison.h"
 #include "midend/convertEnums.h"
 #include "midend/copyStructures.h"
@@ -40,6 +42,7 @@ limitations under the License.
 #include "midend/removeUnusedParameters.h"
 #include "midend/simplifyKey.h"
 #include "midend/simplifySelectCases.h"
+#include "midend/optimizeSelectCases.h"
 #include "midend/simplifySelectList.h"
 #include "midend/removeSelectBooleans.h"
 #include "midend/validateProperties.h"
@@ -47,6 +50,7 @@ limitations under the License.
 #include "midend/orderArguments.h"
 #include "midend/predication.h"
 #include "midend/expandLookahead.h"
+#include "midend/fuseParserStates.h"
 #include "midend/expandEmit.h"
 #include "midend/tableHit.h"
 #include "midend/midEndLast.h"
@@ -80,11 +84,15 @@ SimpleSwitchMidEnd::SimpleSwitchMidEnd(CompilerOptions& options) : MidEnd(option
         new P4::NestedStructs(&refMap, &typeMap),
         new P4::SimplifySelectList(&refMap, &typeMap),
         new P4::RemoveSelectBooleans(&refMap, &typeMap),
-        new P4::Predication(&refMap),
+        new P4::OptimizeSelectCases(&refMap, &typeMap),
+        new P4::Predication(&refMap, true),
         new P4::MoveDeclarations(),  // more may have been introduced
         new P4::ConstantFolding(&refMap, &typeMap),
         new P4::LocalCopyPropagation(&refMap, &typeMap),
         new P4::ConstantFolding(&refMap, &typeMap),
+        new P4::CommonSubexpressionElimination(&refMap, &typeMap),
+        // v1model programs translated from P4-14 use metadata read by name
+        isv1 ? nullptr : new P4::EliminateDeadFields(&refMap, &typeMap),
         new P4::MoveDeclarations(),
         new P4::ValidateTableProperties({ "implementation",
                                           "size",
@@ -95,6 +103,7 @@ SimpleSwitchMidEnd::SimpleSwitchMidEnd(CompilerOptions& options) : MidEnd(option
         new P4::CompileTimeOperations(),
         new P4::TableHit(&refMap, &typeMap),
         new P4::RemoveLeftSlices(&refMap, &typeMap),
+        new P4::FuseParserStates(),
 
         // p4c-bm removed unused action parameters. To produce a compatible
         // control plane API, we remove them as well for P4-14 programs.
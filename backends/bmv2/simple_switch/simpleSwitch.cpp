@@ -113,7 +113,7 @@ CONVERT_EXTERN_FUNCTION(clone) {
         modelError("Expected 2 arguments for %1%", mc);
         return nullptr;
     }
-    cstring name = ctxt->refMap->newName("fl");
+    cstring name = ctxt->newName("fl");
     auto emptylist = new IR::ListExpression({});
     id = createFieldList(ctxt, emptylist, "field_lists", name, ctxt->json->field_lists);
 
@@ -148,7 +148,7 @@ CONVERT_EXTERN_FUNCTION(clone3) {
         modelError("Expected 3 arguments for %1%", mc);
         return nullptr;
     }
-    cstring name = ctxt->refMap->newName("fl");
+    cstring name = ctxt->newName("fl");
     id = createFieldList(ctxt, mc->arguments->at(2)->expression, "field_lists", name,
                          ctxt->json->field_lists);
     auto cloneType = mc->arguments->at(0);
@@ -629,7 +629,7 @@ CONVERT_EXTERN_INSTANCE(action_profile) {
         }
         auto algo = convertHashAlgorithm(hash->to<IR::Declaration_ID>()->name);
         selector->emplace("algo", algo);
-        auto input = ctxt->selector_check->get_selector_input(
+        auto input = ctxt->structure->getSelectorInput(
             c->to<IR::Declaration_Instance>());
         if (input == nullptr) {
             // the selector is never used by any table, we cannot figure out its
@@ -684,7 +684,7 @@ CONVERT_EXTERN_INSTANCE(action_selector) {
         }
         auto algo = convertHashAlgorithm(hash->to<IR::Declaration_ID>()->name);
         selector->emplace("algo", algo);
-        auto input = ctxt->selector_check->get_selector_input(
+        auto input = ctxt->structure->getSelectorInput(
             c->to<IR::Declaration_Instance>());
         if (input == nullptr) {
             // the selector is never used by any table, we cannot figure out its
@@ -883,6 +883,7 @@ SimpleSwitchBackend::convert(const IR::ToplevelBlock* tlb) {
         new P4::SynthesizeActions(refMap, typeMap,
                                   new SkipControls(&structure->non_pipeline_controls)),
         new P4::MoveActionsToTables(refMap, typeMap),
+        new P4::SpecializeConstantActions(refMap, typeMap),
         new P4::TypeChecking(refMap, typeMap),
         new P4::SimplifyControlFlow(refMap, typeMap),
         new LowerExpressions(typeMap),
@@ -930,7 +931,8 @@ SimpleSwitchBackend::convert(const IR::ToplevelBlock* tlb) {
     if (!main) return;  // no main
     main->apply(*parseV1Arch);
     PassManager updateStructure {
-        new DiscoverV1Structure(structure),
+        new DiscoverV1Structure(refMap, typeMap, structure),
+        new CoalesceScalars(refMap, typeMap, structure),
     };
     program = toplevel->getProgram();
     program->apply(updateStructure);
@@ -938,25 +940,30 @@ SimpleSwitchBackend::convert(const IR::ToplevelBlock* tlb) {
     cstring scalarsName = refMap->newName("scalars");
     // This visitor is used in multiple passes to convert expression to json
     conv = new SimpleSwitchExpressionConverter(refMap, typeMap, structure, scalarsName);
+    conv->peephole = peephole;
 
     auto ctxt = new ConversionContext(refMap, typeMap, toplevel, structure, conv, json);
 
     auto hconv = new HeaderConverter(ctxt, scalarsName);
     program->apply(*hconv);
 
-    auto pconv = new ParserConverter(ctxt);
-    structure->parser->apply(*pconv);
-
     createActions(ctxt, structure);
 
-    auto cconv = new ControlConverter(ctxt, "ingress", options.emitExterns);
-    structure->ingress->apply(*cconv);
-
-    cconv = new ControlConverter(ctxt, "egress", options.emitExterns);
-    structure->egress->apply(*cconv);
-
-    auto dconv = new DeparserConverter(ctxt);
-    structure->deparser->apply(*dconv);
+    // The parser, the controls and the deparser are independent of each other
+    ParallelConversion units(ctxt, [this, scalarsName](P4::TypeMap* types) {
+        auto unitConv = new SimpleSwitchExpressionConverter(refMap, types, structure, scalarsName);
+        unitConv->peephole = peephole;
+        return unitConv; });
+    units.setCache(cache);
+    units.add(structure->parser, [this](ConversionContext* unit) {
+        structure->parser->apply(*new ParserConverter(unit)); });
+    units.add(structure->ingress, [this](ConversionContext* unit) {
+        structure->ingress->apply(*new ControlConverter(unit, "ingress", options.emitExterns)); });
+    units.add(structure->egress, [this](ConversionContext* unit) {
+        structure->egress->apply(*new ControlConverter(unit, "egress", options.emitExterns)); });
+    units.add(structure->deparser, [this](ConversionContext* unit) {
+        structure->deparser->apply(*new DeparserConverter(unit)); });
+    units.run();
 
     convertChecksum(structure->compute_checksum->body, json->checksums,
                     json->calculations, false);
@@ -965,6 +972,9 @@ SimpleSwitchBackend::convert(const IR::ToplevelBlock* tlb) {
                     json->calculations, true);
 
     (void)toplevel->apply(ConvertGlobals(ctxt));
+    json->deduplicate();
+    if (peephole != nullptr)
+        peephole->report();
 }
 
 }  // namespace BMV2
@@ -23,18 +23,20 @@ limitations under the License.
 #include "frontends/p4/evaluator/evaluator.h"
 #include "frontends/p4/fromv1.0/v1model.h"
 #include "frontends/p4/simplify.h"
+#include "frontends/p4/typeChecking/typeChecker.h"
 #include "frontends/p4/unusedDeclarations.h"
 #include "midend/convertEnums.h"
 #include "backends/bmv2/common/action.h"
 #include "backends/bmv2/common/backend.h"
+#include "backends/bmv2/common/coalesceScalars.h"
 #include "backends/bmv2/common/control.h"
 #include "backends/bmv2/common/deparser.h"
 #include "backends/bmv2/common/extern.h"
 #include "backends/bmv2/common/globals.h"
 #include "backends/bmv2/common/header.h"
+#include "backends/bmv2/common/parallelConversion.h"
 #include "backends/bmv2/common/parser.h"
 #include "backends/bmv2/common/programStructure.h"
-#include "backends/bmv2/common/sharedActionSelectorCheck.h"
 
 namespace BMV2 {
 
@@ -126,8 +128,9 @@ class DiscoverV1Structure : public DiscoverStructure {
     V1ProgramStructure* structure;
 
  public:
-    explicit DiscoverV1Structure(V1ProgramStructure* structure)
-        : DiscoverStructure(structure), structure(structure) {
+    DiscoverV1Structure(P4::ReferenceMap* refMap, P4::TypeMap* typeMap,
+                        V1ProgramStructure* structure)
+        : DiscoverStructure(refMap, typeMap, structure), structure(structure) {
         CHECK_NULL(structure);
         setName("InspectV1Program");
     }
@@ -27,15 +27,20 @@ class StateTranslationVisitor : public CodeGenInspector {
     bool hasDefault;
     P4::P4CoreLibrary& p4lib;
     const EBPFParserState* state;
+    // Number of following extracts whose length is already checked
+    unsigned checkedExtracts;
 
     void compileExtractField(const IR::Expression* expr, cstring name,
                              unsigned alignment, EBPFType* type);
     void compileExtract(const IR::Vector<IR::Argument>* args);
+    void emitLengthCheck(unsigned width);
+    unsigned extractWidth(const IR::StatOrDecl* stat) const;
 
  public:
     explicit StateTranslationVisitor(const EBPFParserState* state) :
             CodeGenInspector(state->parser->program->refMap, state->parser->program->typeMap),
-            hasDefault(false), p4lib(P4::P4CoreLibrary::instance), state(state) {}
+            hasDefault(false), p4lib(P4::P4CoreLibrary::instance), state(state),
+            checkedExtracts(0) {}
     bool preorder(const IR::ParserState* state) override;
     bool preorder(const IR::SelectCase* selectCase) override;
     bool preorder(const IR::SelectExpression* expression) override;
@@ -55,7 +60,25 @@ bool StateTranslationVisitor::preorder(const IR::ParserState* parserState) {
     builder->spc();
     builder->blockStart();
 
-    visit(parserState->components, "components");
+    // A single length check covers a run of consecutive extracts:
+    // a packet too short for any of them is rejected anyway.
+    auto& components = parserState->components;
+    std::vector<unsigned> widths;
+    for (auto c : components)
+        widths.push_back(extractWidth(c));
+    for (size_t i = 0; i < components.size(); i++) {
+        if (checkedExtracts == 0 && widths.at(i) != 0) {
+            unsigned width = 0;
+            size_t run = i;
+            for (; run < components.size() && widths.at(run) != 0; run++)
+                width += widths.at(run);
+            if (run - i > 1) {
+                emitLengthCheck(width);
+                checkedExtracts = run - i;
+            }
+        }
+        visit(components.at(i));
+    }
     if (parserState->selectExpression == nullptr) {
         builder->emitIndent();
         builder->append("goto ");
@@ -210,22 +233,7 @@ StateTranslationVisitor::compileExtractField(
     builder->newline();
 }
 
-void
-StateTranslationVisitor::compileExtract(const IR::Vector<IR::Argument>* args) {
-    if (args->size() != 1) {
-        ::error("Variable-sized header fields not yet supported %1%", args);
-        return;
-    }
-
-    auto expr = args->at(0)->expression;
-    auto type = state->parser->typeMap->getType(expr);
-    auto ht = type->to<IR::Type_Header>();
-    if (ht == nullptr) {
-        ::error("Cannot extract to a non-header type %1%", expr);
-        return;
-    }
-
-    unsigned width = ht->width_bits();
+void StateTranslationVisitor::emitLengthCheck(unsigned width) {
     auto program = state->parser->program;
     builder->emitIndent();
     builder->appendFormat("if (%s < %s + BYTES(%s + %d)) ",
@@ -243,6 +251,49 @@ StateTranslationVisitor::compileExtract(const IR::Vector<IR::Argument>* args) {
     builder->appendFormat("goto %s;", IR::ParserState::reject.c_str());
     builder->newline();
     builder->blockEnd(true);
+}
+
+// Width of the header extracted by 'stat', or 0 if it is not an extract
+unsigned StateTranslationVisitor::extractWidth(const IR::StatOrDecl* stat) const {
+    auto mcs = stat->to<IR::MethodCallStatement>();
+    if (mcs == nullptr)
+        return 0;
+    auto mi = P4::MethodInstance::resolve(mcs->methodCall,
+                                          state->parser->program->refMap,
+                                          state->parser->program->typeMap);
+    auto extMethod = mi->to<P4::ExternMethod>();
+    if (extMethod == nullptr || extMethod->object != state->parser->packet ||
+        extMethod->method->name.name != p4lib.packetIn.extract.name)
+        return 0;
+    auto args = mcs->methodCall->arguments;
+    if (args->size() != 1)
+        return 0;
+    auto type = state->parser->typeMap->getType(args->at(0)->expression);
+    auto ht = type ? type->to<IR::Type_Header>() : nullptr;
+    if (ht == nullptr)
+        return 0;
+    return ht->width_bits();
+}
+
+void
+StateTranslationVisitor::compileExtract(const IR::Vector<IR::Argument>* args) {
+    if (args->size() != 1) {
+        ::error("Variable-sized header fields not yet supported %1%", args);
+        return;
+    }
+
+    auto expr = args->at(0)->expression;
+    auto type = state->parser->typeMap->getType(expr);
+    auto ht = type->to<IR::Type_Header>();
+    if (ht == nullptr) {
+        ::error("Cannot extract to a non-header type %1%", expr);
+        return;
+    }
+
+    if (checkedExtracts > 0)
+        checkedExtracts--;
+    else
+        emitLengthCheck(ht->width_bits());
 
     unsigned alignment = 0;
     for (auto f : ht->fields) {
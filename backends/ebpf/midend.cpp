@@ -16,12 +16,16 @@ limitations under the License.
 
 #include "midend.h"
 #include "midend/actionSynthesis.h"
+#include "midend/commonSubexpressions.h"
 #include "midend/complexComparison.h"
+#include "midend/deadFields.h"
 #include "midend/eliminateNewtype.h"
 #include "midend/removeParameters.h"
 #include "midend/local_copyprop.h"
 #include "midend/simplifyKey.h"
 #include "midend/simplifySelectCases.h"
+#include "midend/optimizeSelectCases.h"
+#include "midend/fuseParserStates.h"
 #include "midend/simplifySelectList.h"
 #include "midend/validateProperties.h"
 #include "midend/eliminateTuples.h"
@@ -88,11 +92,16 @@ const IR::ToplevelBlock* MidEnd::run(EbpfOptions& options, const IR::P4Program*
         new P4::EliminateTuples(&refMap, &typeMap),
         new P4::LocalCopyPropagation(&refMap, &typeMap),
         new P4::SimplifySelectList(&refMap, &typeMap),
+        // switch labels cannot be masked
+        new P4::OptimizeSelectCases(&refMap, &typeMap, false),
+        new P4::CommonSubexpressionElimination(&refMap, &typeMap, true),
+        new P4::EliminateDeadFields(&refMap, &typeMap),
         new P4::MoveDeclarations(),  // more may have been introduced
         new P4::SimplifyControlFlow(&refMap, &typeMap),
         new P4::ValidateTableProperties({"implementation"}),
         new P4::RemoveLeftSlices(&refMap, &typeMap),
         new EBPF::Lower(&refMap, &typeMap),
+        new P4::FuseParserStates(),
         evaluator,
         new P4::MidEndLast()
     };
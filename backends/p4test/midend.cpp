@@ -28,17 +28,21 @@ limitations under the License.
 #include "frontends/p4/unusedDeclarations.h"
 #include "midend.h"
 #include "midend/actionSynthesis.h"
+#include "midend/commonSubexpressions.h"
 #include "midend/compileTimeOps.h"
 #include "midend/complexComparison.h"
 #include "midend/copyStructures.h"
+#include "midend/deadFields.h"
 #include "midend/eliminateTuples.h"
 #include "midend/eliminateNewtype.h"
 #include "midend/expandEmit.h"
 #include "midend/expandLookahead.h"
+#include "midend/fuseParserStates.h"
 #include "midend/local_copyprop.h"
 #include "midend/midEndLast.h"
 #include "midend/nestedStructs.h"
 #include "midend/noMatch.h"
+#include "midend/optimizeSelectCases.h"
 #include "midend/parserUnroll.h"
 #include "midend/predication.h"
 #include "midend/removeExits.h"
@@ -63,7 +67,7 @@ class SkipControls : public P4::ActionSynthesisPolicy {
     }
 };
 
-MidEnd::MidEnd(CompilerOptions& options) {
+MidEnd::MidEnd(CompilerOptions& options, bool optimize) {
     bool isv1 = options.langVersion == CompilerOptions::FrontendVersion::P4_14;
     refMap.setIsV1(isv1);
     auto evaluator = new P4::EvaluatorPass(&refMap, &typeMap);
@@ -96,15 +100,19 @@ MidEnd::MidEnd(CompilerOptions& options) {
         new P4::NestedStructs(&refMap, &typeMap),
         new P4::SimplifySelectList(&refMap, &typeMap),
         new P4::RemoveSelectBooleans(&refMap, &typeMap),
-        new P4::Predication(&refMap),
+        optimize ? new P4::OptimizeSelectCases(&refMap, &typeMap) : nullptr,
+        new P4::Predication(&refMap, optimize),
         new P4::MoveDeclarations(),  // more may have been introduced
         new P4::ConstantFolding(&refMap, &typeMap),
         new P4::LocalCopyPropagation(&refMap, &typeMap),
         new P4::ConstantFolding(&refMap, &typeMap),
+        optimize ? new P4::CommonSubexpressionElimination(&refMap, &typeMap, true) : nullptr,
+        optimize && !isv1 ? new P4::EliminateDeadFields(&refMap, &typeMap) : nullptr,
         new P4::MoveDeclarations(),  // more may have been introduced
         new P4::SimplifyControlFlow(&refMap, &typeMap),
         new P4::CompileTimeOperations(),
         new P4::TableHit(&refMap, &typeMap),
+        optimize ? new P4::FuseParserStates() : nullptr,
         evaluator,
         new VisitFunctor([v1controls, evaluator](const IR::Node *root) -> const IR::Node * {
             auto toplevel = evaluator->getToplevelBlock();
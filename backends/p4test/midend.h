@@ -29,7 +29,9 @@ class MidEnd : public PassManager {
     P4::TypeMap         typeMap;
     IR::ToplevelBlock   *toplevel = nullptr;
 
-    explicit MidEnd(CompilerOptions& options);
+    /// If 'optimize' is true the optional optimizations used by
+    /// the BMv2 back-end are also run.
+    explicit MidEnd(CompilerOptions& options, bool optimize = false);
     IR::ToplevelBlock* process(const IR::P4Program *&program) {
         program = program->apply(*this);
         return toplevel; }
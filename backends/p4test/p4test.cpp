@@ -38,6 +38,7 @@ class P4TestOptions : public CompilerOptions {
     bool parseOnly = false;
     bool validateOnly = false;
     bool fromJSON = false;
+    bool optimize = false;
     P4TestOptions() {
         registerOption("--parse-only", nullptr,
                        [this](const char*) {
@@ -56,6 +57,12 @@ class P4TestOptions : public CompilerOptions {
                            return true;
                        },
                        "read previously dumped json instead of P4 source code");
+        registerOption("--optimize", nullptr,
+                       [this](const char*) {
+                           optimize = true;
+                           return true;
+                       },
+                       "Also run the optional mid-end optimizations used by the BMv2 back-end");
      }
 };
 
@@ -121,7 +128,7 @@ int main(int argc, char *const argv[]) {
             P4::serializeP4RuntimeIfRequired(program, options);
 
             if (!options.parseOnly && !options.validateOnly) {
-                P4Test::MidEnd midEnd(options);
+                P4Test::MidEnd midEnd(options, options.optimize);
                 midEnd.addDebugHook(hook);
 #if 0
                 /* doing this breaks the output until we get dump/undump of srcInfo */
@@ -16,6 +16,8 @@ limitations under the License.
 
 #include <algorithm>
 #include <iostream>
+#include <map>
+#include <sstream>
 #include <typeinfo>
 #include <unordered_map>
 #include <utility>
@@ -24,8 +26,11 @@ limitations under the License.
 #include <boost/algorithm/string.hpp>
 #include <boost/optional.hpp>
 #include <boost/range/adaptor/reversed.hpp>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/util/json_util.h>
+#include <google/protobuf/wire_format_lite.h>
 #include "p4/config/v1/p4info.pb.h"
 #include "p4/config/v1/p4types.pb.h"
 #include "p4/v1/p4runtime.pb.h"
@@ -166,6 +171,112 @@ static bool writeTextTo(const Message& message, std::ostream* destination) {
     return true;
 }
 
+/// Serialize the @entries to @destination in the binary protocol buffers
+/// format, as one WriteRequest message. The message is never built: its
+/// encoding is the concatenation of the encodings of its 'updates' fields,
+/// which are written one at a time.
+static bool writeTo(const P4RuntimeEntries& entries, std::ostream* destination) {
+    using google::protobuf::internal::WireFormatLite;
+    CHECK_NULL(destination);
+
+    bool success = true;
+    {
+        google::protobuf::io::OstreamOutputStream stream(destination);
+        google::protobuf::io::CodedOutputStream output(&stream);
+        auto tag = WireFormatLite::MakeTag(p4v1::WriteRequest::kUpdatesFieldNumber,
+                                           WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+        std::string bytes;
+        entries.forEachUpdate([&](const p4v1::Update& update) {
+            if (!update.SerializeToString(&bytes)) {
+                success = false;
+                return;
+            }
+            output.WriteTag(tag);
+            output.WriteVarint32(bytes.size());
+            output.WriteString(bytes);
+        });
+        success = success && !output.HadError();
+    }
+    if (!success) return false;
+    destination->flush();
+    return true;
+}
+
+/// Serialize the @entries to @destination in the JSON protocol buffers
+/// format, as one WriteRequest message, one update at a time. This is
+/// intended for debugging and testing.
+static bool writeJsonTo(const P4RuntimeEntries& entries, std::ostream* destination) {
+    using namespace google::protobuf::util;
+    CHECK_NULL(destination);
+
+    JsonPrintOptions options;
+    options.add_whitespace = true;
+
+    bool success = true;
+    bool first = true;
+    std::string output;
+    entries.forEachUpdate([&](const p4v1::Update& update) {
+        output.clear();
+        if (!success || MessageToJsonString(update, &output, options) != Status::OK) {
+            success = false;
+            return;
+        }
+        *destination << (first ? "{\n \"updates\": [" : ",");
+        first = false;
+        // Indent the message as an element of the 'updates' array.
+        std::istringstream lines(output);
+        std::string line;
+        while (std::getline(lines, line))
+            *destination << "\n  " << line;
+    });
+    if (first && success)
+        // No updates: the layout of an empty message is up to protobuf.
+        return writeJsonTo(p4v1::WriteRequest(), destination);
+    *destination << "\n ]\n}\n";
+    if (!success) {
+        ::error("Failed to serialize protobuf message to JSON");
+        return false;
+    }
+    if (!destination->good()) {
+        ::error("Failed to write JSON protobuf message to the output");
+        return false;
+    }
+
+    destination->flush();
+    return true;
+}
+
+/// Serialize the @entries to @destination in the text protocol buffers
+/// format, as one WriteRequest message, one update at a time. This is
+/// intended for debugging and testing.
+static bool writeTextTo(const P4RuntimeEntries& entries, std::ostream* destination) {
+    CHECK_NULL(destination);
+
+    google::protobuf::TextFormat::Printer printer;
+    // The fields of the updates are nested in the WriteRequest.
+    printer.SetInitialIndentLevel(1);
+    bool success = true;
+    std::string output;
+    entries.forEachUpdate([&](const p4v1::Update& update) {
+        if (!success || !printer.PrintToString(update, &output)) {
+            success = false;
+            return;
+        }
+        *destination << "updates {\n" << output << "}\n";
+    });
+    if (!success) {
+        ::error("Failed to serialize protobuf message to text");
+        return false;
+    }
+    if (!destination->good()) {
+        ::error("Failed to write text protobuf message to the output");
+        return false;
+    }
+
+    destination->flush();
+    return true;
+}
+
 }  // namespace writers
 
 /// The information about a default action which is needed to serialize it.
@@ -986,52 +1097,89 @@ static void analyzeParser(P4RuntimeAnalyzer& analyzer,
 }
 
 /// A converter which translates the 'const entries' for P4 tables (if any)
-/// into a P4Runtime WriteRequest message which can be used by a target to
-/// initialize its tables.
-class P4RuntimeEntriesConverter {
+/// into P4Runtime Update messages which can be used by a target to
+/// initialize its tables. Only the information about the tables is computed
+/// when the tables are added; the messages are created one at a time by
+/// forEachUpdate().
+class P4RuntimeEntriesConverter final : public P4RuntimeEntries {
  private:
     friend class P4RuntimeAnalyzer;
 
-    P4RuntimeEntriesConverter(const P4RuntimeSymbolTable& symbols)
-        : entries(new p4v1::WriteRequest), symbols(symbols) { }
+    /// What is needed to convert the entries of a table.
+    struct TableInfo {
+        const IR::EntriesList* entries;
+        p4rt_id_t id;
+        bool needsPriority;
+        /// The match type and the width of each key element
+        std::vector<std::pair<cstring, int>> keys;
+        /// The id and the parameter widths of each action, by name
+        std::map<cstring, std::pair<p4rt_id_t, std::vector<int>>> actions;
+    };
 
-    /// @return the P4Runtime WriteRequest message generated by this analyzer.
-    const p4v1::WriteRequest* getEntries() const {
-        BUG_CHECK(entries != nullptr, "Didn't produce a P4Runtime WriteRequest object?");
-        return entries;
-    }
+    P4RuntimeEntriesConverter() = default;
 
-    /// Appends the 'const entries' for the table to the WriteRequest message.
-    void addTableEntries(const IR::TableBlock* tableBlock, ReferenceMap* refMap) {
+    /// Records the 'const entries' of the table, if any.
+    void addTableEntries(const IR::TableBlock* tableBlock, const P4RuntimeSymbolTable& symbols,
+                         ReferenceMap* refMap) {
         CHECK_NULL(tableBlock);
         auto table = tableBlock->container;
 
         auto entriesList = table->getEntries();
         if (entriesList == nullptr) return;
 
-        auto tableName = table->controlPlaneName();
-        auto tableId = symbols.getId(P4RuntimeSymbolType::TABLE(), tableName);
-
-        int entryPriority = 1;
-        auto needsPriority = tableNeedsPriority(table, refMap);
-        for (auto e : entriesList->entries) {
-            auto protoUpdate = entries->add_updates();
-            protoUpdate->set_type(p4v1::Update::INSERT);
-            auto protoEntity = protoUpdate->mutable_entity();
-            auto protoEntry = protoEntity->mutable_table_entry();
-            protoEntry->set_table_id(tableId);
-            addMatchKey(protoEntry, table, e->getKeys(), refMap);
-            addAction(protoEntry, e->getAction(), refMap);
-            // TODO(antonin): according to the P4 specification, "Entries in a
-            // table are matched in the program order, stopping at the first
-            // matching entry." Based on the definition of 'priority' in
-            // P4Runtime, we may need a different scheme to allocate priority
-            // values. For now this assumes that the entry with priority '1' has
-            // the highest priority.
-            if (needsPriority) protoEntry->set_priority(entryPriority++);
+        TableInfo info;
+        info.entries = entriesList;
+        info.id = symbols.getId(P4RuntimeSymbolType::TABLE(), table->controlPlaneName());
+        info.needsPriority = tableNeedsPriority(table, refMap);
+        for (auto ke : table->getKey()->keyElements)
+            info.keys.emplace_back(getKeyMatchType(ke, refMap),
+                                   ke->expression->type->width_bits());
+        for (auto a : table->getActionList()->actionList) {
+            auto decl = refMap->getDeclaration(a->getPath(), true);
+            auto actionDecl = decl->to<IR::P4Action>();
+            if (actionDecl == nullptr) continue;
+            auto& action = info.actions[a->getName().name];
+            action.first = symbols.getId(P4RuntimeSymbolType::ACTION(),
+                                         actionDecl->controlPlaneName());
+            for (auto parameter : actionDecl->parameters->parameters)
+                action.second.push_back(parameter->type->width_bits());
         }
+        tables.push_back(info);
+    }
+
+    /// Converts all the entries once, to report their errors while the
+    /// program is analyzed.
+    void check() const {
+        forEachUpdate([](const p4v1::Update&) { });
     }
 
+ public:
+    void forEachUpdate(std::function<void(const p4v1::Update&)> function) const override {
+        // The same message is reused for all the entries.
+        p4v1::Update protoUpdate;
+        for (auto& table : tables) {
+            int entryPriority = 1;
+            for (auto e : table.entries->entries) {
+                protoUpdate.Clear();
+                protoUpdate.set_type(p4v1::Update::INSERT);
+                auto protoEntity = protoUpdate.mutable_entity();
+                auto protoEntry = protoEntity->mutable_table_entry();
+                protoEntry->set_table_id(table.id);
+                addMatchKey(protoEntry, table, e->getKeys());
+                addAction(protoEntry, table, e->getAction());
+                // TODO(antonin): according to the P4 specification, "Entries in a
+                // table are matched in the program order, stopping at the first
+                // matching entry." Based on the definition of 'priority' in
+                // P4Runtime, we may need a different scheme to allocate priority
+                // values. For now this assumes that the entry with priority '1' has
+                // the highest priority.
+                if (table.needsPriority) protoEntry->set_priority(entryPriority++);
+                function(protoUpdate);
+            }
+        }
+    }
+
+ private:
     /// Checks if the @table entries need to be assigned a priority, i.e. does
     /// the match key for the table includes a ternary or range match?
     bool tableNeedsPriority(const IR::P4Table* table, ReferenceMap* refMap) const {
@@ -1047,28 +1195,25 @@ class P4RuntimeEntriesConverter {
     }
 
     void addAction(p4v1::TableEntry* protoEntry,
-                   const IR::Expression* actionRef,
-                   ReferenceMap* refMap) const {
-        if (!actionRef->is<IR::MethodCallExpression>()) {
+                   const TableInfo& table,
+                   const IR::Expression* actionRef) const {
+        auto actionCall = actionRef->to<IR::MethodCallExpression>();
+        auto method = actionCall ? actionCall->method->to<IR::PathExpression>() : nullptr;
+        auto action = method ? table.actions.find(method->path->name.name)
+                             : table.actions.end();
+        if (action == table.actions.end()) {
             ::error("%1%: invalid action in entries list", actionRef);
             return;
         }
-        auto actionCall = actionRef->to<IR::MethodCallExpression>();
-        auto method = actionCall->method->to<IR::PathExpression>()->path;
-        auto decl = refMap->getDeclaration(method, true);
-        auto actionDecl = decl->to<IR::P4Action>();
-        auto actionName = actionDecl->controlPlaneName();
-        auto actionId = symbols.getId(P4RuntimeSymbolType::ACTION(), actionName);
 
         auto protoAction = protoEntry->mutable_action()->mutable_action();
-        protoAction->set_action_id(actionId);
+        protoAction->set_action_id(action->second.first);
         int parameterIndex = 0;
         int parameterId = 1;
         for (auto arg : *actionCall->arguments) {
             auto protoParam = protoAction->add_params();
             protoParam->set_param_id(parameterId++);
-            auto parameter = actionDecl->parameters->parameters.at(parameterIndex);
-            auto width = parameter->type->width_bits();
+            auto width = action->second.second.at(parameterIndex++);
             if (arg->expression->is<IR::Constant>()) {
                 auto value = stringRepr(arg->expression->to<IR::Constant>(), width);
                 protoParam->set_value(*value);
@@ -1083,15 +1228,14 @@ class P4RuntimeEntriesConverter {
     }
 
     void addMatchKey(p4v1::TableEntry* protoEntry,
-                     const IR::P4Table* table,
-                     const IR::ListExpression* keyset,
-                     ReferenceMap* refMap) const {
+                     const TableInfo& table,
+                     const IR::ListExpression* keyset) const {
         int keyIndex = 0;
         int fieldId = 1;
         for (auto k : keyset->components) {
-            auto tableKey = table->getKey()->keyElements.at(keyIndex++);
-            auto keyWidth = tableKey->expression->type->width_bits();
-            auto matchType = getKeyMatchType(tableKey, refMap);
+            auto& tableKey = table.keys.at(keyIndex++);
+            auto matchType = tableKey.first;
+            auto keyWidth = tableKey.second;
 
             auto protoMatch = protoEntry->add_match();
             protoMatch->set_field_id(fieldId++);
@@ -1216,10 +1360,17 @@ class P4RuntimeEntriesConverter {
         BUG_CHECK(static_cast<size_t>(width) >= bitsRequired,
                   "Cannot represent %1% on %2% bits", value, width);
         auto bytes = ROUNDUP(width, 8);
-        std::vector<char> data(bytes);
-        mpz_export(data.data(), NULL, 1 /* big endian word */, bytes,
+        std::string data(bytes, '\0');
+        if (bitsRequired <= 8 * sizeof(unsigned long)) {
+            // Most keys fit in a machine word and are encoded directly.
+            unsigned long v = value.get_ui();
+            for (size_t i = bytes; i > 0 && v != 0; i--, v >>= 8)
+                data[i - 1] = static_cast<char>(v & 0xff);
+            return data;
+        }
+        mpz_export(&data[0], NULL, 1 /* big endian word */, bytes,
                    1 /* big endian bytes */, 0 /* full words */, value.get_mpz_t());
-        return std::string(data.begin(), data.end());
+        return data;
     }
 
     boost::optional<std::string> stringRepr(const IR::Constant* constant, int width) const {
@@ -1231,10 +1382,8 @@ class P4RuntimeEntriesConverter {
         return stringReprConstant(v, width);
     }
 
-    /// We represent all static table entries as one P4Runtime WriteRequest object
-    p4v1::WriteRequest *entries;
-    /// The symbols used in the API and their ids.
-    const P4RuntimeSymbolTable& symbols;
+    /// The tables with 'const entries'
+    std::vector<TableInfo> tables;
 };
 
 /* static */ P4RuntimeAPI
@@ -1289,14 +1438,14 @@ P4RuntimeAnalyzer::analyze(const IR::P4Program* program,
         }
     });
 
-    P4RuntimeEntriesConverter entriesConverter(symbols);
+    auto* p4Entries = new P4RuntimeEntriesConverter();
     Helpers::forAllEvaluatedBlocks(evaluatedProgram, [&](const IR::Block* block) {
         if (block->is<IR::TableBlock>())
-            entriesConverter.addTableEntries(block->to<IR::TableBlock>(), refMap);
+            p4Entries->addTableEntries(block->to<IR::TableBlock>(), symbols, refMap);
     });
+    p4Entries->check();
 
     auto* p4Info = analyzer.getP4Info();
-    auto* p4Entries = entriesConverter.getEntries();
     return P4RuntimeAPI{p4Info, p4Entries};
 }
 
@@ -1309,7 +1458,7 @@ P4RuntimeSerializer::generateP4Runtime(const IR::P4Program* program, cstring arc
     auto archHandlerBuilderIt = archHandlerBuilders.find(arch);
     if (archHandlerBuilderIt == archHandlerBuilders.end()) {
         ::error("Arch '%1%' not supported by P4Runtime serializer", arch);
-        return P4RuntimeAPI{new p4configv1::P4Info(), new p4v1::WriteRequest()};
+        return P4RuntimeAPI{new p4configv1::P4Info(), new P4RuntimeEntries()};
     }
 
     // Generate a new version of the program that satisfies the prerequisites of
@@ -1359,6 +1508,14 @@ void P4RuntimeAPI::serializeP4InfoTo(std::ostream* destination, P4RuntimeFormat
         ::error("Failed to serialize the P4Runtime API to the output");
 }
 
+const p4v1::WriteRequest* P4RuntimeEntries::toWriteRequest() const {
+    auto* request = new p4v1::WriteRequest;
+    forEachUpdate([request](const p4v1::Update& update) {
+        *request->add_updates() = update;
+    });
+    return request;
+}
+
 void P4RuntimeAPI::serializeEntriesTo(std::ostream* destination, P4RuntimeFormat format) {
     using namespace ControlPlaneAPI;
 
@@ -17,6 +17,7 @@ limitations under the License.
 #ifndef CONTROL_PLANE_P4RUNTIMESERIALIZER_H_
 #define CONTROL_PLANE_P4RUNTIMESERIALIZER_H_
 
+#include <functional>
 #include <iosfwd>
 #include <unordered_map>
 
@@ -29,6 +30,7 @@ class P4Info;
 }  // namespace v1
 }  // namespace config
 namespace v1 {
+class Update;
 class WriteRequest;
 }  // namespace v1
 }  // namespace p4
@@ -48,6 +50,21 @@ enum class P4RuntimeFormat {
   TEXT
 };
 
+/// The static table entries of a P4 program ('const entries'), as P4Runtime
+/// Update messages. The messages are created one at a time when they are
+/// used, so that programs with very many entries never hold all of them in
+/// memory. This base class has no entries.
+class P4RuntimeEntries {
+ public:
+    virtual ~P4RuntimeEntries() { }
+    /// Calls @function with the INSERT Update message of each entry, in
+    /// program order. The message is only valid during the call.
+    virtual void forEachUpdate(
+        std::function<void(const ::p4::v1::Update&)> function) const { (void)function; }
+    /// @return a WriteRequest message containing all the entries.
+    const ::p4::v1::WriteRequest* toWriteRequest() const;
+};
+
 /// A P4 program's control-plane API, represented in terms of P4Runtime's data
 /// structures. Can be inspected or serialized.
 struct P4RuntimeAPI {
@@ -56,14 +73,14 @@ struct P4RuntimeAPI {
     void serializeP4InfoTo(std::ostream* destination, P4RuntimeFormat format);
     /// Serialize the WriteRequest message containing all the table entries to
     /// the @destination stream in the requested protobuf serialization @format.
+    /// The entries are written one at a time.
     void serializeEntriesTo(std::ostream* destination, P4RuntimeFormat format);
 
     /// A P4Runtime P4Info message, which encodes the control-plane API of the
     /// program. Never null.
     const ::p4::config::v1::P4Info* p4Info;
-    /// All static table entries as one P4Runtime WriteRequest object. Never
-    /// null.
-    const ::p4::v1::WriteRequest* entries;
+    /// All static table entries. Never null.
+    const P4RuntimeEntries* entries;
 };
 
 namespace ControlPlaneAPI {
@@ -97,6 +97,10 @@ CompilerOptions::CompilerOptions() : Util::Options(defaultMessage) {
     registerOption("--toJSON", "file",
                    [this](const char* arg) { dumpJsonFile = arg; return true; },
                    "Dump the compiler IR after the midend as JSON in the specified file.");
+    registerOption("--inline-by-level", nullptr,
+                   [this](const char*) { inlineByLevel = true; return true; },
+                   "Inline all the parsers and controls whose callees are done\n"
+                   "in one sweep, instead of stopping at the first dependence.");
     registerOption("--p4runtime-file", "file",
                    [this](const char* arg) { p4RuntimeFile = arg; return true; },
                    "Write a P4Runtime control plane API description to the specified file.");
@@ -80,6 +80,9 @@ class CompilerOptions : public Util::Options {
     // Dump and undump the IR tree
     bool debugJson = false;
 
+    // Inline all the parsers and controls of one level of the hierarchy at once
+    bool inlineByLevel = false;
+
     // Write a P4Runtime control plane API description to the specified file.
     cstring p4RuntimeFile = nullptr;
 
@@ -25,6 +25,7 @@ ReferenceMap::ReferenceMap() : ProgramMap("ReferenceMap"), isv1(false) { clear()
 void ReferenceMap::clear() {
     pathToDeclaration.clear();
     usedNames.clear();
+    nextCandidate.clear();
     used.clear();
     thisToDeclaration.clear();
     usedNames.insert(P4::reservedWords.begin(), P4::reservedWords.end());
@@ -103,8 +104,23 @@ cstring ReferenceMap::newName(cstring base) {
     if (len > 0 && base[len - 1] == '_')
         base = base.substr(0, len - 1);
 
-    cstring name = cstring::make_unique(usedNames, base, '_');
+    // Generates the same names as cstring::make_unique(usedNames, base, '_'),
+    // but resumes the search where the previous call with the same base
+    // stopped: names are never removed from usedNames, so all earlier
+    // candidates are still taken.
+    unsigned &candidate = nextCandidate[base];
+    cstring name;
+    while (true) {
+        if (candidate == 0)
+            name = base;
+        else
+            name = base + "_" + std::to_string(candidate - 1);
+        if (usedNames.count(name) == 0)
+            break;
+        candidate++;
+    }
     usedNames.insert(name);
+    candidate++;
     return name;
 }
 
@@ -17,6 +17,8 @@ limitations under the License.
 #ifndef _COMMON_RESOLVEREFERENCES_REFERENCEMAP_H_
 #define _COMMON_RESOLVEREFERENCES_REFERENCEMAP_H_
 
+#include <unordered_map>
+#include <unordered_set>
 #include "ir/ir.h"
 #include "lib/cstring.h"
 #include "lib/map.h"
@@ -46,7 +48,12 @@ class ReferenceMap final : public ProgramMap, public NameGenerator {
     std::map<const IR::This*, const IR::IDeclaration*> thisToDeclaration;
 
     /// Set containing all names used in the program.
-    std::set<cstring> usedNames;
+    std::unordered_set<cstring> usedNames;
+
+    /// For each base name given to newName, the index of the first
+    /// candidate that has not been tried yet (0 is the base itself,
+    /// k > 0 is base_(k-1)).
+    std::unordered_map<cstring, unsigned> nextCandidate;
 
  public:
     ReferenceMap();
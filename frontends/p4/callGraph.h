@@ -19,7 +19,9 @@ limitations under the License.
 
 #include <vector>
 #include <unordered_set>
+#include <unordered_map>
 #include <algorithm>
+#include "lib/bitvec.h"
 #include "lib/log.h"
 #include "lib/exceptions.h"
 #include "lib/map.h"
@@ -36,6 +38,8 @@ cstring cgMakeString(char c);
 cstring cgMakeString(const IR::Node* node);
 cstring cgMakeString(const IR::INode* node);
 
+template <class T> class CompactCallGraph;
+
 template <class T>
 class CallGraph {
  protected:
@@ -112,10 +116,11 @@ class CallGraph {
     // Iterators over the out_edges
     const_iterator begin() const { return out_edges.cbegin(); }
     const_iterator end()   const { return out_edges.cend(); }
+    // Unknown nodes have no edges; they are not added to the graph.
     std::vector<T>* getCallees(T caller)
-    { return out_edges[caller]; }
+    { return ::get(out_edges, caller); }
     std::vector<T>* getCallers(T callee)
-    { return in_edges[callee]; }
+    { return ::get(in_edges, callee); }
     // Callees are appended to 'toAppend'
     void getCallees(T caller, std::set<T> &toAppend) {
         if (isCaller(caller))
@@ -124,20 +129,8 @@ class CallGraph {
     size_t size() const { return nodes.size(); }
     // out will contain all nodes reachable from start
     void reachable(T start, std::set<T> &out) const {
-        std::set<T> work;
-        work.emplace(start);
-        while (!work.empty()) {
-            T node = *work.begin();
-            work.erase(node);
-            if (out.find(node) != out.end())
-                continue;
-            out.emplace(node);
-            auto edges = out_edges.find(node);
-            if (edges == out_edges.end())
-                continue;
-            for (auto c : *(edges->second))
-                work.emplace(c);
-        }
+        CompactCallGraph<T> compact(*this);
+        compact.reachable(start, out);
     }
     // remove all nodes not in 'to'
     void restrict(const std::set<T> &to) {
@@ -264,115 +257,212 @@ class CallGraph {
             set.erase(e);
     }
 
-    // Helper for computing strongly-connected components
-    // using Tarjan's algorithm.
+ public:
+    // Sort that computes strongly-connected components - all nodes in
+    // a strongly-connected components will be consecutive in the
+    // sort.  Returns true if the graph contains at least one
+    // cycle.  Ignores nodes not reachable from 'start'.
+    bool sccSort(T start, std::vector<T> &out) const {
+        CompactCallGraph<T> compact(*this);
+        return compact.sccSort(start, out);
+    }
+    bool sort(std::vector<T> &start, std::vector<T> &out) const {
+        CompactCallGraph<T> compact(*this);
+        return compact.sort(start, out);
+    }
+    bool sort(std::vector<T> &out) const {
+        CompactCallGraph<T> compact(*this);
+        return compact.sort(out);
+    }
+};
+
+/// A frozen copy of a CallGraph in compressed-sparse-row form.
+/// Nodes are numbered densely in the (deterministic) insertion order
+/// of the source graph; the callees of node i are
+/// targets[offsets[i]] ... targets[offsets[i+1] - 1].
+/// All queries are linear in the size of the graph and non-recursive,
+/// so they can be used on graphs with many thousands of nodes.
+/// The compact graph does not track later changes to the source graph.
+template <class T>
+class CompactCallGraph {
+    std::vector<T>                  nodes;
+    std::unordered_map<T, unsigned> ids;
+    std::vector<unsigned>           offsets;
+    std::vector<unsigned>           targets;
+
+    /// State of Tarjan's algorithm, shared between several start nodes.
     struct sccInfo {
-        unsigned       crtIndex;
-        std::vector<T> stack;
-        std::set<T>    onStack;
-        std::map<T, unsigned> index;
-        std::map<T, unsigned> lowlink;
-
-        sccInfo() : crtIndex(0) {}
-        void push(T node) {
+        unsigned              crtIndex = 0;
+        std::vector<unsigned> index;
+        std::vector<unsigned> lowlink;
+        std::vector<bool>     onStack;
+        std::vector<unsigned> stack;
+
+        explicit sccInfo(size_t size) :
+                index(size, ~0U), lowlink(size, 0), onStack(size, false) {}
+        bool unknown(unsigned node) const { return index[node] == ~0U; }
+        void visit(unsigned node) {
+            index[node] = lowlink[node] = crtIndex++;
             stack.push_back(node);
-            onStack.emplace(node);
-        }
-        bool isOnStack(T node)
-        { return onStack.count(node) != 0; }
-        bool unknown(T node)
-        { return index.count(node) == 0; }
-        void setLowLink(T node, unsigned value) {
-            lowlink[node] = value;
-            LOG1(node << ".lowlink = " << value << " = " << get(lowlink, node));
-        }
-        void setLowLink(T node, T successor) {
-            unsigned nlink = get(lowlink, node);
-            unsigned slink = get(lowlink, successor);
-            if (slink < nlink)
-                setLowLink(node, slink);
-        }
-        T pop() {
-            T result = stack.back();
-            stack.pop_back();
-            onStack.erase(result);
-            return result;
+            onStack[node] = true;
         }
     };
 
-    // helper for scSort
-    bool strongConnect(T node, sccInfo& helper, std::vector<T>& out) {
+    /// Iterative version of Tarjan's strongConnect; the nodes of each
+    /// strongly-connected component are appended to 'out' in the same
+    /// order as the recursive formulation.  Returns true if a cycle is found.
+    bool strongConnect(unsigned root, sccInfo& helper, std::vector<T>& out) const {
+        struct Frame { unsigned node; unsigned edge; };
+        std::vector<Frame> work;
         bool loop = false;
 
-        LOG1("scc " << cgMakeString(node));
-        helper.index.emplace(node, helper.crtIndex);
-        helper.setLowLink(node, helper.crtIndex);
-        helper.crtIndex++;
-        helper.push(node);
-        auto oe = out_edges[node];
-        if (oe != nullptr) {
-            for (auto next : *oe) {
-                LOG1(cgMakeString(node) << " => " << cgMakeString(next));
+        helper.visit(root);
+        work.push_back(Frame{root, offsets[root]});
+        while (!work.empty()) {
+            auto& frame = work.back();
+            unsigned node = frame.node;
+            if (frame.edge < offsets[node + 1]) {
+                unsigned next = targets[frame.edge++];
                 if (helper.unknown(next)) {
-                    bool l = strongConnect(next, helper, out);
-                    loop = loop | l;
-                    helper.setLowLink(node, next);
-                } else if (helper.isOnStack(next)) {
-                    helper.setLowLink(node, next);
+                    helper.visit(next);
+                    work.push_back(Frame{next, offsets[next]});
+                } else if (helper.onStack[next]) {
+                    helper.lowlink[node] = std::min(helper.lowlink[node], helper.lowlink[next]);
                     if (next == node)
                         // the check below does not find self-loops
                         loop = true;
                 }
+                continue;
             }
-        }
 
-        if (get(helper.lowlink, node) == get(helper.index, node)) {
-            LOG1(cgMakeString(node) << " index=" << get(helper.index, node)
-                      << " lowlink=" << get(helper.lowlink, node));
-            while (true) {
-                T sccMember = helper.pop();
-                LOG1("Scc order " << cgMakeString(sccMember) << "[" << cgMakeString(node) << "]");
-                out.push_back(sccMember);
-                if (sccMember == node)
-                    break;
-                loop = true;
+            work.pop_back();
+            if (helper.lowlink[node] == helper.index[node]) {
+                while (true) {
+                    unsigned sccMember = helper.stack.back();
+                    helper.stack.pop_back();
+                    helper.onStack[sccMember] = false;
+                    LOG1("Scc order " << cgMakeString(nodes[sccMember]) <<
+                         "[" << cgMakeString(nodes[node]) << "]");
+                    out.push_back(nodes[sccMember]);
+                    if (sccMember == node)
+                        break;
+                    loop = true;
+                }
+            }
+            if (!work.empty()) {
+                unsigned parent = work.back().node;
+                helper.lowlink[parent] = std::min(helper.lowlink[parent], helper.lowlink[node]);
             }
         }
-
         return loop;
     }
 
  public:
-    // Sort that computes strongly-connected components - all nodes in
-    // a strongly-connected components will be consecutive in the
-    // sort.  Returns true if the graph contains at least one
-    // cycle.  Ignores nodes not reachable from 'start'.
-    bool sccSort(T start, std::vector<T> &out) {
-        sccInfo helper;
-        return strongConnect(start, helper, out);
+    explicit CompactCallGraph(const CallGraph<T>& graph) {
+        size_t edges = 0;
+        for (auto it : graph) {
+            ids.emplace(it.first, nodes.size());
+            nodes.push_back(it.first);
+            if (it.second != nullptr)
+                edges += it.second->size();
+        }
+        offsets.reserve(nodes.size() + 1);
+        targets.reserve(edges);
+        for (auto it : graph) {
+            offsets.push_back(targets.size());
+            if (it.second == nullptr)
+                continue;
+            for (auto callee : *it.second)
+                targets.push_back(ids.at(callee));
+        }
+        offsets.push_back(targets.size());
     }
-    bool sort(std::vector<T> &start, std::vector<T> &out) {
-        sccInfo helper;
-        bool cycles = false;
-        for (auto n : start) {
-            if (std::find(out.begin(), out.end(), n) == out.end()) {
-                bool c = strongConnect(n, helper, out);
-                cycles = cycles || c;
+
+    size_t size() const { return nodes.size(); }
+    size_t edgeCount() const { return targets.size(); }
+    bool contains(T node) const { return ids.find(node) != ids.end(); }
+    unsigned getId(T node) const {
+        auto it = ids.find(node);
+        BUG_CHECK(it != ids.end(), "%1%: Node not in graph", cgMakeString(node));
+        return it->second;
+    }
+    T getNode(unsigned id) const { return nodes.at(id); }
+    std::vector<unsigned>::const_iterator calleesBegin(unsigned id) const
+    { return targets.cbegin() + offsets.at(id); }
+    std::vector<unsigned>::const_iterator calleesEnd(unsigned id) const
+    { return targets.cbegin() + offsets.at(id + 1); }
+
+    /// @returns the ids of all nodes reachable from 'start' (including 'start').
+    bitvec reachable(unsigned start) const {
+        bitvec result;
+        std::vector<unsigned> work;
+        work.push_back(start);
+        result.setbit(start);
+        while (!work.empty()) {
+            unsigned node = work.back();
+            work.pop_back();
+            for (unsigned e = offsets[node]; e < offsets[node + 1]; e++) {
+                unsigned next = targets[e];
+                if (result.getbit(next))
+                    continue;
+                result.setbit(next);
+                work.push_back(next);
             }
         }
-        return cycles;
+        return result;
     }
-    bool sort(std::vector<T> &out) {
-        sccInfo helper;
+    // out will contain all nodes reachable from start
+    void reachable(T start, std::set<T> &out) const {
+        if (!contains(start)) {
+            out.emplace(start);
+            return;
+        }
+        for (auto id : reachable(getId(start)))
+            out.emplace(nodes[id]);
+    }
+
+    // Same specification as CallGraph::sccSort.
+    bool sccSort(T start, std::vector<T> &out) const {
+        if (!contains(start)) {
+            out.push_back(start);
+            return false;
+        }
+        sccInfo helper(nodes.size());
+        return strongConnect(getId(start), helper, out);
+    }
+    // Same specification as CallGraph::sort.  Start nodes that are
+    // not part of the graph are emitted as singleton components.
+    bool sort(const std::vector<T> &start, std::vector<T> &out) const {
+        sccInfo helper(nodes.size());
+        std::unordered_set<T> done(out.begin(), out.end());
         bool cycles = false;
-        for (auto n : nodes) {
-            if (std::find(out.begin(), out.end(), n) == out.end()) {
-                bool c = strongConnect(n, helper, out);
-                cycles = cycles || c;
+        for (auto n : start) {
+            if (done.count(n))
+                continue;
+            auto it = ids.find(n);
+            if (it == ids.end()) {
+                out.push_back(n);
+                done.emplace(n);
+                continue;
             }
+            if (!helper.unknown(it->second))
+                continue;
+            bool c = strongConnect(it->second, helper, out);
+            cycles = cycles || c;
         }
         return cycles;
     }
+    bool sort(std::vector<T> &out) const
+    { return sort(nodes, out); }
+    /// Callers appear before their callees; nodes in a
+    /// strongly-connected component are consecutive.
+    /// Returns true if the graph contains at least one cycle.
+    bool topologicalSort(std::vector<T> &out) const {
+        std::vector<T> sorted;
+        bool cycles = sort(sorted);
+        out.insert(out.end(), sorted.rbegin(), sorted.rend());
+        return cycles;
+    }
 };
 
 }  // namespace P4
@@ -43,7 +43,7 @@ StorageLocation* StorageFactory::create(const IR::Type* type, cstring name) cons
         type->is<IR::Type_Tuple>() ||
         // Also for newtype
         type->is<IR::Type_Newtype>())
-        return new BaseLocation(type, name);
+        return new BaseLocation(type, name, baseLocations++);
     if (type->is<IR::Type_StructLike>()) {
         type = typeMap->getTypeType(type, true);  // get the canonical version
         auto st = type->to<IR::Type_StructLike>();
@@ -246,10 +246,12 @@ bool LocationSet::overlaps(const LocationSet* other) const {
 }
 
 const ProgramPoints* ProgramPoints::merge(const ProgramPoints* with) const {
-    auto result = new ProgramPoints(points);
-    for (auto p : with->points)
-        result->points.emplace(p);
-    return result;
+    if (points.contains(with->points))
+        return this;
+    if (with->points.contains(points))
+        return with;
+    BUG_CHECK(numbering == with->numbering, "Merging program points of different analyses");
+    return new ProgramPoints(numbering, points | with->points);
 }
 
 ProgramPoint::ProgramPoint(const ProgramPoint &context, const IR::Node* node) {
@@ -273,49 +275,80 @@ std::size_t ProgramPoint::hash() const {
     return result;
 }
 
-bool ProgramPoints::operator==(const ProgramPoints& other) const {
-    if (points.size() != other.points.size())
-        return false;
-    for (auto p : points)
-        if (other.points.find(p) == other.points.end())
-            return false;
-    return true;
+void ProgramPointNumbering::clear() {
+    ids.clear();
+    points.clear();
+    // beforeStart must be number 0.
+    id(ProgramPoint::beforeStart);
+}
+
+unsigned ProgramPointNumbering::id(const ProgramPoint& point) {
+    auto it = ids.find(point);
+    if (it != ids.end())
+        return it->second;
+    unsigned result = points.size();
+    ids.emplace(point, result);
+    points.push_back(point);
+    return result;
+}
+
+const ProgramPoint& ProgramPointNumbering::point(unsigned id) const {
+    BUG_CHECK(id < points.size(), "%1%: unknown program point number", id);
+    return points.at(id);
 }
 
 Definitions* Definitions::join(const Definitions* other) const {
+    // Both maps are indexed by location number, so this is a linear merge.
     auto result = new Definitions();
-    for (auto d : other->definitions) {
-        auto loc = d.first;
-        auto defs = d.second;
-        auto current = ::get(definitions, loc);
-        if (current != nullptr) {
-            auto merged = current->merge(defs);
-            result->definitions.emplace(loc, merged);
-        } else {
-            result->definitions.emplace(loc, defs);
+    size_t size = std::max(definitions.size(), other->definitions.size());
+    result->definitions.resize(size);
+    for (size_t i = 0; i < size; i++) {
+        const BaseLocation* loc = nullptr;
+        const ProgramPoints* current = nullptr;
+        const ProgramPoints* defs = nullptr;
+        if (i < definitions.size()) {
+            loc = definitions[i].first;
+            current = definitions[i].second;
         }
-    }
-    for (auto d : definitions) {
-        auto loc = d.first;
-        auto defs = d.second;
-        auto current = ::get(other->definitions, loc);
+        if (i < other->definitions.size() && other->definitions[i].second != nullptr) {
+            loc = other->definitions[i].first;
+            defs = other->definitions[i].second;
+        }
+        const ProgramPoints* merged;
         if (current == nullptr)
-            result->definitions.emplace(loc, defs);
-        // otherwise have have already done it in the loop above
+            merged = defs;
+        else if (defs == nullptr || current == defs)
+            merged = current;
+        else
+            merged = current->merge(defs);
+        if (merged == nullptr)
+            continue;
+        result->definitions[i] = std::make_pair(loc, merged);
+        result->count++;
     }
     return result;
 }
 
+void Definitions::set(const BaseLocation* loc, const ProgramPoints* point) {
+    CHECK_NULL(loc); CHECK_NULL(point);
+    if (loc->id >= definitions.size())
+        definitions.resize(loc->id + 1);
+    auto& entry = definitions[loc->id];
+    if (entry.second == nullptr)
+        count++;
+    entry = std::make_pair(loc, point);
+}
+
 void Definitions::set(const StorageLocation* location, const ProgramPoints* point) {
     LocationSet locset;
     locset.addCanonical(location);
     for (auto sl : locset)
-        definitions[sl->to<BaseLocation>()] = point;
+        set(sl->to<BaseLocation>(), point);
 }
 
 void Definitions::set(const LocationSet* locations, const ProgramPoints* point) {
     for (auto sl : *locations->canonicalize())
-        definitions[sl->to<BaseLocation>()] = point;
+        set(sl->to<BaseLocation>(), point);
 }
 
 void Definitions::remove(const StorageLocation* location) {
@@ -323,9 +356,10 @@ void Definitions::remove(const StorageLocation* location) {
     loc->addCanonical(location);
     for (auto sl : *loc) {
         auto bl = sl->to<BaseLocation>();
-        auto it = definitions.find(bl);
-        if (it != definitions.end())
-            definitions.erase(it);
+        if (bl->id < definitions.size() && definitions[bl->id].second != nullptr) {
+            definitions[bl->id] = std::make_pair(nullptr, nullptr);
+            count--;
+        }
     }
 }
 
@@ -338,10 +372,9 @@ const ProgramPoints* Definitions::get(const LocationSet* locations) const {
     return result;
 }
 
-Definitions* Definitions::writes(ProgramPoint point, const LocationSet* locations) const {
+Definitions* Definitions::writes(const ProgramPoints* points,
+                                 const LocationSet* locations) const {
     auto result = new Definitions(*this);
-    auto points = new ProgramPoints();
-    points->add(point);
     auto canon = locations->canonicalize();
     for (auto l : *canon)
         result->set(l->to<BaseLocation>(), points);
@@ -349,13 +382,17 @@ Definitions* Definitions::writes(ProgramPoint point, const LocationSet* location
 }
 
 bool Definitions::operator==(const Definitions& other) const {
-    if (definitions.size() != other.definitions.size())
+    if (count != other.count)
         return false;
-    for (auto d : definitions) {
-        auto od = ::get(other.definitions, d.first);
-        if (od == nullptr)
+    size_t size = std::max(definitions.size(), other.definitions.size());
+    for (size_t i = 0; i < size; i++) {
+        auto d = i < definitions.size() ? definitions[i].second : nullptr;
+        auto od = i < other.definitions.size() ? other.definitions[i].second : nullptr;
+        if (d == od)
+            continue;
+        if (d == nullptr || od == nullptr)
             return false;
-        if (!d.second->operator==(*od))
+        if (!(*d == *od))
             return false;
     }
     return true;
@@ -376,8 +413,8 @@ void ComputeWriteSet::enterScope(const IR::ParameterList* parameters,
     if (defs == nullptr)
         defs = new Definitions();
 
-    auto startPoints = new ProgramPoints(entryPoint);
-    auto uninit = new ProgramPoints(ProgramPoint::beforeStart);
+    auto startPoints = pointsAt(entryPoint);
+    auto uninit = pointsAt(ProgramPoint::beforeStart);
 
     if (parameters != nullptr) {
         for (auto p : parameters->parameters) {
@@ -446,6 +483,13 @@ Definitions* ComputeWriteSet::getDefinitionsAfter(const IR::ParserState* state)
     return definitions->get(last);
 }
 
+Visitor::profile_t ComputeWriteSet::init_apply(const IR::Node* node) {
+    // Each run numbers its program points from scratch
+    if (!nested)
+        definitions->clear();
+    return Inspector::init_apply(node);
+}
+
 // if node is nullptr, use getOriginal().
 ProgramPoint ComputeWriteSet::getProgramPoint(const IR::Node* node) const {
     if (node == nullptr) {
@@ -766,7 +810,7 @@ bool ComputeWriteSet::preorder(const IR::IfStatement* statement) {
     visit(statement->condition);
     auto cond = get(statement->condition);
     // defs are the definitions after evaluating the condition
-    auto defs = currentDefinitions->writes(getProgramPoint(), cond);
+    auto defs = currentDefinitions->writes(pointsAt(getProgramPoint()), cond);
     (void)setDefinitions(defs, statement->condition);
     visit(statement->ifTrue);
     auto result = currentDefinitions;
@@ -810,7 +854,7 @@ bool ComputeWriteSet::preorder(const IR::AssignmentStatement* statement) {
     auto l = get(statement->left);
     auto r = get(statement->right);
     locs = l->join(r);
-    auto defs = currentDefinitions->writes(getProgramPoint(), locs);
+    auto defs = currentDefinitions->writes(pointsAt(getProgramPoint()), locs);
     return setDefinitions(defs);
 }
 
@@ -818,7 +862,7 @@ bool ComputeWriteSet::preorder(const IR::SwitchStatement* statement) {
     LOG3("CWS Visiting " << dbp(statement));
     visit(statement->expression);
     auto locs = get(statement->expression);
-    auto defs = currentDefinitions->writes(getProgramPoint(), locs);
+    auto defs = currentDefinitions->writes(pointsAt(getProgramPoint()), locs);
     (void)setDefinitions(defs, statement->expression);
     auto save = currentDefinitions;
     auto result = new Definitions();
@@ -921,7 +965,7 @@ bool ComputeWriteSet::preorder(const IR::MethodCallStatement* statement) {
     lhs = false;
     visit(statement->methodCall);
     auto locs = get(statement->methodCall);
-    auto defs = currentDefinitions->writes(getProgramPoint(), locs);
+    auto defs = currentDefinitions->writes(pointsAt(getProgramPoint()), locs);
     return setDefinitions(defs);
 }
 
@@ -18,6 +18,7 @@ limitations under the License.
 #define _FRONTENDS_P4_DEF_USE_H_
 
 #include "ir/ir.h"
+#include "lib/bitvec.h"
 #include "frontends/p4/typeChecking/typeChecker.h"
 
 namespace P4 {
@@ -64,10 +65,13 @@ class StorageLocation : public IHasDbPrint {
     It could be either a scalar variable, or a field of a struct, etc. */
 class BaseLocation : public StorageLocation {
  public:
+    /// Dense number of this location within its StorageFactory;
+    /// used to index per-location tables such as Definitions.
+    const unsigned id;
     // We can use this for tuples because tuples have no field accessors,
     // so we treat them as monolithic objects.
-    BaseLocation(const IR::Type* type, cstring name) :
-            StorageLocation(type, name)
+    BaseLocation(const IR::Type* type, cstring name, unsigned id) :
+            StorageLocation(type, name), id(id)
     { BUG_CHECK(type->is<IR::Type_Bits>() || type->is<IR::Type_Enum>() ||
                 type->is<IR::Type_Boolean>() || type->is<IR::Type_Var>() ||
                 type->is<IR::Type_Tuple>() || type->is<IR::Type_Error>() ||
@@ -144,6 +148,8 @@ class ArrayLocation : public StorageLocation {
 
 class StorageFactory {
     TypeMap* typeMap;
+    /// Number of BaseLocations allocated so far.
+    mutable unsigned baseLocations = 0;
  public:
     explicit StorageFactory(TypeMap* typeMap) : typeMap(typeMap)
     { CHECK_NULL(typeMap); }
@@ -276,58 +282,102 @@ template<> struct hash<P4::ProgramPoint> {
 }  // namespace std
 
 namespace P4 {
+/// Dense numbers for the program points of one analysis, used to
+/// represent sets of program points as bitvectors.
+/// beforeStart is always number 0.
+class ProgramPointNumbering {
+    std::unordered_map<ProgramPoint, unsigned> ids;
+    std::vector<ProgramPoint> points;
+
+ public:
+    ProgramPointNumbering() { clear(); }
+    unsigned id(const ProgramPoint& point);
+    /// Inverse of id().
+    const ProgramPoint& point(unsigned id) const;
+    void clear();
+};
+
+/// A set of program points, represented as a bitvector indexed by
+/// the number of each point.
 class ProgramPoints : public IHasDbPrint {
-    typedef std::unordered_set<ProgramPoint> Points;
-    Points points;
-    explicit ProgramPoints(const Points &points) : points(points) {}
+    /// nullptr only for an empty set, which may be merged with any set
+    ProgramPointNumbering* numbering = nullptr;
+    bitvec points;
+    ProgramPoints(ProgramPointNumbering* numbering, const bitvec &points) :
+            numbering(numbering), points(points) {}
+
  public:
+    class const_iterator {
+        const ProgramPointNumbering* numbering;
+        bitvec::const_iterator it;
+     public:
+        const_iterator(const ProgramPointNumbering* numbering, bitvec::const_iterator it) :
+                numbering(numbering), it(it) {}
+        const ProgramPoint& operator*() const { return numbering->point(*it); }
+        const_iterator& operator++() { ++it; return *this; }
+        bool operator==(const const_iterator& other) const { return it == other.it; }
+        bool operator!=(const const_iterator& other) const { return it != other.it; }
+    };
+
     ProgramPoints() = default;
-    explicit ProgramPoints(ProgramPoint point) { points.emplace(point); }
-    void add(ProgramPoint point) { points.emplace(point); }
+    explicit ProgramPoints(ProgramPointNumbering* numbering) : numbering(numbering)
+    { CHECK_NULL(numbering); }
+    ProgramPoints(ProgramPointNumbering* numbering, const ProgramPoint& point) :
+            numbering(numbering)
+    { CHECK_NULL(numbering); points.setbit(numbering->id(point)); }
+    void add(const ProgramPoint& point) {
+        BUG_CHECK(numbering != nullptr, "%1%: adding to a set without numbering", &point);
+        points.setbit(numbering->id(point)); }
     const ProgramPoints* merge(const ProgramPoints* with) const;
-    bool operator==(const ProgramPoints& other) const;
+    bool operator==(const ProgramPoints& other) const { return points == other.points; }
     void dbprint(std::ostream& out) const {
         out << "{";
-        for (auto p : points)
+        for (auto p : *this)
             out << p << " ";
         out << "}";
     }
-    size_t size() const { return points.size(); }
+    size_t size() const { return points.popcount(); }
     bool containsBeforeStart() const
-    { return points.find(ProgramPoint::beforeStart) != points.end(); }
-    Points::const_iterator begin() const
-    { return points.cbegin(); }
-    Points::const_iterator end() const
-    { return points.cend(); }
+    { return points.getbit(0); }
+    const_iterator begin() const
+    { return const_iterator(numbering, points.begin()); }
+    const_iterator end() const
+    { return const_iterator(numbering, points.end()); }
 };
 
 /// List of definers for each base storage (at a specific program point).
 class Definitions : public IHasDbPrint {
     /// Set of program points that have written last to each location
-    /// (conservative approximation).
-    std::map<const BaseLocation*, const ProgramPoints*> definitions;
+    /// (conservative approximation).  Indexed by BaseLocation::id;
+    /// locations without definitions have a nullptr entry.
+    std::vector<std::pair<const BaseLocation*, const ProgramPoints*>> definitions;
+    /// Number of non-null entries in definitions.
+    size_t count = 0;
 
  public:
     Definitions() = default;
-    Definitions(const Definitions& other) : definitions(other.definitions) {}
+    Definitions(const Definitions& other) : definitions(other.definitions), count(other.count) {}
     Definitions* join(const Definitions* other) const;
-    /// Point writes the specified LocationSet.
-    Definitions* writes(ProgramPoint point, const LocationSet* locations) const;
-    void set(const BaseLocation* loc, const ProgramPoints* point)
-    { CHECK_NULL(loc); CHECK_NULL(point); definitions[loc] = point; }
+    /// Points write the specified LocationSet.
+    Definitions* writes(const ProgramPoints* points, const LocationSet* locations) const;
+    void set(const BaseLocation* loc, const ProgramPoints* point);
     void set(const StorageLocation* loc, const ProgramPoints* point);
     void set(const LocationSet* loc, const ProgramPoints* point);
     const ProgramPoints* get(const BaseLocation* location) const {
-        auto r = ::get(definitions, location);
+        const ProgramPoints* r = nullptr;
+        if (location->id < definitions.size())
+            r = definitions[location->id].second;
         BUG_CHECK(r != nullptr, "%1%: no definitions", location);
         return r; }
     const ProgramPoints* get(const LocationSet* locations) const;
     bool operator==(const Definitions& other) const;
     void dbprint(std::ostream& out) const {
-        if (definitions.empty())
+        if (empty())
             out << "  Empty definitions";
         bool first = true;
         for (auto d : definitions) {
+            if (d.second == nullptr)
+                continue;
             if (!first)
                 out << std::endl;
             out << "  " << *d.first << "=>" << *d.second;
@@ -336,7 +386,7 @@ class Definitions : public IHasDbPrint {
     }
     Definitions* clone() const { return new Definitions(*this); }
     void remove(const StorageLocation* loc);
-    bool empty() const { return definitions.empty(); }
+    bool empty() const { return count == 0; }
 };
 
 class AllDefinitions : public IHasDbPrint {
@@ -347,8 +397,12 @@ class AllDefinitions : public IHasDbPrint {
 
  public:
     StorageMap* storageMap;
+    /// Numbers of the program points used by the definitions.
+    ProgramPointNumbering numbering;
     AllDefinitions(ReferenceMap* refMap, TypeMap* typeMap) :
             storageMap(new StorageMap(refMap, typeMap)) {}
+    /// Forget all definitions and program point numbers.
+    void clear() { atPoint.clear(); numbering.clear(); }
     Definitions* get(ProgramPoint point, bool emptyIfNotFound = false) {
         auto it = atPoint.find(point);
         if (it == atPoint.end()) {
@@ -389,6 +443,8 @@ class ComputeWriteSet : public Inspector {
     const StorageMap*   storageMap;
     /// if true we are processing an expression on the lhs of an assignment
     bool                lhs;
+    /// true for the visitors created to process program fragments
+    bool                nested;
     /// For each expression the location set it writes
     std::map<const IR::Expression*, const LocationSet*> writes;
 
@@ -397,7 +453,8 @@ class ComputeWriteSet : public Inspector {
     ComputeWriteSet(const ComputeWriteSet* source, ProgramPoint context, Definitions* definitions) :
             definitions(source->definitions), currentDefinitions(definitions),
             returnedDefinitions(nullptr), exitDefinitions(source->exitDefinitions),
-            callingContext(context), storageMap(source->storageMap), lhs(false) {
+            callingContext(context), storageMap(source->storageMap), lhs(false),
+            nested(true) {
         setName("ComputeWriteSet");
     }
     void enterScope(const IR::ParameterList* parameters,
@@ -408,6 +465,8 @@ class ComputeWriteSet : public Inspector {
     Definitions* getDefinitionsAfter(const IR::ParserState* state);
     bool setDefinitions(Definitions* defs, const IR::Node* who = nullptr);
     ProgramPoint getProgramPoint(const IR::Node* node = nullptr) const;
+    const ProgramPoints* pointsAt(ProgramPoint point) const
+    { return new ProgramPoints(&definitions->numbering, point); }
     const LocationSet* get(const IR::Expression* expression) const {
         auto result = ::get(writes, expression);
         BUG_CHECK(result != nullptr, "No location set known for %1%", expression);
@@ -422,8 +481,9 @@ class ComputeWriteSet : public Inspector {
     explicit ComputeWriteSet(AllDefinitions* definitions) :
             definitions(definitions), currentDefinitions(nullptr),
             returnedDefinitions(nullptr), exitDefinitions(nullptr),
-            storageMap(definitions->storageMap), lhs(false)
+            storageMap(definitions->storageMap), lhs(false), nested(false)
     { CHECK_NULL(definitions); setName("ComputeWriteSet"); }
+    Visitor::profile_t init_apply(const IR::Node* node) override;
 
     // expressions
     bool preorder(const IR::Literal* expression) override;
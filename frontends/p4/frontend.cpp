@@ -169,7 +169,7 @@ const IR::P4Program *FrontEnd::run(const CompilerOptions &options, const IR::P4P
         new RemoveAllUnusedDeclarations(&refMap),
         new ClearTypeMap(&typeMap),
         evaluator,
-        new Inline(&refMap, &typeMap, evaluator),
+        new Inline(&refMap, &typeMap, evaluator, options.inlineByLevel),
         new InlineActions(&refMap, &typeMap),
         // Check for constants only after inlining
         new CheckConstants(&refMap, &typeMap),
@@ -336,22 +336,60 @@ void InlineWorkList::analyze(bool allowMultipleCalls) {
     // must inline from leaves up
     std::vector<const IR::IContainer*> order;
     cg.sort(order);
+
+    // Compute a bottom-up schedule: a caller can be processed as soon
+    // as all its callees have had their own callees inlined.  All the
+    // callers on the same level are inlined in a single sweep.
+    std::map<const IR::IContainer*, unsigned> callerLevel;
     for (auto c : order) {
-        // This is quadratic, but hopefully the call graph is not too large
-        for (auto m : inlineMap) {
-            auto inl = m.second;
-            if (inl->caller == c)
-                toInline.push_back(inl);
+        if (!byLevel || !cg.isCaller(c))
+            continue;
+        unsigned level = 0;
+        for (auto callee : *cg.getCallees(c)) {
+            auto it = callerLevel.find(callee);
+            if (it != callerLevel.end())
+                level = std::max(level, it->second + 1);
         }
+        callerLevel.emplace(c, level);
     }
 
+    std::map<const IR::IContainer*, std::vector<CallInfo*>> byCaller;
+    for (auto m : inlineMap)
+        byCaller[m.second->caller].push_back(m.second);
+    for (auto c : order) {
+        auto it = byCaller.find(c);
+        if (it == byCaller.end())
+            continue;
+        for (auto inl : it->second) {
+            toInline.push_back(inl);
+            level.emplace(inl, ::get(callerLevel, c));
+        }
+    }
+
+    // next() consumes the vector from the back, lowest level first.
     std::reverse(toInline.begin(), toInline.end());
+    if (byLevel)
+        std::stable_sort(toInline.begin(), toInline.end(),
+                         [this](const CallInfo* left, const CallInfo* right) {
+                             return level.at(left) > level.at(right); });
 }
 
 InlineSummary* InlineWorkList::next() {
     if (toInline.size() == 0)
         return nullptr;
     auto result = new InlineSummary();
+    if (byLevel) {
+        unsigned crtLevel = level.at(toInline.back());
+        while (!toInline.empty()) {
+            auto toadd = toInline.back();
+            if (level.at(toadd) != crtLevel)
+                break;
+            toInline.pop_back();
+            result->add(toadd);
+        }
+        return result;
+    }
+
     std::set<const IR::IContainer*> processing;
     while (!toInline.empty()) {
         auto toadd = toInline.back();
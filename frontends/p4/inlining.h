@@ -136,8 +136,18 @@ class InlineWorkList {
     // We use an ordered map to make the iterator deterministic
     ordered_map<const IR::Declaration_Instance*, CallInfo*> inlineMap;
     std::vector<CallInfo*> toInline;  // sorted in order of inlining
+    /// If true the calls are scheduled by level: next() returns all the
+    /// calls whose callees have had their own callees inlined.
+    /// Otherwise next() stops at the first call that depends on a call
+    /// it already returned.
+    bool byLevel;
+    /// Sweep in which each call is inlined; all calls with the same
+    /// level are independent and are returned together by next().
+    std::map<const CallInfo*, unsigned> level;
 
  public:
+    explicit InlineWorkList(bool byLevel = false) : byLevel(byLevel) {}
+
     void addInstantiation(const IR::IContainer* caller, const IR::IContainer* callee,
                           const IR::Declaration_Instance* instantiation) {
         CHECK_NULL(caller); CHECK_NULL(callee); CHECK_NULL(instantiation);
@@ -167,6 +177,8 @@ class InlineWorkList {
     }
 
     void analyze(bool allowMultipleCalls);
+    /// @returns all the calls that can be inlined in the next sweep,
+    /// or nullptr when all inlining is done.
     InlineSummary* next();
 };
 
@@ -263,7 +275,8 @@ class GeneralInliner : public AbstractInliner {
 class InlinePass : public PassManager {
     InlineWorkList toInline;
  public:
-    InlinePass(ReferenceMap* refMap, TypeMap* typeMap, EvaluatorPass* evaluator) {
+    InlinePass(ReferenceMap* refMap, TypeMap* typeMap, EvaluatorPass* evaluator,
+               bool byLevel = false) : toInline(byLevel) {
         passes.push_back(new TypeChecking(refMap, typeMap));
         passes.push_back(new DiscoverInlining(&toInline, refMap, typeMap, evaluator));
         passes.push_back(new InlineDriver(&toInline, new P4::GeneralInliner(refMap->isV1())));
@@ -276,11 +289,15 @@ class InlinePass : public PassManager {
 Performs inlining as many times as necessary.  Most frequently once
 will be enough.  Multiple iterations are necessary only when instances are
 passed as arguments using constructor arguments.
+With 'byLevel' each sweep of the inliner inlines all the calls whose
+callees are done, so the number of sweeps is the depth of the
+hierarchy of parsers and controls.
 */
 class Inline : public PassRepeated {
  public:
-    Inline(ReferenceMap* refMap, TypeMap* typeMap, EvaluatorPass* evaluator) {
-        passes.push_back(new InlinePass(refMap, typeMap, evaluator));
+    Inline(ReferenceMap* refMap, TypeMap* typeMap, EvaluatorPass* evaluator,
+           bool byLevel = false) {
+        passes.push_back(new InlinePass(refMap, typeMap, evaluator, byLevel));
         // After inlining the output of the evaluator changes, so
         // we have to run it again
         passes.push_back(evaluator);
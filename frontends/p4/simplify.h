@@ -54,7 +54,8 @@ class DoSimplifyControlFlow : public Transform {
  public:
     DoSimplifyControlFlow(ReferenceMap* refMap, TypeMap* typeMap) :
             refMap(refMap), typeMap(typeMap)
-    { CHECK_NULL(refMap); CHECK_NULL(typeMap); setName("DoSimplifyControlFlow"); }
+    { CHECK_NULL(refMap); CHECK_NULL(typeMap); setName("DoSimplifyControlFlow");
+      declarationLocal = true; }
     const IR::Node* postorder(IR::BlockStatement* statement) override;
     const IR::Node* postorder(IR::IfStatement* statement) override;
     const IR::Node* postorder(IR::EmptyStatement* statement) override;
@@ -69,6 +70,7 @@ class SimplifyControlFlow : public PassRepeated {
         passes.push_back(new TypeChecking(refMap, typeMap));
         passes.push_back(new DoSimplifyControlFlow(refMap, typeMap));
         setName("SimplifyControlFlow");
+        setChangeDriven();
     }
 };
 
@@ -28,6 +28,21 @@ limitations under the License.
 namespace P4 {
 
 namespace {
+// Checks whether a type contains no type variables (or other types
+// whose unification may depend on the current substitution).
+class IsGroundType : public Inspector {
+ public:
+    bool ground = true;
+    IsGroundType() { setName("IsGroundType"); }
+    bool preorder(const IR::Node*) override { return ground; }
+    bool preorder(const IR::Type_Var*) override { ground = false; return false; }
+    bool preorder(const IR::Type_InfInt*) override { ground = false; return false; }
+    bool preorder(const IR::Type_Name*) override { ground = false; return false; }
+    bool preorder(const IR::Type_MethodCall*) override { ground = false; return false; }
+    bool preorder(const IR::Type_Dontcare*) override { ground = false; return false; }
+    bool preorder(const IR::Type_Unknown*) override { ground = false; return false; }
+};
+
 // Used to set the type of Constants after type inference
 class ConstantTypeSubstitution : public Transform {
     TypeVariableSubstitution* subst;
@@ -129,6 +144,9 @@ Visitor::profile_t TypeInference::init_apply(const IR::Node* node) {
         LOG2("TypeInference for " << dbp(node));
     }
     initialNode = node;
+    // the cache survives, but its statistics are those of this run
+    unifyCacheHits = 0;
+    unifyCacheMisses = 0;
     refMap->validateMap(node);
     return Transform::init_apply(node);
 }
@@ -150,6 +168,11 @@ void TypeInference::end_apply(const IR::Node* node) {
         LOG3("Typemap: " << std::endl << typeMap);
 }
 
+std::string TypeInference::profile_stats() const {
+    return " unification cache " + std::to_string(unifyCacheHits) + " hits " +
+            std::to_string(unifyCacheMisses) + " misses";
+}
+
 bool TypeInference::done() const {
     auto orig = getOriginal();
     bool done = typeMap->contains(orig);
@@ -198,13 +221,35 @@ TypeVariableSubstitution* TypeInference::unify(const IR::Node* errorPosition,
     if (srcType == destType)
         return new TypeVariableSubstitution();
 
+    bool ground = isGroundType(destType) && isGroundType(srcType);
+    if (ground) {
+        if (unifiedGroundTypes.count(std::make_pair(destType, srcType))) {
+            unifyCacheHits++;
+            return new TypeVariableSubstitution();
+        }
+        unifyCacheMisses++;
+    }
+
     TypeConstraints constraints(typeMap->getSubstitutions());
     constraints.addEqualityConstraint(destType, srcType);
     auto tvs = constraints.solve(errorPosition, reportErrors);
     addSubstitutions(tvs);
+    // Only successful unifications are cached: failures must report errors each time.
+    if (ground && tvs != nullptr && tvs->isIdentity())
+        unifiedGroundTypes.emplace(destType, srcType);
     return tvs;
 }
 
+bool TypeInference::isGroundType(const IR::Type* type) {
+    auto it = groundTypes.find(type);
+    if (it != groundTypes.end())
+        return it->second;
+    IsGroundType checker;
+    (void)type->apply(checker);
+    groundTypes.emplace(type, checker.ground);
+    return checker.ground;
+}
+
 const IR::IndexedVector<IR::StructField>*
 TypeInference::canonicalizeFields(const IR::Type_StructLike* type) {
     bool changes = false;
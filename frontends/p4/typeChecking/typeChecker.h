@@ -75,6 +75,17 @@ class TypeInference : public Transform {
     std::vector<int> methodArguments;
     const IR::Node* initialNode;
 
+    // Memoization of unify() for ground types (types without any
+    // type variables).  The result of unifying two ground types does
+    // not depend on the current substitution, so successful
+    // unifications can be cached by type identity.
+    std::map<const IR::Type*, bool> groundTypes;
+    std::set<std::pair<const IR::Type*, const IR::Type*>> unifiedGroundTypes;
+    // Cache statistics of the current run, reported in the pass profile
+    unsigned unifyCacheHits = 0;
+    unsigned unifyCacheMisses = 0;
+    bool isGroundType(const IR::Type* type);
+
  public:
     // If readOnly=true it will assert that it behaves like
     // an Inspector.
@@ -271,6 +282,7 @@ class TypeInference : public Transform {
 
     Visitor::profile_t init_apply(const IR::Node* node) override;
     void end_apply(const IR::Node* Node) override;
+    std::string profile_stats() const override;
 };
 
 // Copy types from the typeMap to expressions.  Updates the typeMap with newly created nodes
@@ -18,6 +18,9 @@ limitations under the License.
 #define _IR_NODE_H_
 
 #include <memory>
+#ifdef MULTITHREAD
+#include <atomic>
+#endif  // MULTITHREAD
 #include "lib/cstring.h"
 #include "lib/stringify.h"
 #include "lib/indent.h"
@@ -40,6 +43,14 @@ class Annotation;
 
 template<class T> class Vector;
 template<class T> class IndexedVector;
+
+#ifdef MULTITHREAD
+// Nodes are also created by the threads converting BMv2 programs
+typedef std::atomic<int> IdCounter;
+#else
+typedef int IdCounter;
+#endif  // MULTITHREAD
+
 // node interface
 class INode : public Util::IHasSourceInfo, public IHasDbPrint {
  public:
@@ -70,7 +81,7 @@ class Node : public virtual INode {
     virtual void apply_visitor_revisit(Transform &v, const Node *n) const;
 
  protected:
-    static int currentId;
+    static IdCounter currentId;
     void traceVisit(const char* visitor) const;
     virtual void visit_children(Visitor &) { }
     virtual void visit_children(Visitor &) const { }
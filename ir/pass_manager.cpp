@@ -96,23 +96,113 @@ void PassManager::runDebugHooks(const char* visitorName, const IR::Node* program
         h(name(), seqNo, visitorName, program);
 }
 
+namespace {
+class CollectNames : public Inspector {
+    std::set<cstring> &names;
+ public:
+    explicit CollectNames(std::set<cstring> &names) : names(names) {}
+    void postorder(const IR::PathExpression *path) override { names.insert(path->path->name); }
+    void postorder(const IR::Type_Name *type) override { names.insert(type->path->name); }
+};
+
+cstring declarationName(const IR::Node *node) {
+    if (auto decl = node->to<IR::IDeclaration>())
+        return decl->getName().name;
+    return cstring();
+}
+}  // namespace
+
+// Computes the top-level declarations of 'after' that can be skipped in the
+// next iteration: they were not changed by the last iteration and do not
+// (transitively) name any declaration that was.  Returns their number.
+unsigned PassRepeated::unchangedDeclarations(const IR::Node *before, const IR::Node *after,
+                                             std::unordered_set<const IR::Node *> &unchanged) {
+    unchanged.clear();
+    auto oldProgram = before->to<IR::P4Program>();
+    auto newProgram = after->to<IR::P4Program>();
+    if (oldProgram == nullptr || newProgram == nullptr)
+        return 0;
+
+    std::unordered_set<const IR::Node *> oldObjects(oldProgram->declarations.begin(),
+                                                    oldProgram->declarations.end());
+    std::unordered_set<const IR::Node *> newObjects(newProgram->declarations.begin(),
+                                                    newProgram->declarations.end());
+    std::set<cstring> changedNames;
+    std::vector<const IR::Node *> candidates;
+    for (auto obj : newProgram->declarations) {
+        if (oldObjects.count(obj))
+            candidates.push_back(obj);
+        else
+            changedNames.insert(declarationName(obj));
+    }
+    for (auto obj : oldProgram->declarations)
+        if (!newObjects.count(obj))
+            changedNames.insert(declarationName(obj));
+
+    // Propagate changes to the declarations that name changed ones.
+    std::unordered_set<const IR::Node *> dirty;
+    bool grew = true;
+    while (grew) {
+        grew = false;
+        for (auto obj : candidates) {
+            if (dirty.count(obj))
+                continue;
+            auto it = namesUsed.find(obj);
+            if (it == namesUsed.end()) {
+                it = namesUsed.emplace(obj, std::set<cstring>()).first;
+                CollectNames collect(it->second);
+                obj->apply(collect);
+            }
+            for (auto n : it->second) {
+                if (changedNames.count(n)) {
+                    dirty.insert(obj);
+                    changedNames.insert(declarationName(obj));
+                    grew = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (auto obj : candidates)
+        if (!dirty.count(obj))
+            unchanged.insert(obj);
+    return unchanged.size();
+}
+
 const IR::Node *PassRepeated::apply_visitor(const IR::Node *program, const char *name) {
     bool done = false;
-    unsigned iterations = 0;
+    unsigned skipped = 0;
+    std::unordered_set<const IR::Node *> unchanged;
+    iterations = 0;
     while (!done) {
         LOG5("PassRepeated state is:\n" << dumpToString(program));
         running = true;
+        if (changeDriven)
+            setUnchangedDeclarations(iterations > 0 ? &unchanged : nullptr);
         auto newprogram = PassManager::apply_visitor(program, name);
         if (program == newprogram || newprogram == nullptr)
             done = true;
         int errors = ::errorCount();
-        if (stop_on_error && errors > 0)
+        if (stop_on_error && errors > 0) {
+            if (changeDriven)
+                setUnchangedDeclarations(nullptr);
             return nullptr;
+        }
         iterations++;
         if (repeats != 0 && iterations > repeats)
             done = true;
+        if (changeDriven && !done)
+            skipped += unchangedDeclarations(program, newprogram, unchanged);
         program = newprogram;
     }
+    if (changeDriven) {
+        setUnchangedDeclarations(nullptr);
+        namesUsed.clear();
+    }
+    LOG2(this->name() << " converged after " << iterations << " iterations");
+    if (changeDriven)
+        LOG2(this->name() << " skipped " << skipped << " unchanged declarations");
     return program;
 }
 
@@ -17,6 +17,7 @@ limitations under the License.
 #ifndef _IR_PASS_MANAGER_H_
 #define _IR_PASS_MANAGER_H_
 
+#include <set>
 #include "visitor.h"
 
 typedef std::function<void(const char* manager, unsigned seqNo,
@@ -53,17 +54,33 @@ class PassManager : virtual public Visitor, virtual public Backtrack {
     void addDebugHooks(std::vector<DebugHook> hooks)
     { debugHooks.insert(debugHooks.end(), hooks.begin(), hooks.end()); }
     void early_exit() { early_exit_flag = true; }
+    void setUnchangedDeclarations(const std::unordered_set<const IR::Node *> *decls) override {
+        for (auto v : passes)
+            v->setUnchangedDeclarations(decls); }
 };
 
 // Repeat a pass until convergence (or up to a fixed number of repeats)
+// In change-driven mode each iteration after the first one lets the
+// declarationLocal passes skip the top-level declarations of the P4Program
+// that did not change in the previous iteration and do not name a
+// declaration that did.
 class PassRepeated : virtual public PassManager {
     unsigned            repeats;  // 0 = until convergence
+    bool                changeDriven = false;
+    unsigned            iterations = 0;  // in the last apply
+    // names used by each top-level declaration seen so far
+    std::unordered_map<const IR::Node *, std::set<cstring>> namesUsed;
+    unsigned unchangedDeclarations(const IR::Node *before, const IR::Node *after,
+                                   std::unordered_set<const IR::Node *> &unchanged);
  public:
     PassRepeated() : PassRepeated({}) {}
     PassRepeated(const std::initializer_list<Visitor *> &init) :
             PassManager(init), repeats(0) { setName("PassRepeated"); }
     const IR::Node *apply_visitor(const IR::Node *, const char * = 0) override;
     PassRepeated *setRepeats(unsigned repeats) { this->repeats = repeats; return this; }
+    PassRepeated *setChangeDriven(bool changeDriven = true)
+    { this->changeDriven = changeDriven; return this; }
+    unsigned getIterations() const { return iterations; }
 };
 
 class PassRepeatUntil : virtual public PassManager {
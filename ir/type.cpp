@@ -16,6 +16,11 @@ limitations under the License.
 
 #include "ir.h"
 
+#ifdef MULTITHREAD
+#include <mutex>
+static std::mutex bitsLock;
+#endif  // MULTITHREAD
+
 namespace IR {
 
 const cstring IR::Type_Stack::next = "next";
@@ -42,12 +47,15 @@ const cstring IR::Annotation::optionalAnnotation = "optional";
 std::map<int, const IR::Type_Bits*> *Type_Bits::signedTypes = nullptr;
 std::map<int, const IR::Type_Bits*> *Type_Bits::unsignedTypes = nullptr;
 
-int Type_Declaration::nextId = 0;
-int Type_InfInt::nextId = 0;
+IdCounter Type_Declaration::nextId(0);
+IdCounter Type_InfInt::nextId(0);
 
 Annotations* Annotations::empty = new Annotations(Vector<Annotation>());
 
 const Type_Bits* Type_Bits::get(int width, bool isSigned) {
+#ifdef MULTITHREAD
+    std::lock_guard<std::mutex> acquire(bitsLock);
+#endif
     std::map<int, const IR::Type_Bits*> *&map = isSigned ? signedTypes : unsignedTypes;
     if (map == nullptr)
         map = new std::map<int, const IR::Type_Bits*>();
@@ -178,7 +178,8 @@ Visitor::profile_t::~profile_t() {
         ts.tv_sec = ts.tv_nsec = 0;
 #endif
         uint64_t end = ts.tv_sec*1000000000UL + ts.tv_nsec + 1;
-        LOG1(profile_indent << v.name() << ' ' << (end-start)/1000.0 << " usec"); }
+        LOG1(profile_indent << v.name() << ' ' << (end-start)/1000.0 << " usec" <<
+             v.profile_stats()); }
 }
 
 void Visitor::print_context() const {
@@ -232,7 +233,7 @@ class ForwardChildren : public Visitor {
 
 const IR::Node *Modifier::apply_visitor(const IR::Node *n, const char *name) {
     if (ctxt) ctxt->child_name = name;
-    if (n) {
+    if (n && !isUnchangedDeclaration(n)) {
         PushContext local(ctxt, n);
         if (visited->done(n)) {
             n->apply_visitor_revisit(*this, visited->result(n));
@@ -260,7 +261,7 @@ const IR::Node *Modifier::apply_visitor(const IR::Node *n, const char *name) {
 
 const IR::Node *Inspector::apply_visitor(const IR::Node *n, const char *name) {
     if (ctxt) ctxt->child_name = name;
-    if (n && !join_flows(n)) {
+    if (n && !isUnchangedDeclaration(n) && !join_flows(n)) {
         PushContext local(ctxt, n);
         auto vp = visited->emplace(n, info_t{false, visitDagOnce});
         if (!vp.second && !vp.first->second.done)
@@ -286,7 +287,7 @@ const IR::Node *Inspector::apply_visitor(const IR::Node *n, const char *name) {
 
 const IR::Node *Transform::apply_visitor(const IR::Node *n, const char *name) {
     if (ctxt) ctxt->child_name = name;
-    if (n) {
+    if (n && !isUnchangedDeclaration(n)) {
         PushContext local(ctxt, n);
         if (visited->done(n)) {
             n->apply_visitor_revisit(*this, visited->result(n));
@@ -19,6 +19,7 @@ limitations under the License.
 
 #include <stdexcept>
 #include <unordered_map>
+#include <unordered_set>
 #include "lib/cstring.h"
 #include "ir/ir.h"
 #include "lib/exceptions.h"
@@ -67,6 +68,9 @@ class Visitor {
     // of an exception, as there is no root in that case.
     virtual void end_apply();
     virtual void end_apply(const IR::Node* root);
+    // Statistics of the traversal appended to the profile of the pass;
+    // they should start with a space.
+    virtual std::string profile_stats() const { return std::string(); }
 
     // apply_visitor is the main traversal function that manages the
     // depth-first recursive traversal.  `visit` is a convenience function
@@ -125,6 +129,12 @@ class Visitor {
             ctxt->child_index = cidx; }
         v.parallel_visit_children(*this); }
 
+    // Top-level declarations which a change-driven PassRepeated knows to be
+    // unchanged since the previous iteration; visitors that are
+    // declarationLocal skip them.  nullptr disables skipping.
+    virtual void setUnchangedDeclarations(const std::unordered_set<const IR::Node *> *decls) {
+        if (declarationLocal) unchangedDeclarations = decls; }
+
     // Functions for IR visit_children to call for ControlFlowVisitors.
     virtual Visitor &flow_clone() { return *this; }
     virtual void flow_dead() { }
@@ -199,6 +209,14 @@ class Visitor {
     // flow_merge the visitor from all the parents before visiting the node and its
     // children.  This only works for Inspector (not Modifier/Transform) currently.
     bool joinFlows = false;
+    // if declarationLocal is 'true' the effect of the visitor on a top-level
+    // declaration only depends on that declaration and on the declarations it
+    // names, and the visitor keeps no state across top-level declarations.
+    // Such visitors can skip unchanged declarations in a change-driven PassRepeated.
+    bool declarationLocal = false;
+    const std::unordered_set<const IR::Node *> *unchangedDeclarations = nullptr;
+    bool isUnchangedDeclaration(const IR::Node *n) const {
+        return unchangedDeclarations != nullptr && unchangedDeclarations->count(n) != 0; }
 
     virtual void init_join_flows(const IR::Node *) { assert(0); }
 
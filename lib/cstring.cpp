@@ -18,9 +18,17 @@ limitations under the License.
 #include <string>
 #include <unordered_set>
 
+#ifdef MULTITHREAD
+#include <mutex>
+static std::mutex cacheLock;
+#endif  // MULTITHREAD
+
 static std::unordered_set<std::string> *cache = nullptr;
 
 cstring &cstring::operator=(const char *p) {
+#ifdef MULTITHREAD
+    std::lock_guard<std::mutex> acquire(cacheLock);
+#endif
     if (cache == nullptr)
         cache = new std::unordered_set<std::string>();
     str = p ? cache->emplace(p).first->c_str() : 0;
@@ -28,6 +36,9 @@ cstring &cstring::operator=(const char *p) {
 }
 
 cstring& cstring::operator=(const std::string& s) {
+#ifdef MULTITHREAD
+    std::lock_guard<std::mutex> acquire(cacheLock);
+#endif
     if (cache == nullptr)
         cache = new std::unordered_set<std::string>();
     str = cache->insert(s).first->c_str();
@@ -35,6 +46,9 @@ cstring& cstring::operator=(const std::string& s) {
 }
 
 size_t cstring::cache_size(size_t &count) {
+#ifdef MULTITHREAD
+    std::lock_guard<std::mutex> acquire(cacheLock);
+#endif
     size_t rv = 0;
     if (cache) {
         count = cache->size();
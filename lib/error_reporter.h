@@ -20,6 +20,9 @@ limitations under the License.
 #include <stdarg.h>
 #include <boost/format.hpp>
 #include <type_traits>
+#ifdef MULTITHREAD
+#include <mutex>
+#endif  // MULTITHREAD
 
 #include "lib/cstring.h"
 #include "lib/source_file.h"
@@ -368,6 +371,20 @@ class ErrorReporter final {
         outputstream->flush();
     }
 
+    // Counts and emits a diagnostic; diagnostics may be reported
+    // concurrently by compilers built with MULTITHREAD.
+    void emit_diagnostic(DiagnosticAction action, const std::string& message) {
+#ifdef MULTITHREAD
+        static std::mutex lock;
+        std::lock_guard<std::mutex> acquire(lock);
+#endif
+        if (action == DiagnosticAction::Error)
+            errorCount++;
+        else if (action == DiagnosticAction::Warn)
+            warningCount++;
+        emit_message(message);
+    }
+
  public:
     ErrorReporter()
         : errorCount(0),
@@ -396,12 +413,10 @@ class ErrorReporter final {
 
         std::string prefix;
         if (action == DiagnosticAction::Warn) {
-            warningCount++;
             prefix.append("[--Wwarn=");
             prefix.append(diagnosticName);
             prefix.append("] warning: ");
         } else if (action == DiagnosticAction::Error) {
-            errorCount++;
             prefix.append("[--Werror=");
             prefix.append(diagnosticName);
             prefix.append("] error: ");
@@ -409,7 +424,7 @@ class ErrorReporter final {
 
         boost::format fmt(format);
         std::string message = ::error_helper(fmt, prefix, "", "", args...);
-        emit_message(message);
+        emit_diagnostic(action, message);
     }
 
     template <typename... T>
@@ -417,16 +432,14 @@ class ErrorReporter final {
         const char* msg;
         if (action == DiagnosticAction::Error) {
             msg = "error: ";
-            errorCount++;
         } else if (action == DiagnosticAction::Warn) {
             msg = "warning: ";
-            warningCount++;
         } else {
             return;
         }
         boost::format fmt(format);
         std::string message = ::error_helper(fmt, msg, "", "", args...);
-        emit_message(message);
+        emit_diagnostic(action, message);
     }
 
     unsigned getErrorCount() const {
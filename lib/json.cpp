@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include <cctype>
 #include <stdexcept>
 #include <sstream>
 #include "json.h"
@@ -202,4 +203,101 @@ JsonObject* JsonObject::emplace_non_null(cstring label, IJson* value) {
     return this;
 }
 
+namespace {
+// Reads the json produced by serialize()
+class JsonParser {
+    std::istream& in;
+
+    int next() {
+        in >> std::ws;
+        return in.peek();
+    }
+    void expect(char c) {
+        if (next() != c)
+            throw std::logic_error(std::string("Malformed json: expected ") + c);
+        in.get();
+    }
+    void keyword(const char* word) {
+        for (auto p = word; *p; p++)
+            if (in.get() != *p)
+                throw std::logic_error(std::string("Malformed json: expected ") + word);
+    }
+    cstring string() {
+        expect('"');
+        std::string result;
+        // strings are not escaped by serialize(); backslashes are kept as they are
+        for (int c = in.get(); c != '"'; c = in.get()) {
+            if (c == EOF)
+                throw std::logic_error("Malformed json: unterminated string");
+            result.push_back(c);
+            if (c == '\\') {
+                c = in.get();
+                if (c == EOF)
+                    throw std::logic_error("Malformed json: unterminated string");
+                result.push_back(c);
+            }
+        }
+        return result;
+    }
+
+ public:
+    explicit JsonParser(std::istream& in) : in(in) {}
+
+    IJson* value() {
+        int c = next();
+        if (c == '{') {
+            in.get();
+            auto result = new JsonObject();
+            if (next() == '}') {
+                in.get();
+                return result;
+            }
+            do {
+                auto label = string();
+                expect(':');
+                result->emplace(label, value());
+            } while (next() == ',' && in.get());
+            expect('}');
+            return result;
+        } else if (c == '[') {
+            in.get();
+            auto result = new JsonArray();
+            if (next() == ']') {
+                in.get();
+                return result;
+            }
+            do {
+                result->append(value());
+            } while (next() == ',' && in.get());
+            expect(']');
+            return result;
+        } else if (c == '"') {
+            return new JsonValue(string());
+        } else if (c == 't') {
+            keyword("true");
+            return new JsonValue(true);
+        } else if (c == 'f') {
+            keyword("false");
+            return new JsonValue(false);
+        } else if (c == 'n') {
+            keyword("null");
+            return new JsonValue();
+        } else if (c == '-' || isdigit(c)) {
+            std::string digits(1, in.get());
+            while (isdigit(in.peek()))
+                digits.push_back(in.get());
+            mpz_class number;
+            if (number.set_str(digits, 10) != 0)
+                throw std::logic_error("Malformed json: bad number " + digits);
+            return new JsonValue(number);
+        }
+        throw std::logic_error("Malformed json: unexpected character");
+    }
+};
+}  // namespace
+
+IJson* IJson::parse(std::istream& in) {
+    return JsonParser(in).value();
+}
+
 }  // namespace Util
@@ -36,6 +36,9 @@ class IJson {
     virtual ~IJson() {}
     virtual void serialize(std::ostream& out) const = 0;
     cstring toString() const;
+    /// Reads json written by serialize(); throws std::logic_error if the
+    /// input is malformed.
+    static IJson* parse(std::istream& in);
     template<typename T> bool is() const { return to<T>() != nullptr; }
     template<typename T> T* to() { return dynamic_cast<T*>(this); }
     template<typename T> const T* to() const { return dynamic_cast<const T*>(this); }
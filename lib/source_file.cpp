@@ -277,6 +277,16 @@ cstring SourceInfo::toBriefSourceFragment() const {
     return sources->getBriefSourceFragment(*this);
 }
 
+cstring SourceInfo::toSourceText() const {
+    if (!isValid())
+        return "";
+    std::stringstream builder;
+    unsigned last = std::min(end.getLineNumber(), sources->lineCount());
+    for (unsigned line = start.getLineNumber(); line <= last; line++)
+        builder << sources->getLine(line);
+    return builder.str();
+}
+
 cstring SourceInfo::toPositionString() const {
     if (!isValid())
         return "";
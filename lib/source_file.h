@@ -185,6 +185,8 @@ class SourceInfo final {
 
     cstring toSourceFragment() const;
     cstring toBriefSourceFragment() const;
+    /// The text of all the source lines spanned by this position
+    cstring toSourceText() const;
     cstring toPositionString() const;
     cstring toSourcePositionData(unsigned *outLineNumber,
                                  unsigned *outColumnNumber) const;
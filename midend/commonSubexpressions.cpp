@@ -0,0 +1,512 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "commonSubexpressions.h"
+#include "expr_uses.h"
+#include "lib/stringify.h"
+
+namespace P4 {
+
+namespace {
+
+size_t combine(size_t seed, size_t value)
+{ return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2)); }
+
+// An expression and all the later equivalent occurrences
+// which can reuse the value of the first one.
+struct ValueNumber {
+    const IR::Expression*              first;
+    const IR::Statement*               statement;  // statement evaluating 'first'
+    unsigned                           size;  // number of operations in 'first'
+    std::vector<const IR::Expression*> occurrences;  // including 'first'
+};
+
+// Values available at a program point, indexed by expression hash
+typedef std::unordered_multimap<size_t, ValueNumber*> Available;
+
+bool isHeaderMethod(const IR::Expression* expression, const TypeMap* typeMap, cstring name) {
+    auto mc = expression->to<IR::MethodCallExpression>();
+    if (mc == nullptr || !mc->arguments->empty())
+        return false;
+    auto member = mc->method->to<IR::Member>();
+    if (member == nullptr || member->member.name != name)
+        return false;
+    auto type = typeMap->getType(member->expr);
+    return type != nullptr &&
+            (type->is<IR::Type_Header>() || type->is<IR::Type_HeaderUnion>());
+}
+
+// Name of the location written by an lvalue, in the format used by exprUses.
+// Returns a null name if the location is not known.
+cstring lvalueName(const IR::Expression* expression) {
+    if (auto pe = expression->to<IR::PathExpression>())
+        return pe->path->name;
+    if (auto mem = expression->to<IR::Member>()) {
+        auto base = lvalueName(mem->expr);
+        if (base.isNull())
+            return base;
+        return base + "." + mem->member.name;
+    }
+    if (auto ai = expression->to<IR::ArrayIndex>()) {
+        auto base = lvalueName(ai->left);
+        if (base.isNull() || !ai->right->is<IR::Constant>())
+            return base;
+        return base + "[" + Util::toString(ai->right->to<IR::Constant>()->asInt()) + "]";
+    }
+    if (auto sl = expression->to<IR::Slice>())
+        return lvalueName(sl->e0);
+    return nullptr;
+}
+
+// Locations written by a statement or declaration
+class Writes : public Inspector {
+    const TypeMap* typeMap;
+
+ public:
+    std::vector<cstring> locations;
+    bool all = false;  // may write any location
+
+    explicit Writes(const TypeMap* typeMap) : typeMap(typeMap) {}
+    bool preorder(const IR::AssignmentStatement* statement) override {
+        auto name = lvalueName(statement->left);
+        if (!name.isNull())
+            locations.push_back(name);
+        else
+            all = true;
+        visit(statement->right);
+        return false;
+    }
+    bool preorder(const IR::Declaration_Variable* decl) override {
+        locations.push_back(decl->name.name);
+        return true;
+    }
+    bool preorder(const IR::MethodCallExpression* expression) override {
+        if (isHeaderMethod(expression, typeMap, IR::Type_Header::isValid))
+            return false;
+        if (isHeaderMethod(expression, typeMap, IR::Type_Header::setValid) ||
+            isHeaderMethod(expression, typeMap, IR::Type_Header::setInvalid)) {
+            auto name = lvalueName(expression->method->to<IR::Member>()->expr);
+            if (!name.isNull())
+                locations.push_back(name);
+            else
+                all = true;
+            return false;
+        }
+        all = true;
+        return false;
+    }
+};
+
+// Computes the value numbers of the expressions in a statement.
+class ValueNumbering {
+    const TypeMap* typeMap;
+
+ public:
+    std::vector<ValueNumber*> values;  // in order of first occurrence
+    // Nearest enclosing numbered occurrence of each occurrence
+    std::map<const IR::Expression*, const IR::Expression*> parent;
+
+    explicit ValueNumbering(const TypeMap* typeMap) : typeMap(typeMap) {}
+
+    bool isValidCall(const IR::Expression* expression) const
+    { return isHeaderMethod(expression, typeMap, IR::Type_Header::isValid); }
+
+    // True if evaluating the expression has no side-effects
+    bool isPure(const IR::Expression* expression) const {
+        if (expression->is<IR::Constant>() || expression->is<IR::BoolLiteral>() ||
+            expression->is<IR::PathExpression>() || expression->is<IR::TypeNameExpression>())
+            return true;
+        if (auto u = expression->to<IR::Operation_Unary>())
+            return isPure(u->expr);
+        if (auto b = expression->to<IR::Operation_Binary>())
+            return isPure(b->left) && isPure(b->right);
+        if (auto t = expression->to<IR::Operation_Ternary>())
+            return isPure(t->e0) && isPure(t->e1) && isPure(t->e2);
+        if (auto l = expression->to<IR::ListExpression>()) {
+            for (auto c : l->components)
+                if (!isPure(c))
+                    return false;
+            return true;
+        }
+        return isValidCall(expression);
+    }
+
+    bool isCandidate(const IR::Expression* expression) const {
+        if (expression->is<IR::Member>() || expression->is<IR::ArrayIndex>())
+            return false;
+        if (!expression->is<IR::Operation>() && !isValidCall(expression))
+            return false;
+        auto type = typeMap->getType(expression);
+        if (type == nullptr || !(type->is<IR::Type_Bits>() || type->is<IR::Type_Boolean>()))
+            return false;
+        return isPure(expression);
+    }
+
+    // Number of operations performed when evaluating the expression
+    unsigned size(const IR::Expression* expression) const {
+        unsigned result = 0;
+        if (isValidCall(expression))
+            return 1;
+        if (expression->is<IR::Operation>() &&
+            !expression->is<IR::Member>() && !expression->is<IR::ArrayIndex>())
+            result = 1;
+        if (auto u = expression->to<IR::Operation_Unary>())
+            return result + size(u->expr);
+        if (auto b = expression->to<IR::Operation_Binary>())
+            return result + size(b->left) + size(b->right);
+        if (auto t = expression->to<IR::Operation_Ternary>())
+            return result + size(t->e0) + size(t->e1) + size(t->e2);
+        return result;
+    }
+
+    static size_t hash(const IR::Expression* expression) {
+        size_t result = std::hash<cstring>()(expression->node_type_name());
+        if (auto c = expression->to<IR::Constant>())
+            return combine(result, c->value.get_ui());
+        if (auto b = expression->to<IR::BoolLiteral>())
+            return combine(result, b->value);
+        if (auto pe = expression->to<IR::PathExpression>())
+            return combine(result, std::hash<cstring>()(pe->path->name));
+        if (auto tn = expression->to<IR::TypeNameExpression>())
+            return combine(result, std::hash<cstring>()(tn->typeName->path->name));
+        if (auto mem = expression->to<IR::Member>())
+            return combine(combine(result, hash(mem->expr)),
+                           std::hash<cstring>()(mem->member.name));
+        if (auto u = expression->to<IR::Operation_Unary>())
+            return combine(result, hash(u->expr));
+        if (auto b = expression->to<IR::Operation_Binary>())
+            return combine(combine(result, hash(b->left)), hash(b->right));
+        if (auto t = expression->to<IR::Operation_Ternary>())
+            return combine(combine(combine(result, hash(t->e0)), hash(t->e1)), hash(t->e2));
+        if (auto mc = expression->to<IR::MethodCallExpression>())
+            return combine(result, hash(mc->method));
+        if (auto l = expression->to<IR::ListExpression>()) {
+            for (auto c : l->components)
+                result = combine(result, hash(c));
+        }
+        return result;
+    }
+
+    // Unlike IR::Node::equiv two int constants with the same value are
+    // equal, although each one has its own Type_InfInt.
+    static bool equal(const IR::Expression* left, const IR::Expression* right) {
+        if (left->node_type_name() != right->node_type_name())
+            return false;
+        if (auto cl = left->to<IR::Constant>()) {
+            auto cr = right->to<IR::Constant>();
+            if (cl->value != cr->value)
+                return false;
+            if (cl->type->is<IR::Type_InfInt>())
+                return cr->type->is<IR::Type_InfInt>();
+            return cl->type->equiv(*cr->type);
+        }
+        if (auto ml = left->to<IR::Member>()) {
+            auto mr = right->to<IR::Member>();
+            return ml->member == mr->member && equal(ml->expr, mr->expr);
+        }
+        if (auto cl = left->to<IR::Cast>()) {
+            auto cr = right->to<IR::Cast>();
+            return cl->destType->equiv(*cr->destType) && equal(cl->expr, cr->expr);
+        }
+        if (auto ul = left->to<IR::Operation_Unary>())
+            return equal(ul->expr, right->to<IR::Operation_Unary>()->expr);
+        if (auto bl = left->to<IR::Operation_Binary>()) {
+            auto br = right->to<IR::Operation_Binary>();
+            return equal(bl->left, br->left) && equal(bl->right, br->right);
+        }
+        if (auto tl = left->to<IR::Operation_Ternary>()) {
+            auto tr = right->to<IR::Operation_Ternary>();
+            return equal(tl->e0, tr->e0) && equal(tl->e1, tr->e1) && equal(tl->e2, tr->e2);
+        }
+        if (auto ll = left->to<IR::ListExpression>()) {
+            auto lr = right->to<IR::ListExpression>();
+            if (ll->components.size() != lr->components.size())
+                return false;
+            for (size_t i = 0; i < ll->components.size(); i++)
+                if (!equal(ll->components.at(i), lr->components.at(i)))
+                    return false;
+            return true;
+        }
+        return left->equiv(*right);
+    }
+
+    void number(const IR::Expression* expression, const IR::Statement* statement,
+                Available& available) {
+        size_t h = hash(expression);
+        auto range = available.equal_range(h);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (equal(it->second->first, expression)) {
+                it->second->occurrences.push_back(expression);
+                return;
+            }
+        }
+        auto value = new ValueNumber{ expression, statement, size(expression), {} };
+        value->occurrences.push_back(expression);
+        values.push_back(value);
+        available.emplace(h, value);
+    }
+
+    // True if evaluating the expression may fail: a header stack
+    // index which is not a constant may be out of range.
+    static bool canFail(const IR::Expression* expression) {
+        bool result = false;
+        forAllMatching<IR::ArrayIndex>(expression, [&](const IR::ArrayIndex* ai) {
+            if (!ai->right->is<IR::Constant>())
+                result = true; });
+        return result;
+    }
+
+    // Numbers all the candidates in a pure expression.  The temporaries
+    // are evaluated unconditionally, so a candidate evaluated only when
+    // a condition holds (an operand of &&, || or ?:) is skipped if it
+    // can fail.
+    void collect(const IR::Expression* expression, const IR::Expression* enclosing,
+                 const IR::Statement* statement, Available& available,
+                 bool conditional = false) {
+        if (isCandidate(expression) && !(conditional && canFail(expression))) {
+            number(expression, statement, available);
+            parent[expression] = enclosing;
+            enclosing = expression;
+        }
+        if (auto u = expression->to<IR::Operation_Unary>()) {
+            collect(u->expr, enclosing, statement, available, conditional);
+        } else if (auto b = expression->to<IR::Operation_Binary>()) {
+            bool shortCircuit = expression->is<IR::LAnd>() || expression->is<IR::LOr>();
+            collect(b->left, enclosing, statement, available, conditional);
+            collect(b->right, enclosing, statement, available, conditional || shortCircuit);
+        } else if (auto t = expression->to<IR::Operation_Ternary>()) {
+            bool mux = expression->is<IR::Mux>();
+            collect(t->e0, enclosing, statement, available, conditional);
+            collect(t->e1, enclosing, statement, available, conditional || mux);
+            collect(t->e2, enclosing, statement, available, conditional || mux);
+        } else if (auto l = expression->to<IR::ListExpression>()) {
+            for (auto c : l->components)
+                collect(c, enclosing, statement, available, conditional);
+        }
+    }
+
+    // Numbers the candidates in an expression evaluated by a statement.
+    // The temporaries are computed before the statement, so if the
+    // expression has side-effects only the arguments of a top-level
+    // call are considered.
+    void collectStatement(const IR::Expression* expression, const IR::Statement* statement,
+                          Available& available) {
+        if (isPure(expression)) {
+            collect(expression, nullptr, statement, available);
+            return;
+        }
+        auto mc = expression->to<IR::MethodCallExpression>();
+        if (mc == nullptr)
+            return;
+        for (auto arg : *mc->arguments)
+            if (!isPure(arg->expression))
+                return;
+        for (auto arg : *mc->arguments)
+            collect(arg->expression, nullptr, statement, available);
+    }
+
+    void kill(const IR::Node* node, Available& available) const {
+        Writes writes(typeMap);
+        (void)node->apply(writes);
+        if (writes.all) {
+            available.clear();
+            return;
+        }
+        for (auto it = available.begin(); it != available.end();) {
+            bool killed = false;
+            for (auto loc : writes.locations) {
+                if (exprUses(it->second->first, loc)) {
+                    killed = true;
+                    break;
+                }
+            }
+            if (killed)
+                it = available.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    void analyze(const IR::Statement* statement, Available& available) {
+        if (statement == nullptr)
+            return;
+        if (auto block = statement->to<IR::BlockStatement>()) {
+            for (auto c : block->components) {
+                if (auto s = c->to<IR::Statement>())
+                    analyze(s, available);
+                else
+                    kill(c, available);
+            }
+        } else if (auto assign = statement->to<IR::AssignmentStatement>()) {
+            collectStatement(assign->right, statement, available);
+            kill(statement, available);
+        } else if (auto mcs = statement->to<IR::MethodCallStatement>()) {
+            collectStatement(mcs->methodCall, statement, available);
+            kill(statement, available);
+        } else if (auto ifs = statement->to<IR::IfStatement>()) {
+            collectStatement(ifs->condition, statement, available);
+            kill(ifs->condition, available);
+            Available ifTrue(available);
+            analyze(ifs->ifTrue, ifTrue);
+            Available ifFalse(available);
+            analyze(ifs->ifFalse, ifFalse);
+            kill(statement, available);
+        } else if (auto sw = statement->to<IR::SwitchStatement>()) {
+            kill(sw->expression, available);
+            for (auto c : sw->cases) {
+                Available branch(available);
+                analyze(c->statement, branch);
+            }
+            kill(statement, available);
+        } else {
+            kill(statement, available);
+        }
+    }
+};
+
+}  // namespace
+
+Visitor::profile_t DoCommonSubexpressionElimination::init_apply(const IR::Node* node) {
+    replace.clear();
+    temporaries.clear();
+    computeBefore.clear();
+    return Transform::init_apply(node);
+}
+
+void DoCommonSubexpressionElimination::analyze(const IR::Node* scope,
+                                               const IR::Statement* body) {
+    ValueNumbering vn(typeMap);
+    Available available;
+    vn.analyze(body, available);
+
+    // Larger expressions first: their replacement removes the
+    // occurrences of the subexpressions they contain.
+    std::stable_sort(vn.values.begin(), vn.values.end(),
+                     [](const ValueNumber* a, const ValueNumber* b) { return a->size > b->size; });
+    std::set<const IR::Expression*> removed;
+    auto eliminated = [&](const IR::Expression* e) {
+        for (auto p = vn.parent[e]; p != nullptr; p = vn.parent[p])
+            if (removed.count(p))
+                return true;
+        return false;
+    };
+    for (auto value : vn.values) {
+        if (value->occurrences.size() < 2 || eliminated(value->first))
+            continue;
+        std::vector<const IR::Expression*> occurrences;
+        for (auto o : value->occurrences)
+            if (!eliminated(o))
+                occurrences.push_back(o);
+        // Each occurrence but the first saves 'size' operations;
+        // the assignment to the temporary costs one.
+        if ((occurrences.size() - 1) * value->size < 2)
+            continue;
+
+        auto temp = new Temporary;
+        temp->name = refMap->newName("tmp");
+        temp->type = typeMap->getType(value->first);
+        temp->scope = scope;
+        temp->first = value->first;
+        temp->statement = value->statement;
+        temporaries.push_back(temp);
+        for (auto o : occurrences) {
+            replace.emplace(o, temp);
+            if (o != value->first)
+                removed.insert(o);
+        }
+        LOG2("Common subexpression " << value->first << " used " << occurrences.size() <<
+             " times stored in " << temp->name);
+    }
+}
+
+IR::IndexedVector<IR::Declaration>
+DoCommonSubexpressionElimination::declarations(const IR::Node* scope) const {
+    IR::IndexedVector<IR::Declaration> result;
+    for (auto temp : temporaries)
+        if (temp->scope == scope && temp->value != nullptr)
+            result.push_back(new IR::Declaration_Variable(IR::ID(temp->name), temp->type));
+    return result;
+}
+
+const IR::Node* DoCommonSubexpressionElimination::preorder(IR::P4Action* action) {
+    analyze(getOriginal(), action->body);
+    return action;
+}
+
+const IR::Node* DoCommonSubexpressionElimination::postorder(IR::P4Action* action) {
+    auto decls = declarations(getOriginal());
+    if (decls.empty())
+        return action;
+    IR::IndexedVector<IR::StatOrDecl> body;
+    for (auto d : decls)
+        body.push_back(d);
+    body.append(action->body->components);
+    action->body = new IR::BlockStatement(
+        action->body->srcInfo, action->body->annotations, body);
+    return action;
+}
+
+const IR::Node* DoCommonSubexpressionElimination::preorder(IR::P4Control* control) {
+    if (inControls)
+        analyze(getOriginal(), control->body);
+    return control;
+}
+
+const IR::Node* DoCommonSubexpressionElimination::postorder(IR::P4Control* control) {
+    auto decls = declarations(getOriginal());
+    if (decls.empty())
+        return control;
+    decls.append(control->controlLocals);
+    control->controlLocals = decls;
+    return control;
+}
+
+const IR::Node* DoCommonSubexpressionElimination::preorder(IR::Expression* expression) {
+    auto orig = getOriginal<IR::Expression>();
+    auto it = replace.find(orig);
+    if (it == replace.end() || it->second->first == orig)
+        // the first occurrence is replaced in postorder, after
+        // the common subexpressions it contains
+        return expression;
+    prune();
+    return new IR::PathExpression(IR::ID(expression->srcInfo, it->second->name));
+}
+
+const IR::Node* DoCommonSubexpressionElimination::postorder(IR::Expression* expression) {
+    auto orig = getOriginal<IR::Expression>();
+    auto it = replace.find(orig);
+    if (it == replace.end() || it->second->first != orig)
+        return expression;
+    auto temp = it->second;
+    temp->value = expression;
+    computeBefore[temp->statement].push_back(temp);
+    return new IR::PathExpression(IR::ID(expression->srcInfo, temp->name));
+}
+
+const IR::Node* DoCommonSubexpressionElimination::postorder(IR::Statement* statement) {
+    auto it = computeBefore.find(getOriginal<IR::Statement>());
+    if (it == computeBefore.end())
+        return statement;
+    auto block = new IR::BlockStatement(statement->srcInfo);
+    for (auto temp : it->second) {
+        auto left = new IR::PathExpression(IR::ID(temp->value->srcInfo, temp->name));
+        block->push_back(new IR::AssignmentStatement(temp->value->srcInfo, left, temp->value));
+    }
+    block->push_back(statement);
+    return block;
+}
+
+}  // namespace P4
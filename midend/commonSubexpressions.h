@@ -0,0 +1,112 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef _MIDEND_COMMONSUBEXPRESSIONS_H_
+#define _MIDEND_COMMONSUBEXPRESSIONS_H_
+
+#include "ir/ir.h"
+#include "frontends/common/resolveReferences/referenceMap.h"
+#include "frontends/p4/typeChecking/typeChecker.h"
+
+namespace P4 {
+
+/**
+Common subexpression elimination using hash-based value numbering.
+
+In action bodies (and optionally in control bodies) an expression which
+is evaluated more than once, with no writes to the locations it reads in
+between, is evaluated once into a new temporary:
+
+a = (x + y) << 2;
+b = ((x + y) << 2) | 1;
+
+becomes
+
+bit<32> tmp;
+{
+  tmp = (x + y) << 2;
+  a = tmp;
+}
+b = tmp | 1;
+
+Only expressions of type bit<> or bool that are built from operators,
+constants, lvalues and isValid() calls are numbered.  Any other method
+call is assumed to write all locations.  Expressions available before an
+'if' or 'switch' are also available in its branches.  A value is only
+kept in a temporary if this saves more operations than the assignment
+to the temporary costs.  The temporaries are evaluated unconditionally,
+so an operand of &&, || or ?: which indexes a header stack with a value
+that is not a constant is never evaluated into a temporary.
+
+@pre Requires all declaration names to be unique (UniqueNames).
+Should be followed by MoveDeclarations and SimplifyControlFlow: the
+temporaries are declared at the beginning of the enclosing action or
+control, and the assignments to them are inserted as nested blocks.
+*/
+class DoCommonSubexpressionElimination : public Transform {
+    ReferenceMap* refMap;
+    TypeMap*      typeMap;
+    bool          inControls;  // also process control bodies
+
+    struct Temporary {
+        cstring               name;
+        const IR::Type*       type;
+        const IR::Node*       scope;  // action or control declaring the temporary
+        const IR::Expression* first;  // occurrence evaluated into the temporary
+        const IR::Statement*  statement;  // statement containing 'first'
+        const IR::Expression* value = nullptr;  // 'first' after transformation
+    };
+    // Temporary replacing each occurrence of a common subexpression
+    std::map<const IR::Expression*, Temporary*> replace;
+    std::vector<Temporary*> temporaries;
+    // Temporaries to compute before each statement, in order
+    std::map<const IR::Statement*, std::vector<Temporary*>> computeBefore;
+
+    void analyze(const IR::Node* scope, const IR::Statement* body);
+    IR::IndexedVector<IR::Declaration> declarations(const IR::Node* scope) const;
+
+ public:
+    DoCommonSubexpressionElimination(ReferenceMap* refMap, TypeMap* typeMap, bool inControls) :
+            refMap(refMap), typeMap(typeMap), inControls(inControls)
+    { CHECK_NULL(refMap); CHECK_NULL(typeMap); setName("DoCommonSubexpressionElimination"); }
+
+    Visitor::profile_t init_apply(const IR::Node* node) override;
+    const IR::Node* preorder(IR::P4Parser* parser) override
+    { prune(); return parser; }
+    const IR::Node* preorder(IR::Function* function) override
+    { prune(); return function; }
+    const IR::Node* preorder(IR::P4Action* action) override;
+    const IR::Node* postorder(IR::P4Action* action) override;
+    const IR::Node* preorder(IR::P4Control* control) override;
+    const IR::Node* postorder(IR::P4Control* control) override;
+    const IR::Node* preorder(IR::Expression* expression) override;
+    const IR::Node* postorder(IR::Expression* expression) override;
+    const IR::Node* postorder(IR::Statement* statement) override;
+};
+
+class CommonSubexpressionElimination : public PassManager {
+ public:
+    CommonSubexpressionElimination(ReferenceMap* refMap, TypeMap* typeMap,
+                                   bool inControls = false) {
+        passes.push_back(new TypeChecking(refMap, typeMap));
+        passes.push_back(new DoCommonSubexpressionElimination(refMap, typeMap, inControls));
+        setName("CommonSubexpressionElimination");
+    }
+};
+
+}  // namespace P4
+
+#endif /* _MIDEND_COMMONSUBEXPRESSIONS_H_ */
@@ -62,7 +62,7 @@ class DoCopyStructures : public Transform {
  public:
     explicit DoCopyStructures(TypeMap* typeMap, bool errorOnMethodCall) :
             typeMap(typeMap), errorOnMethodCall(errorOnMethodCall)
-    { CHECK_NULL(typeMap); setName("DoCopyStructures"); }
+    { CHECK_NULL(typeMap); setName("DoCopyStructures"); declarationLocal = true; }
     const IR::Node* postorder(IR::AssignmentStatement* statement) override;
 };
 
@@ -74,6 +74,7 @@ class CopyStructures : public PassRepeated {
         CHECK_NULL(refMap); CHECK_NULL(typeMap); setName("CopyStructures");
         passes.emplace_back(new TypeChecking(refMap, typeMap));
         passes.emplace_back(new DoCopyStructures(typeMap, errorOnMethodCall));
+        setChangeDriven();
     }
 };
 
@@ -0,0 +1,257 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "deadFields.h"
+#include "has_side_effects.h"
+#include "frontends/common/options.h"
+#include "frontends/p4/methodInstance.h"
+
+namespace P4 {
+
+namespace {
+// The member written by an assignment to 'left', or nullptr
+const IR::Member* writtenMember(const IR::Expression* left) {
+    while (auto slice = left->to<IR::Slice>())
+        left = slice->e0;
+    return left->to<IR::Member>();
+}
+}  // namespace
+
+Visitor::profile_t FindDeadFields::init_apply(const IR::Node* node) {
+    candidates.clear();
+    escaping.clear();
+    live.clear();
+    assigned.clear();
+    deadFields->fields.clear();
+    // Collect the candidates first, so that uses which precede
+    // the declaration in the program are not missed.
+    forAllMatching<IR::Type_Struct>(node, [this](const IR::Type_Struct* type) {
+        if (type->srcInfo.isValid() &&
+            type->srcInfo.getSourceFile().startsWith(p4includePath))
+            return;
+        candidates.emplace(type->name.name, type);
+    });
+    return Inspector::init_apply(node);
+}
+
+const IR::Type_Struct* FindDeadFields::candidate(const IR::Type* type) const {
+    if (type == nullptr)
+        return nullptr;
+    auto st = type->to<IR::Type_Struct>();
+    if (st == nullptr)
+        return nullptr;
+    auto it = candidates.find(st->name.name);
+    if (it == candidates.end())
+        return nullptr;
+    return it->second;
+}
+
+const IR::Type_Struct* FindDeadFields::candidateType(const IR::Node* node) const {
+    return candidate(typeMap->getType(node));
+}
+
+void FindDeadFields::escape(const IR::Type* type) {
+    if (auto st = candidate(type)) {
+        LOG2("Struct " << st->name << " escapes");
+        escaping.insert(st->name.name);
+    }
+}
+
+bool FindDeadFields::preorder(const IR::Type_Struct*) {
+    // field types are not interesting
+    return false;
+}
+
+bool FindDeadFields::preorder(const IR::AssignmentStatement* statement) {
+    auto member = writtenMember(statement->left);
+    if (member != nullptr) {
+        if (auto st = candidateType(member->expr)) {
+            // A write is not a read, but if the assignment cannot be
+            // removed the field must stay.
+            if (hasSideEffects(statement->right))
+                live[st->name.name].insert(member->member.name);
+            assigned.insert(member);
+        }
+    }
+    return true;
+}
+
+bool FindDeadFields::preorder(const IR::Parameter* param) {
+    // action data is supplied by the control-plane
+    if (param->direction == IR::Direction::None && findContext<IR::P4Action>() != nullptr)
+        escape(typeMap->getType(param));
+    return false;
+}
+
+bool FindDeadFields::preorder(const IR::Declaration_Constant* decl) {
+    escape(typeMap->getType(decl));
+    return true;
+}
+
+bool FindDeadFields::preorder(const IR::Type_Specialized* type) {
+    for (auto arg : *type->arguments)
+        escape(typeMap->getTypeType(arg, false));
+    return false;
+}
+
+bool FindDeadFields::preorder(const IR::MethodCallExpression* expression) {
+    for (auto arg : *expression->typeArguments)
+        escape(typeMap->getTypeType(arg, false));
+    return true;
+}
+
+const IR::Type* FindDeadFields::initialized(const IR::Expression* expression,
+                                            const Visitor::Context* ctx) const {
+    if (ctx == nullptr)
+        return nullptr;
+    auto parent = ctx->node;
+    if (auto assign = parent->to<IR::AssignmentStatement>()) {
+        if (assign->right == expression)
+            return typeMap->getType(assign->left);
+    } else if (parent->is<IR::Declaration_Variable>() ||
+               parent->is<IR::Declaration_Constant>()) {
+        return typeMap->getType(parent);
+    } else if (auto arg = parent->to<IR::Argument>()) {
+        // Argument -> Vector<Argument> -> call
+        auto call = ctx->parent && ctx->parent->parent ? ctx->parent->parent->node : nullptr;
+        if (call == nullptr || !call->is<IR::MethodCallExpression>())
+            return nullptr;
+        MethodCallDescription mcd(call->to<IR::MethodCallExpression>(), refMap, typeMap);
+        // the actual parameters have the type arguments substituted
+        for (auto p : *mcd.substitution.getParametersInArgumentOrder()) {
+            if (mcd.substitution.lookup(p) != arg)
+                continue;
+            auto param = mcd.instance->getActualParameters()->getParameter(p->name.name);
+            if (param == nullptr)
+                return nullptr;
+            if (param->type->is<IR::Type_Name>())
+                return typeMap->getTypeType(param->type, false);
+            return param->type;
+        }
+    } else if (auto list = parent->to<IR::ListExpression>()) {
+        // A component of a list which itself initializes a struct
+        auto outer = initialized(list, ctx->parent);
+        auto st = outer == nullptr ? nullptr : outer->to<IR::Type_StructLike>();
+        if (st == nullptr)
+            return nullptr;
+        size_t index = 0;
+        for (auto c : list->components) {
+            if (c == expression)
+                break;
+            index++;
+        }
+        if (index < st->fields.size())
+            return typeMap->getTypeType(st->fields.at(index)->type, false);
+    }
+    return nullptr;
+}
+
+bool FindDeadFields::preorder(const IR::ListExpression* expression) {
+    // A list which initializes a struct matches the fields by position,
+    // so none of them can be removed.
+    escape(initialized(expression, getContext()));
+    return true;
+}
+
+void FindDeadFields::postorder(const IR::Member* member) {
+    if (!assigned.count(member)) {
+        if (auto st = candidateType(member->expr))
+            live[st->name.name].insert(member->member.name);
+    }
+    // the field itself may be a struct
+    postorder(member->to<IR::Expression>());
+}
+
+void FindDeadFields::postorder(const IR::Expression* expression) {
+    auto st = candidateType(expression);
+    if (st == nullptr)
+        return;
+    auto ctx = getContext();
+    if (ctx == nullptr)
+        return;
+    auto parent = ctx->node;
+    if (auto member = parent->to<IR::Member>()) {
+        if (member->expr == expression)
+            return;
+    } else if (auto assign = parent->to<IR::AssignmentStatement>()) {
+        auto other = assign->left == expression ? assign->right : assign->left;
+        if (candidateType(other) == st)
+            return;
+    } else if (auto decl = parent->to<IR::Declaration_Variable>()) {
+        if (candidateType(decl) == st)
+            return;
+    } else if (parent->is<IR::Argument>()) {
+        if (auto mce = findContext<IR::MethodCallExpression>()) {
+            auto mi = MethodInstance::resolve(mce, refMap, typeMap);
+            if (mi->is<ApplyMethod>() || mi->is<ActionCall>())
+                return;
+        }
+    }
+    LOG2(expression << " of type " << st->name << " escapes");
+    escaping.insert(st->name.name);
+}
+
+void FindDeadFields::end_apply(const IR::Node*) {
+    for (auto c : candidates) {
+        if (escaping.count(c.first))
+            continue;
+        auto& used = live[c.first];
+        std::set<cstring> dead;
+        unsigned bits = 0;
+        for (auto f : c.second->fields) {
+            if (used.count(f->name.name))
+                continue;
+            dead.insert(f->name.name);
+            auto type = typeMap->getTypeType(f->type, false);
+            if (type != nullptr)
+                bits += type->width_bits();
+        }
+        if (dead.empty())
+            continue;
+        LOG1("Struct " << c.first << ": removing " << dead.size() << " of " <<
+             c.second->fields.size() << " fields, " << (bits + 7) / 8 << " bytes saved");
+        deadFields->fields.emplace(c.first, dead);
+    }
+}
+
+const IR::Node* RemoveDeadFields::preorder(IR::Type_Struct* type) {
+    auto it = deadFields->fields.find(type->name.name);
+    if (it == deadFields->fields.end())
+        return type;
+    IR::IndexedVector<IR::StructField> fields;
+    for (auto f : type->fields)
+        if (!it->second.count(f->name.name))
+            fields.push_back(f);
+    type->fields = fields;
+    prune();
+    return type;
+}
+
+const IR::Node* RemoveDeadFields::preorder(IR::AssignmentStatement* statement) {
+    auto member = writtenMember(statement->left);
+    if (member == nullptr)
+        return statement;
+    auto st = typeMap->getType(member->expr);
+    if (st == nullptr || !st->is<IR::Type_Struct>())
+        return statement;
+    if (!deadFields->isDead(st->to<IR::Type_Struct>()->name.name, member->member.name))
+        return statement;
+    LOG3("Removing dead assignment " << statement);
+    prune();
+    return new IR::EmptyStatement(statement->srcInfo);
+}
+
+}  // namespace P4
@@ -0,0 +1,117 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef _MIDEND_DEADFIELDS_H_
+#define _MIDEND_DEADFIELDS_H_
+
+#include "ir/ir.h"
+#include "frontends/common/resolveReferences/referenceMap.h"
+#include "frontends/p4/typeChecking/typeChecker.h"
+
+namespace P4 {
+
+/// For each struct type, the fields which are never read
+class DeadFields {
+ public:
+    std::map<cstring, std::set<cstring>> fields;
+    bool isDead(cstring structName, cstring field) const {
+        auto it = fields.find(structName);
+        return it != fields.end() && it->second.count(field) != 0;
+    }
+};
+
+/**
+Whole-program field liveness for the structs declared in the program
+(typically user metadata): a field is dead if no parser, control,
+action or deparser ever reads it.  A field is conservatively live if:
+- it is passed as an argument to any call (it may be read by the callee)
+- it is written with a value that has side-effects.
+All fields of a struct are live if a value of the struct type escapes,
+i.e., it is used in any way other than by accessing its fields,
+copying it to another value of the same type, or passing it to
+a parser, control or action; if a list expression initializes a
+value of the struct type (the list components match the fields by
+position); or if the struct type is a type argument, the type of a
+constant or of an action parameter supplied by the control-plane.
+Structs from system include files are never changed.
+*/
+class FindDeadFields : public Inspector {
+    ReferenceMap* refMap;
+    TypeMap*      typeMap;
+    DeadFields*   deadFields;
+    std::map<cstring, const IR::Type_Struct*> candidates;
+    std::set<cstring> escaping;  // struct names
+    std::map<cstring, std::set<cstring>> live;  // live fields of each struct
+    std::set<const IR::Member*> assigned;  // fields written, not read
+
+    const IR::Type_Struct* candidate(const IR::Type* type) const;
+    const IR::Type_Struct* candidateType(const IR::Node* node) const;
+    void escape(const IR::Type* type);
+    /// The type initialized by 'expression', a list whose parent is in 'ctx'
+    const IR::Type* initialized(const IR::Expression* expression,
+                                const Visitor::Context* ctx) const;
+
+ public:
+    FindDeadFields(ReferenceMap* refMap, TypeMap* typeMap, DeadFields* deadFields) :
+            refMap(refMap), typeMap(typeMap), deadFields(deadFields)
+    { CHECK_NULL(refMap); CHECK_NULL(typeMap); CHECK_NULL(deadFields);
+      setName("FindDeadFields"); }
+
+    Visitor::profile_t init_apply(const IR::Node* node) override;
+    bool preorder(const IR::Type_Struct* type) override;
+    bool preorder(const IR::AssignmentStatement* statement) override;
+    bool preorder(const IR::Parameter* param) override;
+    bool preorder(const IR::Declaration_Constant* decl) override;
+    bool preorder(const IR::Type_Specialized* type) override;
+    bool preorder(const IR::MethodCallExpression* expression) override;
+    bool preorder(const IR::ListExpression* expression) override;
+    void postorder(const IR::Member* member) override;
+    void postorder(const IR::Expression* expression) override;
+    void end_apply(const IR::Node* node) override;
+};
+
+/// Removes the dead fields from the struct declarations and the
+/// assignments to them.
+class RemoveDeadFields : public Transform {
+    TypeMap*          typeMap;
+    const DeadFields* deadFields;
+
+ public:
+    RemoveDeadFields(TypeMap* typeMap, const DeadFields* deadFields) :
+            typeMap(typeMap), deadFields(deadFields)
+    { CHECK_NULL(typeMap); CHECK_NULL(deadFields); setName("RemoveDeadFields"); }
+
+    const IR::Node* preorder(IR::Type_Struct* type) override;
+    const IR::Node* preorder(IR::AssignmentStatement* statement) override;
+};
+
+class EliminateDeadFields : public PassManager {
+    DeadFields deadFields;
+
+ public:
+    EliminateDeadFields(ReferenceMap* refMap, TypeMap* typeMap) {
+        passes.push_back(new TypeChecking(refMap, typeMap));
+        passes.push_back(new FindDeadFields(refMap, typeMap, &deadFields));
+        passes.push_back(new RemoveDeadFields(typeMap, &deadFields));
+        // expressions may still carry the old struct types
+        passes.push_back(new TypeChecking(refMap, typeMap, true));
+        setName("EliminateDeadFields");
+    }
+};
+
+}  // namespace P4
+
+#endif /* _MIDEND_DEADFIELDS_H_ */
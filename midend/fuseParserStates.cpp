@@ -0,0 +1,157 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "fuseParserStates.h"
+
+namespace P4 {
+
+namespace {
+
+// Names of the states 'state' transitions to
+std::vector<cstring> successors(const IR::ParserState* state) {
+    std::vector<cstring> result;
+    auto select = state->selectExpression;
+    if (select == nullptr)
+        return result;
+    if (auto path = select->to<IR::PathExpression>()) {
+        result.push_back(path->path->name);
+    } else if (auto se = select->to<IR::SelectExpression>()) {
+        for (auto c : se->selectCases)
+            result.push_back(c->state->path->name);
+    }
+    return result;
+}
+
+bool canBeFused(const IR::ParserState* state) {
+    if (state->name == IR::ParserState::start || state->isBuiltin())
+        return false;
+    for (auto anno : state->getAnnotations()->annotations)
+        if (anno->name.name != "name")
+            return false;
+    return true;
+}
+
+}  // namespace
+
+const IR::Node* FuseParserStates::preorder(IR::P4Parser* parser) {
+    prune();
+    size_t before = parser->states.size();
+    // The maps are updated after each fusion instead of being rebuilt
+    std::vector<cstring> order;  // state names, in program order
+    std::map<cstring, const IR::ParserState*> byName;
+    std::map<cstring, unsigned> predecessors;  // number of incoming edges
+    for (auto s : parser->states) {
+        order.push_back(s->name.name);
+        byName.emplace(s->name.name, s);
+        for (auto n : successors(s))
+            predecessors[n]++;
+    }
+
+    // Removes an edge to 'name'; drops the states left without predecessors
+    auto removeEdge = [&](cstring name) {
+        std::vector<cstring> work = { name };
+        while (!work.empty()) {
+            auto n = work.back();
+            work.pop_back();
+            if (--predecessors[n] != 0 || n == IR::ParserState::start)
+                continue;
+            auto dead = ::get(byName, n);
+            if (dead == nullptr || dead->isBuiltin())
+                continue;
+            LOG2("Removing unreachable state " << dbp(dead));
+            byName.erase(n);
+            for (auto m : successors(dead))
+                work.push_back(m);
+        }
+    };
+
+    bool changes = false;
+    // Bounds the work on cycles of empty states
+    size_t budget = before * maxStatements;
+    bool fused = true;
+    // Another pass is needed only if a state lost predecessors after
+    // its own predecessor was visited.
+    while (fused) {
+        fused = false;
+        for (auto name : order) {
+            while (budget > 0) {
+                auto s = ::get(byName, name);
+                if (s == nullptr)
+                    break;
+                auto path = s->selectExpression ? s->selectExpression->to<IR::PathExpression>()
+                                                : nullptr;
+                if (path == nullptr || path->path->name == name)
+                    break;
+                auto next = ::get(byName, path->path->name.name);
+                if (next == nullptr || !canBeFused(next))
+                    break;
+                if (predecessors[next->name.name] > 1) {
+                    // next is duplicated
+                    if (s->components.size() + next->components.size() > maxStatements)
+                        break;
+                    bool hasDeclarations = false;
+                    for (auto c : next->components)
+                        hasDeclarations = hasDeclarations || c->is<IR::Declaration>();
+                    if (hasDeclarations)
+                        break;
+                }
+                LOG2("Fusing " << dbp(next) << " into " << dbp(s));
+                IR::IndexedVector<IR::StatOrDecl> components(s->components);
+                components.append(next->components);
+                byName[name] = new IR::ParserState(s->srcInfo, s->name, s->annotations,
+                                                   components, next->selectExpression);
+                budget--;
+                fused = changes = true;
+                // s now transitions to the successors of next instead of next
+                for (auto n : successors(next))
+                    predecessors[n]++;
+                removeEdge(next->name.name);
+            }
+        }
+    }
+
+    if (!changes)
+        return parser;
+
+    // Cycles which became unreachable still have predecessors
+    std::set<cstring> reachable;
+    std::vector<cstring> work = { IR::ParserState::start };
+    while (!work.empty()) {
+        auto name = work.back();
+        work.pop_back();
+        if (!reachable.emplace(name).second)
+            continue;
+        if (auto s = ::get(byName, name))
+            for (auto n : successors(s))
+                work.push_back(n);
+    }
+    IR::IndexedVector<IR::ParserState> result;
+    for (auto name : order) {
+        auto s = ::get(byName, name);
+        if (s == nullptr)
+            continue;
+        if (s->isBuiltin() || reachable.count(name))
+            result.push_back(s);
+        else
+            LOG2("Removing unreachable state " << dbp(s));
+    }
+    LOG1("Parser " << parser->name << ": " << before << " states before fusion, "
+         << result.size() << " after");
+    parser->states = result;
+    return parser;
+}
+
+}  // namespace P4
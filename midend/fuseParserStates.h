@@ -0,0 +1,54 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef _MIDEND_FUSEPARSERSTATES_H_
+#define _MIDEND_FUSEPARSERSTATES_H_
+
+#include "ir/ir.h"
+
+namespace P4 {
+
+/**
+ * Reduces the number of state transitions executed for each packet.
+ * A state which transitions unconditionally to a state 's' is fused
+ * with 's': the statements of 's' are appended to its own and it
+ * takes over the transition of 's'.
+ *
+ * SimplifyParsers already collapses chains where 's' has a single
+ * predecessor.  This pass also fuses states into each of their
+ * unconditional predecessors when 's' has several, duplicating 's',
+ * as long as the fused state has at most maxStatements statements.
+ * States which become unreachable are removed.
+ *
+ * The start, accept and reject states, and states with annotations
+ * other than @name, are never fused into their predecessors.
+ *
+ * @pre Parser state names are unique; should run after MoveDeclarations.
+ */
+class FuseParserStates : public Transform {
+    unsigned maxStatements;
+
+ public:
+    explicit FuseParserStates(unsigned maxStatements = 16) : maxStatements(maxStatements)
+    { setName("FuseParserStates"); }
+    const IR::Node* preorder(IR::P4Parser* parser) override;
+    const IR::Node* preorder(IR::P4Control* control) override
+    { prune(); return control; }
+};
+
+}  // namespace P4
+
+#endif /* _MIDEND_FUSEPARSERSTATES_H_ */
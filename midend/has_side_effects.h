@@ -18,18 +18,16 @@ limitations under the License.
 #define MIDEND_HAS_SIDE_EFFECTS_H_
 
 #include "ir/ir.h"
+#include "nodeSummary.h"
 
 /* Should this be a method on IR::Expression? */
 
-class hasSideEffects : public Inspector {
-    bool result = false;
-    bool preorder(const IR::AssignmentStatement *) override { return !(result = true); }
-    /* FIXME -- currently assuming all calls and primitves have side effects */
-    bool preorder(const IR::MethodCallExpression *) override { return !(result = true); }
-    bool preorder(const IR::Primitive *) override { return !(result = true); }
-    bool preorder(const IR::Expression *) override { return !result; }
+/* FIXME -- currently assuming all calls and primitves have side effects */
+class hasSideEffects {
+    bool result;
  public:
-    explicit hasSideEffects(const IR::Expression *e) { e->apply(*this); }
+    explicit hasSideEffects(const IR::Expression *e)
+            : result(NodeSummary::get(e)->sideEffects) {}
     explicit operator bool () { return result; }
 };
 
@@ -8,7 +8,7 @@ namespace P4 {
 unsigned SymbolicValue::crtid = 0;
 
 SymbolicValue* SymbolicValueFactory::create(const IR::Type* type, bool uninitialized) const {
-    type = typeMap->getType(type, true);
+    type = typeMap->getTypeType(type, true);
     if (type->is<IR::Type_Bits>())
         return new SymbolicInteger(ScalarValue::init(uninitialized), type->to<IR::Type_Bits>());
     if (type->is<IR::Type_Boolean>())
@@ -53,7 +53,7 @@ SymbolicValue* SymbolicValueFactory::create(const IR::Type* type, bool uninitial
 }
 
 bool SymbolicValueFactory::isFixedWidth(const IR::Type* type) const {
-    type = typeMap->getType(type, true);
+    type = typeMap->getTypeType(type, true);
     if (type->is<IR::Type_Varbits>())
         return false;
     if (type->is<IR::Type_Extern>())
@@ -79,7 +79,7 @@ bool SymbolicValueFactory::isFixedWidth(const IR::Type* type) const {
 }
 
 unsigned SymbolicValueFactory::getWidth(const IR::Type* type) const {
-    type = typeMap->getType(type, true);
+    type = typeMap->getTypeType(type, true);
     if (type->is<IR::Type_Bits>())
         return type->to<IR::Type_Bits>()->size;
     if (type->is<IR::Type_Boolean>())
@@ -153,6 +153,13 @@ bool SymbolicBool::equals(const SymbolicValue* other) const {
     return true;
 }
 
+size_t SymbolicBool::hash() const {
+    size_t result = static_cast<size_t>(state);
+    if (isKnown())
+        result = combine(result, value);
+    return result;
+}
+
 bool SymbolicInteger::merge(const SymbolicValue* other) {
     BUG_CHECK(other->is<SymbolicInteger>(), "%1%: expected an integer", other);
     auto io = other->to<SymbolicInteger>();
@@ -184,6 +191,13 @@ bool SymbolicInteger::equals(const SymbolicValue* other) const {
     return true;
 }
 
+size_t SymbolicInteger::hash() const {
+    size_t result = static_cast<size_t>(state);
+    if (isKnown())
+        result = combine(result, constant->value.get_ui());
+    return result;
+}
+
 bool SymbolicVarbit::merge(const SymbolicValue* other) {
     BUG_CHECK(other->is<SymbolicVarbit>(), "%1%: expected a varbit", other);
     auto vo = other->to<SymbolicVarbit>();
@@ -206,6 +220,10 @@ bool SymbolicVarbit::equals(const SymbolicValue* other) const {
     return state == ab->state;
 }
 
+size_t SymbolicVarbit::hash() const {
+    return static_cast<size_t>(state);
+}
+
 void SymbolicEnum::assign(const SymbolicValue* other) {
     BUG_CHECK(other->is<SymbolicEnum>(), "%1%: expected an enum", other);
     auto bo = other->to<SymbolicEnum>();
@@ -233,6 +251,13 @@ bool SymbolicEnum::equals(const SymbolicValue* other) const {
     return true;
 }
 
+size_t SymbolicEnum::hash() const {
+    size_t result = static_cast<size_t>(state);
+    if (isKnown())
+        result = combine(result, std::hash<cstring>()(value.name));
+    return result;
+}
+
 //////////////////////////////////////////////////////////////////////////////////
 
 SymbolicStruct::SymbolicStruct(const IR::Type_StructLike* type, bool uninitialized,
@@ -283,6 +308,13 @@ bool SymbolicStruct::equals(const SymbolicValue* other) const {
     return true;
 }
 
+size_t SymbolicStruct::hash() const {
+    size_t result = 0;
+    for (auto f : fieldValue)
+        result = combine(result, f.second->hash());
+    return result;
+}
+
 bool SymbolicStruct::hasUninitializedParts() const {
     for (auto f : fieldValue)
         if (f.second->hasUninitializedParts())
@@ -368,6 +400,14 @@ bool SymbolicHeader::equals(const SymbolicValue* other) const {
     return SymbolicStruct::equals(other);
 }
 
+size_t SymbolicHeader::hash() const {
+    size_t result = valid->hash();
+    if (valid->isKnown() && !valid->value)
+        // Invalid headers are equal
+        return result;
+    return combine(result, SymbolicStruct::hash());
+}
+
 void SymbolicHeader::dbprint(std::ostream& out) const {
     out << "{ ";
     out << "valid=>";
@@ -467,6 +507,13 @@ bool SymbolicArray::equals(const SymbolicValue* other) const {
     return true;
 }
 
+size_t SymbolicArray::hash() const {
+    size_t result = 0;
+    for (auto v : values)
+        result = combine(result, v->hash());
+    return result;
+}
+
 bool SymbolicArray::hasUninitializedParts() const {
     for (unsigned i=0; i < values.size(); i++)
         if (values.at(i)->hasUninitializedParts())
@@ -547,6 +594,13 @@ bool SymbolicTuple::equals(const SymbolicValue* other) const {
     return true;
 }
 
+size_t SymbolicTuple::hash() const {
+    size_t result = 0;
+    for (auto v : values)
+        result = combine(result, v->hash());
+    return result;
+}
+
 bool SymbolicTuple::hasUninitializedParts() const {
     for (unsigned i=0; i < values.size(); i++)
         if (values.at(i)->hasUninitializedParts())
@@ -973,7 +1027,7 @@ void ExpressionEvaluator::postorder(const IR::MethodCallExpression* expression)
         mi->actualMethodType->returnType->is<IR::Type_Void>()) {
         set(expression, SymbolicVoid::get());
     } else {
-        auto type = typeMap->getType(mi->actualMethodType->returnType, true);
+        auto type = typeMap->getTypeType(mi->actualMethodType->returnType, true);
         auto res = factory->create(type, false);
         set(expression, res);
     }
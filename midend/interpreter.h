@@ -54,8 +54,12 @@ class SymbolicValue {
     // Returns 'true' if merging changed the current value.
     virtual bool merge(const SymbolicValue* other) = 0;
     virtual bool equals(const SymbolicValue* other) const = 0;
+    // Hash consistent with 'equals': equal values have equal hashes.
+    virtual size_t hash() const = 0;
     // True if some parts of this value are definitely uninitialized
     virtual bool hasUninitializedParts() const = 0;
+    static size_t combine(size_t seed, size_t value)
+    { return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2)); }
 };
 
 // Creates values from type declarations
@@ -113,6 +117,14 @@ class ValueMap final : public IHasDbPrint {
         }
         return change;
     }
+    size_t hash() const {
+        size_t result = 0;
+        for (auto v : map)
+            result = SymbolicValue::combine(
+                result, SymbolicValue::combine(std::hash<const void*>()(v.first),
+                                               v.second->hash()));
+        return result;
+    }
     bool equals(const ValueMap* other) const {
         BUG_CHECK(map.size() == other->map.size(), "Incompatible maps compared");
         for (auto v : map) {
@@ -197,6 +209,7 @@ class SymbolicException : public SymbolicError {
         return str.str();
     }
     bool equals(const SymbolicValue* other) const override;
+    size_t hash() const override { return static_cast<size_t>(exc); }
 };
 
 class SymbolicStaticError : public SymbolicError {
@@ -209,6 +222,7 @@ class SymbolicStaticError : public SymbolicError {
     { out << "Error: " << msg; }
     cstring message() const override { return msg; }
     bool equals(const SymbolicValue* other) const override;
+    size_t hash() const override { return std::hash<cstring>()(msg); }
 };
 
 class ScalarValue : public SymbolicValue {
@@ -266,6 +280,7 @@ class SymbolicVoid : public SymbolicValue {
     { BUG_CHECK(other->is<SymbolicVoid>(), "%1%: expected void", other); return false; }
     bool equals(const SymbolicValue* other) const override
     { return other == instance; }
+    size_t hash() const override { return 0; }
     bool hasUninitializedParts() const override
     { return false; }
 };
@@ -296,6 +311,7 @@ class SymbolicBool final : public ScalarValue {
     void assign(const SymbolicValue* other) override;
     bool merge(const SymbolicValue* other) override;
     bool equals(const SymbolicValue* other) const override;
+    size_t hash() const override;
 };
 
 class SymbolicInteger final : public ScalarValue {
@@ -322,6 +338,7 @@ class SymbolicInteger final : public ScalarValue {
     void assign(const SymbolicValue* other) override;
     bool merge(const SymbolicValue* other) override;
     bool equals(const SymbolicValue* other) const override;
+    size_t hash() const override;
 };
 
 class SymbolicVarbit final : public ScalarValue {
@@ -338,6 +355,7 @@ class SymbolicVarbit final : public ScalarValue {
     void assign(const SymbolicValue* other) override;
     bool merge(const SymbolicValue* other) override;
     bool equals(const SymbolicValue* other) const override;
+    size_t hash() const override;
 };
 
 // represents enum, error, and match_kind
@@ -360,6 +378,7 @@ class SymbolicEnum final : public ScalarValue {
     void assign(const SymbolicValue* other) override;
     bool merge(const SymbolicValue* other) override;
     bool equals(const SymbolicValue* other) const override;
+    size_t hash() const override;
 };
 
 class SymbolicStruct : public SymbolicValue {
@@ -387,6 +406,7 @@ class SymbolicStruct : public SymbolicValue {
     void assign(const SymbolicValue* other) override;
     bool merge(const SymbolicValue* other) override;
     bool equals(const SymbolicValue* other) const override;
+    size_t hash() const override;
     bool hasUninitializedParts() const override;
 };
 
@@ -404,6 +424,7 @@ class SymbolicHeader : public SymbolicStruct {
     void dbprint(std::ostream& out) const override;
     bool merge(const SymbolicValue* other) override;
     bool equals(const SymbolicValue* other) const override;
+    size_t hash() const override;
 };
 
 class SymbolicArray final : public SymbolicValue {
@@ -437,6 +458,7 @@ class SymbolicArray final : public SymbolicValue {
     void assign(const SymbolicValue* other) override;
     bool merge(const SymbolicValue* other) override;
     bool equals(const SymbolicValue* other) const override;
+    size_t hash() const override;
     bool hasUninitializedParts() const override;
 };
 
@@ -490,6 +512,7 @@ class SymbolicTuple final : public SymbolicValue {
     { values.push_back(value); }
     bool merge(const SymbolicValue* other) override;
     bool equals(const SymbolicValue* other) const override;
+    size_t hash() const override;
     bool hasUninitializedParts() const override;
 };
 
@@ -510,6 +533,7 @@ class SymbolicExtern : public SymbolicValue {
     { BUG("%1%: extern is read-only", this); }
     bool merge(const SymbolicValue*) override { return false; }
     bool equals(const SymbolicValue* other) const override;
+    size_t hash() const override { return 0; }
     bool hasUninitializedParts() const override
     { return false; }
 };
@@ -545,6 +569,8 @@ class SymbolicPacketIn final : public SymbolicExtern {
     { minimumStreamOffset += width; }
     bool merge(const SymbolicValue* other) override;
     bool equals(const SymbolicValue* other) const override;
+    // ignores the conservative flag, like equals
+    size_t hash() const override { return minimumStreamOffset; }
 };
 
 }  // namespace P4
@@ -54,15 +54,17 @@ class DoLocalCopyPropagation::ElimDead : public Transform {
      * we run this over just the block (body and declarations) after copyprop
      * of the block, so it only removes those vars declared in the block */
     DoLocalCopyPropagation &self;
+    const DoLocalCopyPropagation::VarInfo *lookup(cstring name) {
+        return self.available.get(self.names->id(name)); }
     const IR::Node *preorder(IR::Declaration_Variable *var) override {
-        if (auto local = ::getref(self.available, var->name)) {
+        if (auto local = lookup(var->name)) {
             if (local->local && !local->live) {
                 LOG3("  removing dead local " << var->name);
                 return nullptr; } }
         return var; }
     const IR::Statement *postorder(IR::AssignmentStatement *as) override {
         if (auto dest = lvalue_out(as->left)->to<IR::PathExpression>()) {
-            if (auto var = ::getref(self.available, dest->path->name)) {
+            if (auto var = lookup(dest->path->name)) {
                 if (var->local && !var->live) {
                     LOG3("  removing dead assignment to " << dest->path->name);
                     if (hasSideEffects(as->right))
@@ -130,67 +132,162 @@ class DoLocalCopyPropagation::RewriteTableKeys : public Transform {
     explicit RewriteTableKeys(DoLocalCopyPropagation &self) : self(self) {}
 };
 
+unsigned DoLocalCopyPropagation::VarMap::nextGeneration = 0;
+
+DoLocalCopyPropagation::VarMap::Chunk *DoLocalCopyPropagation::VarMap::writable(unsigned chunk) {
+    if (chunk >= chunks.size())
+        chunks.resize(chunk + 1, nullptr);
+    if (!chunks[chunk]) {
+        chunks[chunk] = new Chunk();
+        chunks[chunk]->owner = generation;
+    } else if (chunks[chunk]->owner != generation) {
+        // shared with another copy of the map; copy on write
+        chunks[chunk] = new Chunk(*chunks[chunk]);
+        chunks[chunk]->owner = generation; }
+    return chunks[chunk];
+}
+
+DoLocalCopyPropagation::VarInfo &DoLocalCopyPropagation::VarMap::operator[](unsigned id) {
+    auto &var = writable(id >> chunkBits)->vars[id & (chunkSize - 1)];
+    if (!var.present) {
+        var.present = true;
+        ++count; }
+    return var;
+}
+
+void DoLocalCopyPropagation::VarMap::forEach(std::function<void(unsigned, VarInfo &)> fn) {
+    for (unsigned c = 0; c < chunks.size(); ++c) {
+        if (!chunks[c]) continue;
+        auto *chunk = writable(c);
+        for (unsigned i = 0; i < chunkSize; ++i)
+            if (chunk->vars[i].present)
+                fn((c << chunkBits) + i, chunk->vars[i]); }
+}
+
+void DoLocalCopyPropagation::VarMap::merge(const VarMap &a) {
+    for (unsigned c = 0; c < chunks.size(); ++c) {
+        if (!chunks[c]) continue;
+        const Chunk *other = c < a.chunks.size() ? a.chunks[c] : nullptr;
+        if (other == chunks[c]) continue;  // shared, so nothing can change
+        Chunk *chunk = nullptr;
+        for (unsigned i = 0; i < chunkSize; ++i) {
+            const VarInfo &var = chunks[c]->vars[i];
+            if (!var.present) continue;
+            const VarInfo *merge = other && other->vars[i].present ? &other->vars[i] : nullptr;
+            bool dropVal = var.val && (!merge || merge->val != var.val);
+            bool setLive = merge && merge->live && !var.live;
+            if (!dropVal && !setLive) continue;
+            if (!chunk) chunk = writable(c);
+            if (dropVal) chunk->vars[i].val = nullptr;
+            if (setLive) chunk->vars[i].live = true; } }
+}
+
+namespace {
+/// Collects the names of the variables referenced by an expression.
+class CollectRoots : public Inspector {
+    std::set<cstring> &roots;
+    bool preorder(const IR::Path *p) override { roots.insert(p->name); return false; }
+    bool preorder(const IR::Primitive *p) override { roots.insert(p->name); return true; }
+ public:
+    explicit CollectRoots(std::set<cstring> &roots) : roots(roots) {}
+};
+
+/// the variable name part of an lvalue name (before any field or index)
+cstring rootName(cstring name) {
+    return name.before(name.c_str() + strcspn(name.c_str(), ".["));
+}
+}  // namespace
+
+unsigned DoLocalCopyPropagation::NameIndex::id(cstring name) {
+    auto it = ids.find(name);
+    if (it != ids.end())
+        return it->second;
+    unsigned rv = names.size();
+    ids.emplace(name, rv);
+    names.push_back(name);
+    prefixes.emplace_back();
+    extensions.emplace_back();
+    for (const char *pfx = name.c_str(); *pfx; pfx += strspn(pfx, ".[")) {
+        pfx += strcspn(pfx, ".[");
+        if (!*pfx) break;  // the name itself
+        unsigned p = id(name.before(pfx));
+        prefixes[rv].push_back(p);
+        // keep extensions sorted by name, so they are visited in a deterministic order
+        auto &ext = extensions[p];
+        auto pos = std::upper_bound(ext.begin(), ext.end(), name,
+            [this](cstring n, unsigned e) { return n < names[e]; });
+        ext.insert(pos, rv); }
+    return rv;
+}
+
 void DoLocalCopyPropagation::flow_merge(Visitor &a_) {
     auto &a = dynamic_cast<DoLocalCopyPropagation &>(a_);
     BUG_CHECK(working == a.working, "inconsitent DoLocalCopyPropagation state on merge");
-    for (auto &var : available) {
-        if (auto merge = ::getref(a.available, var.first)) {
-            if (merge->val != var.second.val)
-                var.second.val = nullptr;
-            if (merge->live)
-                var.second.live = true;
-        } else {
-            var.second.val = nullptr; } }
+    available.merge(a.available);
     need_key_rewrite |= a.need_key_rewrite;
 }
 
-/// test to see if names denote overlapping locations
-bool DoLocalCopyPropagation::name_overlap(cstring name1, cstring name2) {
-    if (name1 == name2) return true;
-    if (name1.startsWith(name2) && strchr(".[", name1.get(name2.size())))
-        return true;
-    if (name2.startsWith(name1) && strchr(".[", name2.get(name1.size())))
-        return true;
-    return false;
+void DoLocalCopyPropagation::setValue(cstring name, const IR::Expression *val) {
+    unsigned id = names->id(name);
+    available[id].val = val;
+    // remember which roots the value uses, so dropValuesUsing can find it
+    std::set<cstring> roots;
+    val->apply(CollectRoots(roots));
+    for (auto root : roots) {
+        unsigned r = names->id(root);
+        if (r >= names->users.size())
+            names->users.resize(r + 1);
+        names->users[r].insert(id); }
 }
 
 void DoLocalCopyPropagation::forOverlapAvail(cstring name, std::function<void(VarInfo *)> fn) {
-    for (const char *pfx = name.c_str(); *pfx; pfx += strspn(pfx, ".[")) {
-        pfx += strcspn(pfx, ".[");
-        if (auto var = ::getref(available, name.before(pfx)))
-            fn(var); }
-    for (auto it = available.upper_bound(name); it != available.end(); ++it) {
-        if (!it->first.startsWith(name) || !strchr(".[", it->first.get(name.size())))
-            break;
-        fn(&it->second); }
+    unsigned id = names->id(name);
+    // prefixes (shortest first), the name itself, then the extensions
+    for (auto p : names->prefixes[id])
+        if (auto var = available.getref(p))
+            fn(var);
+    if (auto var = available.getref(id))
+        fn(var);
+    for (auto e : names->extensions[id])
+        if (auto var = available.getref(e))
+            fn(var);
 }
 
 void DoLocalCopyPropagation::dropValuesUsing(cstring name) {
     LOG6("dropValuesUsing(" << name << ")");
-    for (auto &var : available) {
-        LOG7("  checking " << var.first << " = " << var.second.val);
-        if (name_overlap(var.first, name)) {
-            LOG4("   dropping " << (var.second.val ? "" : "(nop) ") << "as " << name <<
-                 " is being assigned to");
-            var.second.val = nullptr;
-        } else if (var.second.val && exprUses(var.second.val, name)) {
-            LOG4("   dropping " << (var.second.val ? "" : "(nop) ") << var.first <<
-                 " as it uses " << name);
-            var.second.val = nullptr; } }
+    unsigned id = names->id(name);
+    auto drop = [&](unsigned v) {
+        auto var = available.get(v);
+        if (var && var->val) {
+            LOG4("   dropping as " << name << " is being assigned to");
+            available.getref(v)->val = nullptr; } };
+    for (auto p : names->prefixes[id])
+        drop(p);
+    drop(id);
+    for (auto e : names->extensions[id])
+        drop(e);
+    unsigned root = names->id(rootName(name));
+    if (root >= names->users.size())
+        return;
+    for (auto v : names->users[root]) {
+        auto var = available.get(v);
+        if (var && var->val && exprUses(var->val, name)) {
+            LOG4("   dropping " << names->names[v] << " as it uses " << name);
+            available.getref(v)->val = nullptr; } }
 }
 
 void DoLocalCopyPropagation::visit_local_decl(const IR::Declaration_Variable *var) {
     LOG4("Visiting " << var);
-    if (available.count(var->name))
+    unsigned id = names->id(var->name);
+    if (available.get(id))
         BUG("duplicate var declaration for %s", var->name);
-    auto &local = available[var->name];
-    local.local = true;
+    available[id].local = true;
     if (var->initializer) {
         if (!hasSideEffects(var->initializer)) {
             LOG3("  saving init value for " << var->name << ": " << var->initializer);
-            local.val = var->initializer;
+            setValue(var->name, var->initializer);
         } else {
-            local.live = true; } }
+            available[id].live = true; } }
 }
 
 const IR::Node *DoLocalCopyPropagation::postorder(IR::Declaration_Variable *var) {
@@ -226,7 +323,7 @@ const IR::Expression *DoLocalCopyPropagation::copyprop_name(cstring name) {
             if (inferForFunc)
                 inferForFunc->reads.insert(name); }
         return nullptr; }
-    if (auto var = ::getref(available, name)) {
+    if (auto var = getAvail(name)) {
         if (var->val) {
             if (policy(getChildContext(), var->val)) {
                 LOG3("  propagating value for " << name << ": " << var->val);
@@ -323,7 +420,7 @@ IR::AssignmentStatement *DoLocalCopyPropagation::postorder(IR::AssignmentStateme
                  * may make things worse rather than better */
                 return as; }
             LOG3("  saving value for " << dest << ": " << as->right);
-            available[dest].val = as->right; }
+            setValue(dest, as->right); }
     } else {
         LOG3("dest of assignment is " << as->left << " so skipping");
     }
@@ -399,10 +496,10 @@ IR::MethodCallExpression *DoLocalCopyPropagation::postorder(IR::MethodCallExpres
             apply_function(&actions[fn->path->name]);
             return mc; } }
     LOG3("unknown method call " << mc->method << " clears all nonlocal saved values");
-    for (auto &var : Values(available)) {
+    available.forEach([](unsigned, VarInfo &var) {
         if (!var.local) {
             var.val = nullptr;
-            var.live = true; } }
+            var.live = true; } });
     return mc;
 }
 
@@ -423,6 +520,7 @@ IR::P4Action *DoLocalCopyPropagation::postorder(IR::P4Action *act) {
     act->body = act->body->apply(ElimDead(*this))->to<IR::BlockStatement>();
     working = false;
     available.clear();
+    names->users.clear();
     LOG3("DoLocalCopyPropagation finished action " << act->name);
     LOG4("reads=" << inferForFunc->reads << " writes=" << inferForFunc->writes);
     LOG4(act);
@@ -449,6 +547,7 @@ IR::Function *DoLocalCopyPropagation::postorder(IR::Function *fn) {
     fn->body = fn->body->apply(ElimDead(*this))->to<IR::BlockStatement>();
     working = false;
     available.clear();
+    names->users.clear();
     LOG3("DoLocalCopyPropagation finished function " << name);
     LOG4("reads=" << inferForFunc->reads << " writes=" << inferForFunc->writes);
     LOG4(fn);
@@ -459,6 +558,7 @@ IR::Function *DoLocalCopyPropagation::postorder(IR::Function *fn) {
 IR::P4Control *DoLocalCopyPropagation::preorder(IR::P4Control *ctrl) {
     visitOnce();
     BUG_CHECK(!working && available.empty(), "corrupt internal data struct");
+    names = new NameIndex;
     visit(ctrl->type, "type");
     visit(ctrl->constructorParams, "constructorParams");
     visit(ctrl->controlLocals, "controlLocals");
@@ -479,6 +579,7 @@ IR::P4Control *DoLocalCopyPropagation::preorder(IR::P4Control *ctrl) {
     ctrl->body = ctrl->body->apply(ElimDead(*this))->to<IR::BlockStatement>();
     working = false;
     available.clear();
+    names->users.clear();
     LOG3("DoLocalCopyPropagation finished control " << ctrl->name);
     LOG4(ctrl);
     prune();
@@ -52,10 +52,64 @@ if legal to do so.
 class DoLocalCopyPropagation : public ControlFlowVisitor, Transform, P4WriteContext {
     bool                        working = false;
     struct VarInfo {
+        bool                    present = false;  // has an entry in the VarMap
         bool                    local = false;
         bool                    live = false;
         const IR::Expression    *val = nullptr;
     };
+    /* Interned names of all the lvalues tracked.  A new index is created for each
+     * control and shared by all the clones of the visitor made while working on it,
+     * so ids are consistent between the states that are merged */
+    struct NameIndex {
+        std::unordered_map<cstring, unsigned>   ids;
+        std::vector<cstring>                    names;
+        /* for each name, the other names that denote overlapping locations:
+         * the prefixes (a for a.b, shortest first) and the extensions
+         * (a.b.c for a.b, sorted by name) */
+        std::vector<std::vector<unsigned>>      prefixes, extensions;
+        /* for each root variable name, the variables whose saved value may
+         * refer to it.  Conservative: the clones share the index, so entries are
+         * only removed when the state is cleared at the end of a block */
+        std::vector<std::set<unsigned>>         users;
+        unsigned id(cstring name);
+    };
+    /* Map from name ids to VarInfo, persistent with structural sharing: copies
+     * share all chunks, and a chunk is copied only when one of the copies first
+     * modifies it.  This makes flow_clone at every branch O(number of chunks) */
+    class VarMap {
+        enum { chunkBits = 6, chunkSize = 1 << chunkBits };
+        struct Chunk {
+            unsigned            owner;
+            VarInfo             vars[chunkSize];
+        };
+        std::vector<Chunk *>    chunks;
+        size_t                  count = 0;
+        mutable unsigned        generation;
+        static unsigned         nextGeneration;
+        Chunk *writable(unsigned chunk);
+
+     public:
+        VarMap() : generation(nextGeneration++) {}
+        VarMap(const VarMap &other) : chunks(other.chunks), count(other.count),
+                                      generation(nextGeneration++) {
+            // the source must not modify the chunks it now shares with us either
+            other.generation = nextGeneration++; }
+        VarMap &operator=(const VarMap &) = delete;
+        const VarInfo *get(unsigned id) const {
+            if ((id >> chunkBits) >= chunks.size() || !chunks[id >> chunkBits]) return nullptr;
+            auto *rv = &chunks[id >> chunkBits]->vars[id & (chunkSize - 1)];
+            return rv->present ? rv : nullptr; }
+        VarInfo *getref(unsigned id) {
+            if (!get(id)) return nullptr;
+            return &writable(id >> chunkBits)->vars[id & (chunkSize - 1)]; }
+        VarInfo &operator[](unsigned id);
+        bool empty() const { return count == 0; }
+        void clear() { chunks.clear(); count = 0; }
+        /* call fn for each entry, unsharing the chunks as needed */
+        void forEach(std::function<void(unsigned, VarInfo &)> fn);
+        /* merge 'other' into this; chunks that are shared are skipped */
+        void merge(const VarMap &other);
+    };
     struct TableInfo {
         std::set<cstring>       keyreads, actions;
         int                                             apply_count = 0;
@@ -64,7 +118,8 @@ class DoLocalCopyPropagation : public ControlFlowVisitor, Transform, P4WriteCont
     struct FuncInfo {
         std::set<cstring>       reads, writes;
     };
-    std::map<cstring, VarInfo>          available;
+    NameIndex                           *names;
+    VarMap                              available;
     std::map<cstring, TableInfo>        &tables;
     std::map<cstring, FuncInfo>         &actions;
     std::map<cstring, FuncInfo>         &methods;
@@ -75,7 +130,8 @@ class DoLocalCopyPropagation : public ControlFlowVisitor, Transform, P4WriteCont
 
     DoLocalCopyPropagation *clone() const override { return new DoLocalCopyPropagation(*this); }
     void flow_merge(Visitor &) override;
-    bool name_overlap(cstring, cstring);
+    VarInfo *getAvail(cstring name) { return available.getref(names->id(name)); }
+    void setValue(cstring name, const IR::Expression *val);
     void forOverlapAvail(cstring, std::function<void(VarInfo *)>);
     void dropValuesUsing(cstring);
 
@@ -108,7 +164,8 @@ class DoLocalCopyPropagation : public ControlFlowVisitor, Transform, P4WriteCont
  public:
     explicit DoLocalCopyPropagation(
         std::function<bool(const Context *, const IR::Expression *)> policy)
-    : tables(*new std::map<cstring, TableInfo>), actions(*new std::map<cstring, FuncInfo>),
+    : names(new NameIndex), tables(*new std::map<cstring, TableInfo>),
+      actions(*new std::map<cstring, FuncInfo>),
       methods(*new std::map<cstring, FuncInfo>), policy(policy)
     { setName("DoLocalCopyPropagation"); }
 };
@@ -0,0 +1,256 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "nodeSummary.h"
+
+namespace {
+
+// Summaries are dropped when the cache grows beyond this size
+const size_t maxCachedSummaries = 1 << 18;
+
+typedef std::unordered_map<const IR::Node*, const NodeSummary*> SummaryCache;
+
+SummaryCache& summaryCache() {
+    static SummaryCache cache;
+    return cache;
+}
+
+void insertSorted(std::vector<unsigned>& into, unsigned value) {
+    auto it = std::lower_bound(into.begin(), into.end(), value);
+    if (it == into.end() || *it != value)
+        into.insert(it, value);
+}
+
+void eraseSorted(std::vector<unsigned>& from, unsigned value) {
+    auto it = std::lower_bound(from.begin(), from.end(), value);
+    if (it != from.end() && *it == value)
+        from.erase(it);
+}
+
+void mergeSorted(std::vector<unsigned>& into, const std::vector<unsigned>& from) {
+    if (from.empty())
+        return;
+    std::vector<unsigned> result;
+    result.reserve(into.size() + from.size());
+    std::set_union(into.begin(), into.end(), from.begin(), from.end(),
+                   std::back_inserter(result));
+    into.swap(result);
+}
+
+/// Computes the summaries of a node and all its subtrees which
+/// are not already in the cache.
+class Summarize : public Inspector {
+    SummaryCache& cache;
+    std::vector<NodeSummary*> stack;
+
+    void add(const NodeSummary* summary) {
+        if (stack.empty()) {
+            result = summary;
+            return;
+        }
+        auto top = stack.back();
+        top->sideEffects = top->sideEffects || summary->sideEffects;
+        mergeSorted(top->reads, summary->reads);
+        mergeSorted(top->writes, summary->writes);
+    }
+    const NodeSummary* summary(const IR::Node* node) const {
+        auto it = cache.find(node);
+        BUG_CHECK(it != cache.end(), "%1%: not summarized", node);
+        return it->second;
+    }
+    // A location extended by a field access or constant index
+    void refine(NodeSummary* top, const NodeSummary* base, cstring component) {
+        top->location = Locations::child(base->location, component);
+        top->refinable = true;
+        eraseSorted(top->reads, base->location);
+        insertSorted(top->reads, top->location);
+    }
+
+ public:
+    const NodeSummary* result = nullptr;
+
+    explicit Summarize(SummaryCache& cache) : cache(cache)
+    { visitDagOnce = false; setName("Summarize"); }
+
+    bool preorder(const IR::Node* node) override {
+        auto it = cache.find(node);
+        if (it != cache.end()) {
+            add(it->second);
+            return false;
+        }
+        stack.push_back(new NodeSummary());
+        return true;
+    }
+    void postorder(const IR::Node* node) override {
+        auto top = stack.back();
+        stack.pop_back();
+        cache.emplace(node, top);
+        add(top);
+    }
+
+    void postorder(const IR::PathExpression* expression) override {
+        auto top = stack.back();
+        top->location = Locations::intern(expression->path->name.name);
+        top->refinable = true;
+        insertSorted(top->reads, top->location);
+        postorder(expression->to<IR::Node>());
+    }
+    void postorder(const IR::Member* member) override {
+        auto base = summary(member->expr);
+        if (base->location != Locations::none) {
+            auto top = stack.back();
+            if (!base->refinable ||
+                (member->expr->type != nullptr &&
+                 member->expr->type->is<IR::Type_HeaderUnion>())) {
+                // all fields of a union overlap
+                top->location = base->location;
+                top->refinable = false;
+            } else {
+                refine(top, base, cstring(".") + member->member.name);
+            }
+        }
+        postorder(member->to<IR::Node>());
+    }
+    void postorder(const IR::ArrayIndex* expression) override {
+        auto base = summary(expression->left);
+        if (base->location != Locations::none) {
+            auto top = stack.back();
+            auto index = expression->right->to<IR::Constant>();
+            if (!base->refinable || index == nullptr) {
+                top->location = base->location;
+                top->refinable = false;
+            } else {
+                refine(top, base, "[" + index->value.get_str() + "]");
+            }
+        }
+        postorder(expression->to<IR::Node>());
+    }
+    void postorder(const IR::AssignmentStatement* statement) override {
+        auto top = stack.back();
+        auto left = summary(statement->left);
+        auto right = summary(statement->right);
+        top->sideEffects = true;
+        // The destination itself is written, not read
+        top->reads = left->reads;
+        if (left->location != Locations::none) {
+            eraseSorted(top->reads, left->location);
+            insertSorted(top->writes, left->location);
+        }
+        mergeSorted(top->reads, right->reads);
+        postorder(statement->to<IR::Node>());
+    }
+    void postorder(const IR::MethodCallExpression* expression) override {
+        auto top = stack.back();
+        // FIXME -- currently assuming all calls have side effects,
+        // and may write all their lvalue arguments.
+        top->sideEffects = true;
+        for (auto arg : *expression->arguments) {
+            auto location = summary(arg->expression)->location;
+            if (location != Locations::none)
+                insertSorted(top->writes, location);
+        }
+        postorder(expression->to<IR::Node>());
+    }
+    void postorder(const IR::Primitive* primitive) override {
+        auto top = stack.back();
+        top->sideEffects = true;
+        insertSorted(top->reads, Locations::intern(primitive->name));
+        postorder(primitive->to<IR::Node>());
+    }
+};
+
+}  // namespace
+
+Locations& Locations::instance() {
+    static Locations locations;
+    return locations;
+}
+
+unsigned Locations::intern(cstring name) {
+    auto& table = instance();
+    std::string full = name.c_str();
+    auto it = table.ids.find(full);
+    if (it != table.ids.end())
+        return it->second;
+    // Intern each enclosing location: "a", "a.b", "a.b[1]"
+    size_t end = full.find_first_of(".[");
+    unsigned loc = none;
+    while (true) {
+        std::string prefix = full.substr(0, end);
+        auto found = table.ids.find(prefix);
+        if (found != table.ids.end()) {
+            loc = found->second;
+        } else {
+            unsigned depth = loc == none ? 0 : table.locations.at(loc).depth + 1;
+            table.locations.push_back({ loc, depth });
+            table.names.push_back(prefix);
+            loc = table.locations.size() - 1;
+            table.ids.emplace(prefix, loc);
+        }
+        if (end == std::string::npos)
+            break;
+        end = full.find_first_of(".[", end + 1);
+    }
+    return loc;
+}
+
+unsigned Locations::child(unsigned parent, cstring component) {
+    BUG_CHECK(parent != none, "child of no location");
+    return intern(instance().names.at(parent) + component.c_str());
+}
+
+bool Locations::overlap(unsigned left, unsigned right) {
+    if (left == none || right == none)
+        return false;
+    auto& table = instance();
+    while (table.locations.at(left).depth > table.locations.at(right).depth)
+        left = table.locations.at(left).parent;
+    while (table.locations.at(right).depth > table.locations.at(left).depth)
+        right = table.locations.at(right).parent;
+    return left == right;
+}
+
+bool NodeSummary::readsLocation(unsigned loc) const {
+    for (auto r : reads)
+        if (Locations::overlap(r, loc))
+            return true;
+    return false;
+}
+
+bool NodeSummary::writesLocation(unsigned loc) const {
+    for (auto w : writes)
+        if (Locations::overlap(w, loc))
+            return true;
+    return false;
+}
+
+const NodeSummary* NodeSummary::get(const IR::Node* node) {
+    CHECK_NULL(node);
+    auto& cache = summaryCache();
+    auto it = cache.find(node);
+    if (it != cache.end())
+        return it->second;
+    if (cache.size() > maxCachedSummaries)
+        cache.clear();
+    Summarize summarize(cache);
+    node->apply(summarize);
+    BUG_CHECK(summarize.result != nullptr, "%1%: not summarized", node);
+    return summarize.result;
+}
+
+void NodeSummary::clearCache() {
+    summaryCache().clear();
+}
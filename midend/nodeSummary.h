@@ -0,0 +1,78 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef MIDEND_NODESUMMARY_H_
+#define MIDEND_NODESUMMARY_H_
+
+#include "ir/ir.h"
+
+/// Interned names of storage locations: a variable with optional field
+/// names and constant array indexes, e.g. "hdr.h[2].f".  Each location
+/// is identified by an integer, and knows its enclosing location.
+class Locations {
+    struct Location {
+        unsigned parent;
+        unsigned depth;
+    };
+    std::vector<Location> locations;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, unsigned> ids;
+
+    static Locations& instance();
+
+ public:
+    static const unsigned none = ~0U;
+    /// The location named 'name'; e.g. "a.b[1]" is the element [1] of "a.b".
+    static unsigned intern(cstring name);
+    /// The location named 'component' (".f" or "[3]") within 'parent'.
+    static unsigned child(unsigned parent, cstring component);
+    /// True if one location contains the other.
+    static bool overlap(unsigned left, unsigned right);
+};
+
+/**
+ * A memoized summary of an IR subtree: whether it has side-effects,
+ * and the locations it reads and writes.  Summaries are cached by
+ * node identity; since IR nodes are never modified in place, a
+ * cached summary remains valid as long as its node exists.  The
+ * summaries of all subtrees are cached as well, so summarizing an
+ * expression and then one of its parts is cheap.
+ *
+ * All method calls are assumed to have side-effects, and their
+ * lvalue arguments are assumed to be written.  A field of a header
+ * union or an element of a stack with a non-constant index is
+ * summarized as the whole union or stack.
+ */
+class NodeSummary {
+ public:
+    bool sideEffects = false;
+    /// Sorted location ids
+    std::vector<unsigned> reads;
+    std::vector<unsigned> writes;
+    /// Location denoted by the node itself if it is an lvalue.
+    unsigned location = Locations::none;
+    /// False if 'location' cannot be refined by field accesses or
+    /// indexing, e.g., the location of a header union.
+    bool refinable = false;
+
+    bool readsLocation(unsigned loc) const;
+    bool writesLocation(unsigned loc) const;
+
+    static const NodeSummary* get(const IR::Node* node);
+    static void clearCache();
+};
+
+#endif /* MIDEND_NODESUMMARY_H_ */
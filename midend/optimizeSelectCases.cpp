@@ -0,0 +1,271 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "optimizeSelectCases.h"
+#include "lib/gmputil.h"
+
+namespace P4 {
+
+namespace {
+
+/// A constant keyset: a value and mask for each select component.
+struct Keyset {
+    std::vector<mpz_class> value;
+    std::vector<mpz_class> mask;
+
+    /// True if every value matched by 'other' is matched by this keyset.
+    bool covers(const Keyset& other) const {
+        for (size_t i = 0; i < value.size(); i++) {
+            if ((mask[i] & ~other.mask[i]) != 0)
+                return false;
+            if ((other.value[i] & mask[i]) != value[i])
+                return false;
+        }
+        return true;
+    }
+    bool isDefault() const {
+        for (auto& m : mask)
+            if (m != 0)
+                return false;
+        return true;
+    }
+    bool disjoint(const Keyset& other) const {
+        for (size_t i = 0; i < value.size(); i++)
+            if (((value[i] ^ other.value[i]) & mask[i] & other.mask[i]) != 0)
+                return true;
+        return false;
+    }
+    /// If the two keysets differ in a single value bit, clear that bit
+    /// from this keyset's mask so it matches both.
+    bool merge(const Keyset& other) {
+        size_t differing = value.size();
+        for (size_t i = 0; i < value.size(); i++) {
+            if (mask[i] != other.mask[i])
+                return false;
+            if (value[i] == other.value[i])
+                continue;
+            mpz_class diff = value[i] ^ other.value[i];
+            if (differing != value.size() || (diff & (diff - 1)) != 0)
+                return false;
+            differing = i;
+        }
+        if (differing == value.size())
+            return false;
+        mask[differing] &= ~(value[differing] ^ other.value[differing]);
+        value[differing] &= mask[differing];
+        return true;
+    }
+};
+
+struct Case {
+    const IR::SelectCase* selectCase;
+    bool constant;  // keyset could be analyzed
+    bool changed;   // keyset must be rebuilt
+    Keyset keyset;
+};
+
+class SelectAnalysis {
+    const TypeMap* typeMap;
+    const IR::SelectExpression* expression;
+    std::vector<const IR::Type*> types;
+    std::vector<mpz_class> fullMasks;
+
+    bool parseElement(const IR::Expression* element, size_t index, Case& c) const {
+        auto full = fullMasks.at(index);
+        mpz_class value, mask;
+        if (element->is<IR::DefaultExpression>()) {
+            value = 0;
+            mask = 0;
+        } else if (auto k = element->to<IR::Constant>()) {
+            value = k->value & full;
+            mask = full;
+            c.changed = c.changed || value != k->value;
+        } else if (auto b = element->to<IR::BoolLiteral>()) {
+            value = b->value ? 1 : 0;
+            mask = full;
+        } else if (auto m = element->to<IR::Mask>()) {
+            auto v = m->left->to<IR::Constant>();
+            auto k = m->right->to<IR::Constant>();
+            if (v == nullptr || k == nullptr)
+                return false;
+            mask = k->value & full;
+            value = v->value & mask;
+            c.changed = c.changed || mask == 0 || mask == full || value != v->value;
+        } else {
+            return false;
+        }
+        c.keyset.value.push_back(value);
+        c.keyset.mask.push_back(mask);
+        return true;
+    }
+
+    const IR::Expression* element(const IR::Expression* original, size_t index,
+                                  const mpz_class& value, const mpz_class& mask) const {
+        auto type = types.at(index);
+        if (mask == 0)
+            return new IR::DefaultExpression(original->srcInfo);
+        if (mask == fullMasks.at(index)) {
+            if (type->is<IR::Type_Boolean>())
+                return new IR::BoolLiteral(original->srcInfo, value != 0);
+            return new IR::Constant(original->srcInfo, type, value, 16);
+        }
+        return new IR::Mask(original->srcInfo,
+                            new IR::Constant(original->srcInfo, type, value, 16),
+                            new IR::Constant(original->srcInfo, type, mask, 16));
+    }
+
+ public:
+    SelectAnalysis(const TypeMap* typeMap, const IR::SelectExpression* expression) :
+            typeMap(typeMap), expression(expression) {}
+
+    bool setup() {
+        for (auto e : expression->select->components) {
+            auto type = typeMap->getType(e);
+            if (type == nullptr)
+                return false;
+            int width = type->width_bits();
+            auto bits = type->to<IR::Type_Bits>();
+            if (width <= 0 ||
+                !(type->is<IR::Type_Boolean>() || (bits != nullptr && !bits->isSigned)))
+                return false;
+            types.push_back(type);
+            fullMasks.push_back(Util::mask(width));
+        }
+        return !types.empty();
+    }
+
+    Case parse(const IR::SelectCase* selectCase) const {
+        Case c = { selectCase, false, false, Keyset() };
+        auto keyset = selectCase->keyset;
+        bool ok = true;
+        if (keyset->is<IR::DefaultExpression>()) {
+            for (size_t i = 0; i < types.size(); i++) {
+                c.keyset.value.push_back(0);
+                c.keyset.mask.push_back(0);
+            }
+        } else if (auto list = keyset->to<IR::ListExpression>()) {
+            if (list->components.size() != types.size())
+                return c;
+            for (size_t i = 0; ok && i < types.size(); i++)
+                ok = parseElement(list->components.at(i), i, c);
+            c.changed = c.changed || (ok && c.keyset.isDefault());
+        } else if (types.size() == 1) {
+            ok = parseElement(keyset, 0, c);
+        } else {
+            ok = false;
+        }
+        c.constant = ok;
+        if (!ok) {
+            c.changed = false;
+            c.keyset = Keyset();
+        }
+        return c;
+    }
+
+    const IR::Expression* keyset(const Case& c) const {
+        auto original = c.selectCase->keyset;
+        if (c.keyset.isDefault())
+            return new IR::DefaultExpression(original->srcInfo);
+        if (types.size() == 1)
+            return element(original, 0, c.keyset.value.at(0), c.keyset.mask.at(0));
+        auto list = original->to<IR::ListExpression>();
+        IR::Vector<IR::Expression> components;
+        for (size_t i = 0; i < types.size(); i++)
+            components.push_back(element(list ? list->components.at(i) : original, i,
+                                         c.keyset.value.at(i), c.keyset.mask.at(i)));
+        return new IR::ListExpression(original->srcInfo, components);
+    }
+};
+
+}  // namespace
+
+const IR::Node* DoOptimizeSelectCases::preorder(IR::SelectExpression* expression) {
+    SelectAnalysis analysis(typeMap, getOriginal<IR::SelectExpression>());
+    if (!analysis.setup())
+        return expression;
+
+    std::vector<Case> cases;
+    for (auto sc : expression->selectCases)
+        cases.push_back(analysis.parse(sc));
+    size_t before = cases.size();
+
+    // Remove cases covered by an earlier case
+    for (size_t j = 1; j < cases.size(); ) {
+        bool shadowed = false;
+        if (cases[j].constant) {
+            for (size_t i = 0; i < j && !shadowed; i++)
+                shadowed = cases[i].constant && cases[i].keyset.covers(cases[j].keyset);
+        }
+        if (shadowed) {
+            LOG2("Removing unreachable case " << cases[j].selectCase);
+            cases.erase(cases.begin() + j);
+        } else {
+            j++;
+        }
+    }
+
+    // Merge each case with an earlier case with the same next state
+    bool merged = allowMasks;
+    while (merged) {
+        merged = false;
+        for (size_t j = 1; j < cases.size() && !merged; j++) {
+            if (!cases[j].constant)
+                continue;
+            for (size_t i = j; i-- > 0; ) {
+                auto& c = cases[i];
+                if (!c.constant)
+                    break;
+                bool sameState =
+                        c.selectCase->state->path->name == cases[j].selectCase->state->path->name;
+                if (sameState && c.keyset.merge(cases[j].keyset)) {
+                    LOG2("Merging " << cases[j].selectCase << " into " << c.selectCase);
+                    c.changed = true;
+                    cases.erase(cases.begin() + j);
+                    merged = true;
+                    break;
+                }
+                // case j cannot move before case i
+                if (!sameState && !c.keyset.disjoint(cases[j].keyset))
+                    break;
+            }
+        }
+    }
+
+    bool changes = cases.size() != before;
+    for (auto& c : cases)
+        changes = changes || c.changed;
+    if (!changes)
+        return expression;
+
+    LOG1(expression << ": " << before << " cases before, " << cases.size() << " after");
+    if (cases.size() == 1 && cases[0].constant && cases[0].keyset.isDefault())
+        // just one default label
+        return cases[0].selectCase->state;
+
+    IR::Vector<IR::SelectCase> result;
+    for (auto& c : cases) {
+        if (!c.changed) {
+            result.push_back(c.selectCase);
+            continue;
+        }
+        result.push_back(new IR::SelectCase(c.selectCase->srcInfo, analysis.keyset(c),
+                                            c.selectCase->state));
+    }
+    expression->selectCases = std::move(result);
+    return expression;
+}
+
+}  // namespace P4
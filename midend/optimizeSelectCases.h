@@ -0,0 +1,68 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef _MIDEND_OPTIMIZESELECTCASES_H_
+#define _MIDEND_OPTIMIZESELECTCASES_H_
+
+#include "ir/ir.h"
+#include "frontends/p4/typeChecking/typeChecker.h"
+
+namespace P4 {
+
+/**
+ * Reduces the number of cases of select expressions whose keysets are
+ * compile-time constants, without changing which state is selected:
+ * - masks are normalized: a mask covering all bits of the field
+ *   becomes an exact value, an empty mask becomes a don't care,
+ *   and value bits outside the mask are cleared;
+ * - a case covered by an earlier case is unreachable and removed;
+ * - if allowMasks is set, two cases with the same next state and
+ *   the same masks, whose values differ in a single bit, are merged
+ *   into one masked case.  A case is only merged with an earlier case
+ *   if it is disjoint from all the cases in between, so the match
+ *   order is preserved.  For example
+ *     16w0x0800: ipv4;  16w0x0806: arp;  16w0x0801: ipv4;
+ *   becomes
+ *     16w0x0800 &&& 16w0xfffe: ipv4;  16w0x0806: arp;
+ *
+ * Keysets which are value sets, ranges or non-constant expressions
+ * are left unchanged, and no case is moved across them.
+ *
+ * @pre Select labels are free of side-effects.
+ */
+class DoOptimizeSelectCases : public Transform {
+    const TypeMap* typeMap;
+    bool allowMasks;
+
+ public:
+    DoOptimizeSelectCases(const TypeMap* typeMap, bool allowMasks) :
+            typeMap(typeMap), allowMasks(allowMasks)
+    { CHECK_NULL(typeMap); setName("DoOptimizeSelectCases"); }
+    const IR::Node* preorder(IR::SelectExpression* expression) override;
+};
+
+class OptimizeSelectCases : public PassManager {
+ public:
+    OptimizeSelectCases(ReferenceMap* refMap, TypeMap* typeMap, bool allowMasks = true) {
+        passes.push_back(new TypeChecking(refMap, typeMap));
+        passes.push_back(new DoOptimizeSelectCases(typeMap, allowMasks));
+        setName("OptimizeSelectCases");
+    }
+};
+
+}  // namespace P4
+
+#endif /* _MIDEND_OPTIMIZESELECTCASES_H_ */
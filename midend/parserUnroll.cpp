@@ -1,3 +1,4 @@
+#include <unordered_map>
 #include "parserUnroll.h"
 #include "lib/stringify.h"
 
@@ -50,6 +51,10 @@ class ParserSymbolicInterpreter {
     SymbolicValueFactory* factory;
     ParserInfo*         synthesizedParser;  // output produced
     bool                unroll;
+    unsigned            budget;  // maximum number of states evaluated; 0 = unlimited
+    ParserUnrollStatistics& stats;
+    // States already explored, indexed by a hash of the state and its input
+    std::unordered_map<size_t, std::vector<const ParserStateInfo*>> explored;
 
     ValueMap* initializeVariables() {
         ValueMap* result = new ValueMap();
@@ -92,7 +97,8 @@ class ParserSymbolicInterpreter {
             stateName == IR::ParserState::reject)
             return nullptr;
         auto state = structure->get(stateName);
-        auto pi = new ParserStateInfo(stateName, parser, state, predecessor, values->clone());
+        // 'values' is never modified after evaluation, so it can be shared
+        auto pi = new ParserStateInfo(stateName, parser, state, predecessor, values);
         synthesizedParser->add(pi);
         return pi;
     }
@@ -113,22 +119,24 @@ class ParserSymbolicInterpreter {
         return result.str();
     }
 
+    // True if the original state also appears earlier in the state chain
+    static bool isStateClone(const ParserStateInfo* state) {
+        auto orig = state->state;
+        auto crt = state;
+        while (crt->predecessor != nullptr) {
+            crt = crt->predecessor;
+            if (crt->state == orig)
+                return true;
+        }
+        return false;
+    }
+
     // Return false if an error can be detected statically
     bool reportIfError(const ParserStateInfo* state, SymbolicValue* value) const {
         if (value->is<SymbolicException>()) {
             auto exc = value->to<SymbolicException>();
 
-            bool stateClone = false;
-            auto orig = state->state;
-            auto crt = state;
-            while (crt->predecessor != nullptr) {
-                crt = crt->predecessor;
-                if (crt->state == orig) {
-                    stateClone = true;
-                    break;
-                }
-            }
-
+            bool stateClone = isStateClone(state);
             if (!stateClone)
                 // errors in the original state are signalled
                 ::error("%1%: error %2% will be triggered\n%3%",
@@ -262,7 +270,7 @@ class ParserSymbolicInterpreter {
                 auto prevPackets = crt->before->filter(filter);
                 if (packets->equals(prevPackets)) {
                     bool conservative = false;
-                    for (auto p : state->before->map) {
+                    for (auto p : packets->map) {
                         auto pkt = p.second->to<SymbolicPacketIn>();
                         if (pkt->isConservative()) {
                             conservative = true;
@@ -292,9 +300,32 @@ class ParserSymbolicInterpreter {
         return false;
     }
 
+    // True if the same original state has already been explored starting
+    // from an equal set of values; otherwise records this state as explored.
+    bool alreadyExplored(ParserStateInfo* state) {
+        size_t key = SymbolicValue::combine(
+            std::hash<const void*>()(state->state), state->before->hash());
+        bool clone = isStateClone(state);
+        auto& bucket = explored[key];
+        for (auto e : bucket) {
+            if (e->state != state->state || !e->before->equals(state->before))
+                continue;
+            // Errors are not reported in clones, so a clone
+            // cannot stand in for an original state.
+            if (!clone && isStateClone(e))
+                continue;
+            LOG1("State " << state->state << " already explored as " << stateChain(e));
+            state->after = e->after;
+            return true;
+        }
+        bucket.push_back(state);
+        return false;
+    }
+
     std::vector<ParserStateInfo*>* evaluateState(ParserStateInfo* state) {
         LOG1("Analyzing " << state->state);
         auto valueMap = state->before->clone();
+        stats.copies++;
         for (auto s : state->state->components) {
             bool success = executeStatement(state, s, valueMap);
             if (!success)
@@ -307,9 +338,10 @@ class ParserSymbolicInterpreter {
 
  public:
     ParserSymbolicInterpreter(ParserStructure* structure, ReferenceMap* refMap,
-                              TypeMap* typeMap, bool unroll)
+                              TypeMap* typeMap, bool unroll, unsigned budget)
             : structure(structure), refMap(refMap), typeMap(typeMap),
-              synthesizedParser(nullptr), unroll(unroll) {
+              synthesizedParser(nullptr), unroll(unroll), budget(budget),
+              stats(structure->stats) {
         CHECK_NULL(structure); CHECK_NULL(refMap); CHECK_NULL(typeMap);
         factory = new SymbolicValueFactory(typeMap);
         parser = structure->parser;
@@ -326,13 +358,27 @@ class ParserSymbolicInterpreter {
         toRun.push_back(startInfo);
 
         while (!toRun.empty()) {
+            if (budget != 0 && stats.evaluated >= budget) {
+                stats.budgetExhausted = true;
+                ::warning("%1%: parser analysis stopped after evaluating %2% states",
+                          parser, budget);
+                break;
+            }
             auto stateInfo = toRun.back();
             toRun.pop_back();
             LOG1("Symbolic evaluation of " << stateChain(stateInfo));
             bool infLoop = checkLoops(stateInfo);
-            if (infLoop)
+            if (infLoop) {
                 // don't evaluate successors anymore
+                stats.loops++;
                 continue;
+            }
+            if (alreadyExplored(stateInfo)) {
+                // successors have already been scheduled
+                stats.memoized++;
+                continue;
+            }
+            stats.evaluated++;
             auto nextStates = evaluateState(stateInfo);
             if (nextStates == nullptr) {
                 LOG1("No next states");
@@ -346,9 +392,15 @@ class ParserSymbolicInterpreter {
 };
 }  // namespace ParserStructureImpl
 
-void ParserStructure::analyze(ReferenceMap* refMap, TypeMap* typeMap, bool unroll) {
-    ParserStructureImpl::ParserSymbolicInterpreter psi(this, refMap, typeMap, unroll);
+void ParserStructure::analyze(ReferenceMap* refMap, TypeMap* typeMap,
+                              bool unroll, unsigned budget) {
+    stats = ParserUnrollStatistics();
+    ParserStructureImpl::ParserSymbolicInterpreter psi(this, refMap, typeMap, unroll, budget);
     result = psi.run();
+    LOG1("Parser " << parser->externalName() << ": " << stats.evaluated << " states evaluated, "
+         << stats.memoized << " memoized, " << stats.loops << " cycles cut, "
+         << stats.copies << " value maps copied"
+         << (stats.budgetExhausted ? " (budget exhausted)" : ""));
 }
 
 }  // namespace P4
@@ -35,6 +35,9 @@ struct ParserStateInfo {
     const IR::ParserState* state;  // original state this is produced from
     const ParserStateInfo* predecessor;  // how we got here in the symbolic evaluation
     cstring                name;  // new state name
+    // 'before' and 'after' are immutable snapshots once the state
+    // has been evaluated; successors share the predecessor's 'after'
+    // map and copy it only when they start executing statements.
     ValueMap*              before;
     ValueMap*              after;
 
@@ -70,6 +73,15 @@ class ParserInfo {
 
 typedef CallGraph<const IR::ParserState*> StateCallGraph;
 
+// Counters collected by the symbolic evaluator for one parser
+struct ParserUnrollStatistics {
+    unsigned evaluated = 0;  // states symbolically executed
+    unsigned memoized = 0;   // states reached again with an already explored input
+    unsigned loops = 0;      // states not explored because of a cycle
+    unsigned copies = 0;     // value maps copied
+    bool     budgetExhausted = false;
+};
+
 // Information about a parser in the input program
 class ParserStructure {
     std::map<cstring, const IR::ParserState*> stateMap;
@@ -78,6 +90,7 @@ class ParserStructure {
     const IR::P4Parser*    parser;
     const IR::ParserState* start;
     const ParserInfo*      result;
+    ParserUnrollStatistics stats;
     void setParser(const IR::P4Parser* parser) {
         CHECK_NULL(parser);
         callGraph = new StateCallGraph(parser->name);
@@ -91,7 +104,8 @@ class ParserStructure {
     void calls(const IR::ParserState* caller, const IR::ParserState* callee)
     { callGraph->calls(caller, callee); }
 
-    void analyze(ReferenceMap* refMap, TypeMap* typeMap, bool unroll);
+    // At most 'budget' states are evaluated; 0 means no limit.
+    void analyze(ReferenceMap* refMap, TypeMap* typeMap, bool unroll, unsigned budget);
 };
 
 class AnalyzeParser : public Inspector {
@@ -127,12 +141,12 @@ class ParserUnroller : public Transform {
 class ParserRewriter : public PassManager {
     ParserStructure  current;
  public:
-    ParserRewriter(ReferenceMap* refMap, TypeMap* typeMap, bool unroll) {
+    ParserRewriter(ReferenceMap* refMap, TypeMap* typeMap, bool unroll, unsigned budget) {
         CHECK_NULL(refMap); CHECK_NULL(typeMap);
         passes.push_back(new AnalyzeParser(refMap, &current));
         passes.push_back(new VisitFunctor (
-            [this, refMap, typeMap, unroll](const IR::Node* root) -> const IR::Node* {
-                current.analyze(refMap, typeMap, unroll);
+            [this, refMap, typeMap, unroll, budget](const IR::Node* root) -> const IR::Node* {
+                current.analyze(refMap, typeMap, unroll, budget);
                 return root;
             }));
 #if 0
@@ -143,8 +157,8 @@ class ParserRewriter : public PassManager {
     Visitor::profile_t init_apply(const IR::Node* node) override {
         LOG1("Scanning " << node);
         BUG_CHECK(node->is<IR::P4Parser>(), "%1%: expected a parser", node);
-        current.parser = node->to<IR::P4Parser>();
-        return Visitor::init_apply(node);
+        current.setParser(node->to<IR::P4Parser>());
+        return PassManager::init_apply(node);
     }
 };
 
@@ -155,21 +169,25 @@ class RewriteAllParsers : public Transform {
     ReferenceMap* refMap;
     TypeMap*      typeMap;
     bool          unroll;
+    unsigned      budget;
  public:
-    RewriteAllParsers(ReferenceMap* refMap, TypeMap* typeMap, bool unroll) :
-            refMap(refMap), typeMap(typeMap), unroll(unroll)
+    RewriteAllParsers(ReferenceMap* refMap, TypeMap* typeMap, bool unroll, unsigned budget) :
+            refMap(refMap), typeMap(typeMap), unroll(unroll), budget(budget)
     { CHECK_NULL(refMap); CHECK_NULL(typeMap); }
     const IR::Node* postorder(IR::P4Parser* parser) override {
-        ParserRewriter rewriter(refMap, typeMap, unroll);
+        ParserRewriter rewriter(refMap, typeMap, unroll, budget);
         return parser->apply(rewriter);
     }
 };
 
+// 'budget' bounds the number of symbolic states explored per parser;
+// when it is exhausted the analysis stops with a warning.  0 means no limit.
 class ParsersUnroll : public PassManager {
  public:
-    ParsersUnroll(bool unroll, ReferenceMap* refMap, TypeMap* typeMap) {
+    ParsersUnroll(bool unroll, ReferenceMap* refMap, TypeMap* typeMap,
+                  unsigned budget = 10000) {
         passes.push_back(new TypeChecking(refMap, typeMap));
-        passes.push_back(new RewriteAllParsers(refMap, typeMap, unroll));
+        passes.push_back(new RewriteAllParsers(refMap, typeMap, unroll, budget));
         setName("ParsersUnroll");
     }
 };
@@ -15,9 +15,145 @@ limitations under the License.
 */
 
 #include "predication.h"
+#include "expr_uses.h"
+#include "has_side_effects.h"
 
 namespace P4 {
 
+namespace {
+
+unsigned countAssignments(const IR::Node* node) {
+    unsigned count = 0;
+    forAllMatching<IR::AssignmentStatement>(node, [&count](const IR::AssignmentStatement*) {
+        count++; });
+    return count;
+}
+
+// Collects the assignments in 'statement'; returns false if it
+// contains any other statement.
+bool getAssignments(const IR::Statement* statement,
+                    std::vector<const IR::AssignmentStatement*> &result) {
+    if (statement == nullptr || statement->is<IR::EmptyStatement>())
+        return true;
+    if (auto assign = statement->to<IR::AssignmentStatement>()) {
+        result.push_back(assign);
+        return true;
+    }
+    if (auto block = statement->to<IR::BlockStatement>()) {
+        for (auto c : block->components) {
+            auto stat = c->to<IR::Statement>();
+            if (stat == nullptr || !getAssignments(stat, result))
+                return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+cstring Predication::levelTemporary(std::vector<cstring> &names, unsigned level, cstring prefix) {
+    while (names.size() <= level) {
+        cstring name = generator->newName(prefix);
+        names.push_back(name);
+        temporaries.push_back(new IR::Declaration_Variable(name, IR::Type::Boolean::get()));
+    }
+    return names[level];
+}
+
+const IR::Statement* Predication::mergeBranches(const IR::IfStatement* statement) {
+    std::vector<const IR::AssignmentStatement*> thenAssign, elseAssign;
+    if (!getAssignments(statement->ifTrue, thenAssign) ||
+        !getAssignments(statement->ifFalse, elseAssign))
+        return nullptr;
+
+    std::vector<const IR::AssignmentStatement*> all(thenAssign);
+    all.insert(all.end(), elseAssign.begin(), elseAssign.end());
+    std::vector<cstring> written;
+    for (auto a : all) {
+        if (hasSideEffects(a->left) || hasSideEffects(a->right))
+            return nullptr;
+        auto left = a->left;
+        while (auto slice = left->to<IR::Slice>())
+            left = slice->e0;
+        written.push_back(left->toString());
+    }
+
+    // The "else" assignment writing the same destination as each "then" assignment
+    std::map<const IR::AssignmentStatement*, const IR::AssignmentStatement*> paired;
+    std::set<const IR::AssignmentStatement*> pairedElse;
+    for (size_t i = 0; i < all.size(); i++) {
+        bool iThen = i < thenAssign.size();
+        for (size_t j = 0; j < all.size(); j++) {
+            if (exprUses(all[i]->right, written[j]))
+                return nullptr;
+            if (i == j)
+                continue;
+            bool jThen = j < thenAssign.size();
+            if (iThen && !jThen && all[i]->left->equiv(*all[j]->left)) {
+                if (paired.count(all[i]) || pairedElse.count(all[j]))
+                    return nullptr;
+                paired.emplace(all[i], all[j]);
+                pairedElse.insert(all[j]);
+                continue;
+            }
+            if (!iThen && jThen && all[i]->left->equiv(*all[j]->left))
+                continue;
+            if (exprUses(all[i]->left, written[j]))
+                return nullptr;
+        }
+    }
+
+    unsigned muxes = 0;
+    for (auto a : thenAssign) {
+        auto it = paired.find(a);
+        if (it == paired.end() || !a->right->equiv(*it->second->right))
+            muxes++;
+    }
+    muxes += elseAssign.size() - pairedElse.size();
+
+    const IR::Expression* condition = statement->condition;
+    bool readsWritten = false;
+    for (auto w : written)
+        readsWritten = readsWritten || exprUses(condition, w);
+    bool isLeaf = condition->is<IR::PathExpression>() || condition->is<IR::Member>() ||
+            condition->is<IR::BoolLiteral>();
+    // The assignments are emitted in order, so an assignment may change
+    // the condition before a later one evaluates it.
+    unsigned assignments = all.size() - pairedElse.size();
+    bool changed = readsWritten && muxes > 0 && assignments > 1;
+    auto rv = new IR::BlockStatement(statement->srcInfo);
+    if (hasSideEffects(condition) || changed || (muxes > 1 && !isLeaf)) {
+        cstring conditionName = levelTemporary(conditions, ifNestingLevel, "cond");
+        rv->push_back(new IR::AssignmentStatement(
+            new IR::PathExpression(IR::ID(conditionName)), condition));
+        condition = new IR::PathExpression(IR::ID(conditionName));
+    }
+
+    const IR::Expression* previousPredicate = predicate();  // This may be nullptr
+    auto assign = [&](const IR::AssignmentStatement* original, const IR::Expression* value) {
+        if (previousPredicate != nullptr)
+            value = new IR::Mux(previousPredicate->clone(), value, original->left);
+        rv->push_back(new IR::AssignmentStatement(original->srcInfo, original->left, value));
+    };
+    for (auto a : thenAssign) {
+        auto it = paired.find(a);
+        if (it == paired.end())
+            assign(a, new IR::Mux(condition->clone(), a->right, a->left));
+        else if (a->right->equiv(*it->second->right))
+            assign(a, a->right);
+        else
+            assign(a, new IR::Mux(condition->clone(), a->right, it->second->right));
+    }
+    for (auto a : elseAssign) {
+        if (pairedElse.count(a))
+            continue;
+        assign(a, new IR::Mux(condition->clone(), a->left, a->right));
+    }
+    LOG3("Merged branches of " << statement << " into " << muxes << " conditional assignments");
+    return rv;
+}
+
 const IR::Node* Predication::postorder(IR::AssignmentStatement* statement) {
     if (!inside_action || ifNestingLevel == 0)
         return statement;
@@ -30,22 +166,42 @@ const IR::Node* Predication::preorder(IR::IfStatement* statement) {
     if (!inside_action)
         return statement;
 
+    if (optimized) {
+        if (auto merged = mergeBranches(statement)) {
+            prune();
+            return merged;
+        }
+    }
+
     ++ifNestingLevel;
     auto rv = new IR::BlockStatement;
-    cstring conditionName = generator->newName("cond");
-    auto condDecl = new IR::Declaration_Variable(conditionName, IR::Type::Boolean::get());
-    rv->push_back(condDecl);
+    cstring conditionName;
+    if (optimized) {
+        conditionName = levelTemporary(conditions, ifNestingLevel - 1, "cond");
+    } else {
+        conditionName = generator->newName("cond");
+        auto condDecl = new IR::Declaration_Variable(conditionName, IR::Type::Boolean::get());
+        rv->push_back(condDecl);
+    }
     auto condition = new IR::PathExpression(IR::ID(conditionName));
 
     // A vector for a new BlockStatement.
     auto block = new IR::BlockStatement;
 
     const IR::Expression* previousPredicate = predicate();  // This may be nullptr
-    // a new name for the new predicate
-    cstring newPredName = generator->newName("pred");
-    predicateName.push_back(newPredName);
-    auto decl = new IR::Declaration_Variable(newPredName, IR::Type::Boolean::get());
-    block->push_back(decl);
+    // The condition of an outermost if is its own predicate
+    bool conditionIsPredicate = optimized && previousPredicate == nullptr;
+    if (conditionIsPredicate) {
+        predicateName.push_back(conditionName);
+    } else if (optimized) {
+        predicateName.push_back(levelTemporary(predicates, ifNestingLevel - 1, "pred"));
+    } else {
+        // a new name for the new predicate
+        cstring newPredName = generator->newName("pred");
+        predicateName.push_back(newPredName);
+        auto decl = new IR::Declaration_Variable(newPredName, IR::Type::Boolean::get());
+        block->push_back(decl);
+    }
     // This evaluates the if condition.
     // We are careful not to evaluate any conditional more times
     // than in the original program, since the evaluation may have side-effects.
@@ -58,8 +214,10 @@ const IR::Node* Predication::preorder(IR::IfStatement* statement) {
     } else {
         pred = new IR::LAnd(previousPredicate, condition->clone());
     }
-    auto truePred = new IR::AssignmentStatement(predicate(), pred);
-    block->push_back(truePred);
+    if (!conditionIsPredicate) {
+        auto truePred = new IR::AssignmentStatement(predicate(), pred);
+        block->push_back(truePred);
+    }
 
     visit(statement->ifTrue);
     block->push_back(statement->ifTrue);
@@ -73,8 +231,10 @@ const IR::Node* Predication::preorder(IR::IfStatement* statement) {
         } else {
             pred = new IR::LAnd(previousPredicate->clone(), condition->clone());
         }
-        auto falsePred = new IR::AssignmentStatement(predicate(), pred);
-        block->push_back(falsePred);
+        if (!conditionIsPredicate) {
+            auto falsePred = new IR::AssignmentStatement(predicate(), pred);
+            block->push_back(falsePred);
+        }
 
         visit(statement->ifFalse);
         block->push_back(statement->ifFalse);
@@ -89,11 +249,23 @@ const IR::Node* Predication::preorder(IR::IfStatement* statement) {
 
 const IR::Node* Predication::preorder(IR::P4Action* action) {
     inside_action = true;
+    conditions.clear();
+    predicates.clear();
+    temporaries.clear();
+    assignmentsBefore = countAssignments(action->body);
     return action;
 }
 
 const IR::Node* Predication::postorder(IR::P4Action* action) {
     inside_action = false;
+    if (!temporaries.empty()) {
+        IR::IndexedVector<IR::StatOrDecl> body(temporaries);
+        body.append(action->body->components);
+        action->body = new IR::BlockStatement(
+            action->body->srcInfo, action->body->annotations, body);
+    }
+    LOG1("Predication of " << action->name << ": " << assignmentsBefore << " assignments before, "
+         << countAssignments(action->body) << " after");
     return action;
 }
 
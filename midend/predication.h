@@ -57,12 +57,34 @@ This could be made better by looking on both the "then" and "else"
 branches, but in this way we cannot have two side-effects in the same
 conditional statement.
 
+When 'optimized' is set the conversion generates fewer assignments:
+- if both branches are side-effect-free assignments which do not read
+  any location written by the branches, each destination is written
+  exactly once, merging the "then" and "else" values:
+    a = e ? f(b) : f(d);
+  and a destination assigned the same value in both branches is
+  assigned unconditionally.  The condition is evaluated into a
+  temporary only when it is needed more than once, or when one of
+  the assignments writes a location it reads.
+- otherwise the condition of an outermost 'if' is used directly as
+  its predicate, and the condition and predicate temporaries are
+  declared once per nesting level and reused by all ifs in an action.
+
 */
 class Predication final : public Transform {
     NameGenerator* generator;
     bool inside_action;
     std::vector<cstring> predicateName;
     unsigned ifNestingLevel;
+    bool optimized;
+    // Temporaries for each nesting level, reused when optimized
+    std::vector<cstring> conditions;
+    std::vector<cstring> predicates;
+    IR::IndexedVector<IR::StatOrDecl> temporaries;
+    unsigned assignmentsBefore = 0;
+
+    cstring levelTemporary(std::vector<cstring> &names, unsigned level, cstring prefix);
+    const IR::Statement* mergeBranches(const IR::IfStatement* statement);
 
     const IR::Expression* predicate() const {
         if (predicateName.empty())
@@ -76,8 +98,8 @@ class Predication final : public Transform {
     }
 
  public:
-    explicit Predication(NameGenerator* generator) : generator(generator),
-            inside_action(false), ifNestingLevel(0)
+    explicit Predication(NameGenerator* generator, bool optimized = false) :
+            generator(generator), inside_action(false), ifNestingLevel(0), optimized(optimized)
     { CHECK_NULL(generator); setName("Predication"); }
 
     const IR::Node* preorder(IR::IfStatement* statement) override;
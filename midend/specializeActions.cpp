@@ -0,0 +1,233 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "specializeActions.h"
+#include "frontends/common/constantFolding.h"
+#include "frontends/p4/cloner.h"
+#include "frontends/p4/methodInstance.h"
+#include "frontends/p4/parameterSubstitution.h"
+#include "frontends/p4/strengthReduction.h"
+
+namespace P4 {
+
+namespace {
+
+/// Clones an action body, replacing the parameters with their values.
+class SubstituteParameters : public ClonePathExpressions {
+    const ReferenceMap* refMap;
+    const std::map<const IR::Parameter*, const IR::Expression*>& values;
+
+ public:
+    SubstituteParameters(const ReferenceMap* refMap,
+                         const std::map<const IR::Parameter*, const IR::Expression*>& values) :
+            refMap(refMap), values(values) { setName("SubstituteParameters"); }
+    const IR::Node* postorder(IR::PathExpression* path) override {
+        auto decl = refMap->getDeclaration(path->path, true);
+        if (auto param = decl->to<IR::Parameter>()) {
+            auto it = values.find(param);
+            if (it != values.end())
+                return it->second->clone();
+        }
+        return ClonePathExpressions::postorder(path);
+    }
+    const IR::Node* postorder(IR::Declaration_Variable* decl) override {
+        return new IR::Declaration_Variable(decl->srcInfo, decl->name,
+                                            decl->annotations, decl->type, decl->initializer);
+    }
+};
+
+}  // namespace
+
+const IR::Node* DoSpecializeConstantActions::preorder(IR::P4Control* control) {
+    switched.clear();
+    specializations.clear();
+    specialized.clear();
+    forAllMatching<IR::SwitchStatement>(control->body, [this](const IR::SwitchStatement* sw) {
+        auto member = sw->expression->to<IR::Member>();
+        if (member == nullptr || !member->expr->is<IR::MethodCallExpression>())
+            return;
+        auto mi = MethodInstance::resolve(member->expr->to<IR::MethodCallExpression>(),
+                                          refMap, typeMap);
+        if (auto am = mi->to<ApplyMethod>()) {
+            if (am->isTableApply())
+                switched.emplace(am->object->to<IR::P4Table>());
+        }
+    });
+    return control;
+}
+
+const IR::Node* DoSpecializeConstantActions::postorder(IR::P4Control* control) {
+    if (specializations.empty())
+        return control;
+    // Specialized actions are declared after the original action
+    IR::IndexedVector<IR::Declaration> locals;
+    for (auto d : control->controlLocals) {
+        locals.push_back(d);
+        if (auto action = d->to<IR::P4Action>()) {
+            auto it = specializations.find(action);
+            if (it == specializations.end())
+                continue;
+            for (auto s : it->second)
+                locals.push_back(s);
+        }
+    }
+    control->controlLocals = locals;
+    return control;
+}
+
+const IR::Expression* DoSpecializeConstantActions::specialize(const IR::Expression* call) {
+    auto mce = call->to<IR::MethodCallExpression>();
+    if (mce == nullptr)
+        return nullptr;
+    auto mi = MethodInstance::resolve(mce, refMap, typeMap);
+    auto ac = mi->to<ActionCall>();
+    if (ac == nullptr || ac->action->parameters->empty())
+        return nullptr;
+    auto action = ac->action;
+    // Specializations are declared next to the action
+    auto control = findOrigCtxt<IR::P4Control>();
+    if (control->controlLocals.getDeclaration(action->name) != action)
+        return nullptr;
+
+    ParameterSubstitution substitution;
+    substitution.populate(action->parameters, mce->arguments);
+    std::set<const IR::IDeclaration*> used;
+    forAllMatching<IR::PathExpression>(action->body, [&](const IR::PathExpression* path) {
+        used.emplace(refMap->getDeclaration(path->path, true)); });
+
+    std::map<const IR::Parameter*, const IR::Expression*> values;
+    std::string key = action->name.name.c_str();
+    for (auto p : action->parameters->parameters) {
+        if (p->direction != IR::Direction::None)
+            return nullptr;
+        auto arg = substitution.lookup(p);
+        if (arg == nullptr)
+            return nullptr;
+        auto value = arg->expression;
+        if (!value->is<IR::Constant>() && !value->is<IR::BoolLiteral>())
+            return nullptr;
+        if (!used.count(p))
+            continue;
+        values.emplace(p, value);
+        key += " ";
+        key += p->name.name.c_str();
+        key += "=";
+        key += value->toString().c_str();
+    }
+    if (values.empty())
+        return nullptr;
+
+    cstring name = ::get(specialized, cstring(key));
+    if (name.isNull()) {
+        name = refMap->newName(action->name);
+        LOG1("Specializing " << dbp(call) << " as " << name);
+        SubstituteParameters substitute(refMap, values);
+        auto body = substitute.clone<IR::BlockStatement>(action->body);
+        auto annos = new IR::Annotations();
+        annos->add(new IR::Annotation(IR::Annotation::hiddenAnnotation, {}));
+        auto replacement = new IR::P4Action(action->srcInfo, IR::ID(action->name.srcInfo, name),
+                                            annos, new IR::ParameterList(), body);
+        specializations[action].push_back(replacement);
+        specialized.emplace(cstring(key), name);
+    }
+    return new IR::MethodCallExpression(
+        mce->srcInfo, new IR::PathExpression(IR::ID(mce->method->srcInfo, name)),
+        new IR::Vector<IR::Type>(), new IR::Vector<IR::Argument>());
+}
+
+const IR::Node* DoSpecializeConstantActions::preorder(IR::P4Table* table) {
+    prune();
+    // The entries and the default action of the other tables are
+    // described in P4Info, which names the original actions
+    if (table->getAnnotation(IR::Annotation::hiddenAnnotation) == nullptr)
+        return table;
+    if (switched.count(getOriginal<IR::P4Table>()))
+        return table;
+    auto actionList = table->getActionList();
+    if (actionList == nullptr)
+        return table;
+
+    // Names of the specialized actions used by the table
+    std::vector<IR::ID> used;
+    auto record = [&used](const IR::Expression* call) {
+        auto name = call->to<IR::MethodCallExpression>()->method->to<IR::PathExpression>()
+                ->path->name;
+        if (std::find(used.begin(), used.end(), name) == used.end())
+            used.push_back(name);
+    };
+
+    auto properties = new IR::TableProperties();
+    for (auto prop : table->properties->properties) {
+        if (prop->isConstant && prop->name == IR::TableProperties::entriesPropertyName &&
+            prop->value->is<IR::EntriesList>()) {
+            auto list = prop->value->to<IR::EntriesList>();
+            IR::Vector<IR::Entry> entries;
+            bool changed = false;
+            for (auto e : list->entries) {
+                if (auto action = specialize(e->action)) {
+                    record(action);
+                    entries.push_back(new IR::Entry(e->srcInfo, e->annotations, e->keys, action));
+                    changed = true;
+                } else {
+                    entries.push_back(e);
+                }
+            }
+            if (changed)
+                prop = new IR::Property(prop->srcInfo, prop->name, prop->annotations,
+                                        new IR::EntriesList(list->srcInfo, entries),
+                                        prop->isConstant);
+        } else if (prop->isConstant &&
+                   prop->name == IR::TableProperties::defaultActionPropertyName &&
+                   prop->value->is<IR::ExpressionValue>()) {
+            if (auto action = specialize(prop->value->to<IR::ExpressionValue>()->expression)) {
+                record(action);
+                prop = new IR::Property(prop->srcInfo, prop->name, prop->annotations,
+                                        new IR::ExpressionValue(action), prop->isConstant);
+            }
+        }
+        properties->push_back(prop);
+    }
+    if (used.empty())
+        return table;
+
+    auto actions = new IR::ActionList(actionList->actionList);
+    // The names carry the position of a call, which follows the
+    // declaration of the action, so that they can be resolved.
+    for (auto name : used)
+        actions->push_back(new IR::ActionListElement(
+            name.srcInfo, new IR::MethodCallExpression(
+                name.srcInfo, new IR::PathExpression(name),
+                new IR::Vector<IR::Type>(), new IR::Vector<IR::Argument>())));
+    auto result = new IR::TableProperties();
+    for (auto prop : properties->properties) {
+        if (prop->name == IR::TableProperties::actionsPropertyName)
+            prop = new IR::Property(prop->srcInfo, prop->name, prop->annotations,
+                                    actions, prop->isConstant);
+        result->push_back(prop);
+    }
+    table->properties = result;
+    return table;
+}
+
+SpecializeConstantActions::SpecializeConstantActions(ReferenceMap* refMap, TypeMap* typeMap) {
+    passes.push_back(new TypeChecking(refMap, typeMap));
+    passes.push_back(new DoSpecializeConstantActions(refMap, typeMap));
+    passes.push_back(new ConstantFolding(refMap, typeMap));
+    passes.push_back(new StrengthReduction());
+    setName("SpecializeConstantActions");
+}
+
+}  // namespace P4
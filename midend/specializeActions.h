@@ -0,0 +1,90 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef _MIDEND_SPECIALIZEACTIONS_H_
+#define _MIDEND_SPECIALIZEACTIONS_H_
+
+#include "ir/ir.h"
+#include "frontends/common/resolveReferences/referenceMap.h"
+#include "frontends/p4/typeChecking/typeChecker.h"
+
+namespace P4 {
+
+/**
+Specializes the actions invoked with constant arguments by the const
+entries or by the const default action of a @hidden table.
+
+control c(inout bit<32> x) {
+   action a(bit<32> arg) { x = x + arg; }
+   @hidden table tbl_a() {
+      actions = { a; }
+      const default_action = a(1); }
+   apply { tbl_a.apply(); } }
+
+is converted to
+
+control c(inout bit<32> x) {
+   action a(bit<32> arg) { x = x + arg; }
+   @hidden action a_0() { x = x + 1; }
+   @hidden table tbl_a() {
+      actions = { a; a_0; }
+      const default_action = a_0(); }
+   apply { tbl_a.apply(); } }
+
+Entries with the same values for the parameters the action reads share
+a specialization.  Only @hidden tables are changed: the entries and the
+default action of the other tables are visible to the control-plane, and
+P4Info describes them with the original actions.  (The tables synthesized
+by MoveActionsToTables call actions whose parameters have already been
+removed by RemoveActionParameters.)  The original action is kept.  Tables
+whose action_run is used by a switch statement are not changed.
+
+@pre Must run after RemoveActionParameters: actions only have
+directionless parameters.
+*/
+class DoSpecializeConstantActions : public Transform {
+    ReferenceMap* refMap;
+    TypeMap*      typeMap;
+    // Tables whose action_run is used in a switch statement
+    std::set<const IR::P4Table*> switched;
+    // Specializations of each action of the current control
+    std::map<const IR::P4Action*, std::vector<const IR::P4Action*>> specializations;
+    // Specialized action name, indexed by action and argument values
+    std::map<cstring, cstring> specialized;
+
+    const IR::Expression* specialize(const IR::Expression* call);
+
+ public:
+    DoSpecializeConstantActions(ReferenceMap* refMap, TypeMap* typeMap) :
+            refMap(refMap), typeMap(typeMap)
+    { CHECK_NULL(refMap); CHECK_NULL(typeMap); setName("DoSpecializeConstantActions"); }
+    const IR::Node* preorder(IR::P4Parser* parser) override
+    { prune(); return parser; }
+    const IR::Node* preorder(IR::P4Control* control) override;
+    const IR::Node* postorder(IR::P4Control* control) override;
+    const IR::Node* preorder(IR::P4Action* action) override
+    { prune(); return action; }
+    const IR::Node* preorder(IR::P4Table* table) override;
+};
+
+class SpecializeConstantActions : public PassManager {
+ public:
+    SpecializeConstantActions(ReferenceMap* refMap, TypeMap* typeMap);
+};
+
+}  // namespace P4
+
+#endif /* _MIDEND_SPECIALIZEACTIONS_H_ */
@@ -0,0 +1,143 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <chrono>
+#include <sstream>
+#include <boost/algorithm/string/replace.hpp>
+#include <boost/optional.hpp>
+
+#include "gtest/gtest.h"
+#include "ir/ir.h"
+#include "helpers.h"
+#include "lib/log.h"
+
+#include "backends/bmv2/common/controlFlowGraph.h"
+#include "frontends/common/resolveReferences/referenceMap.h"
+#include "frontends/p4/typeChecking/typeChecker.h"
+#include "frontends/p4/typeMap.h"
+
+using namespace P4;
+
+namespace Test {
+
+namespace {
+
+// A pipeline with 4 * 'groups' tables; each group applies a table,
+// a table in both branches of a hit/miss conditional, and a table
+// in a switch statement.
+boost::optional<FrontendTestCase> createPipeline(unsigned groups) {
+    std::string source = P4_SOURCE(P4Headers::V1MODEL, R"(
+header H { bit<32> f1; bit<32> f2; bit<32> f3; }
+struct Headers { H h; }
+struct Metadata { }
+
+parser parse(packet_in packet, out Headers headers, inout Metadata meta,
+             inout standard_metadata_t sm) {
+    state start { packet.extract(headers.h); transition accept; }
+}
+
+control verifyChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control ingress(inout Headers headers, inout Metadata meta,
+                inout standard_metadata_t sm) {
+    action set(bit<32> v) { headers.h.f2 = v; }
+%TABLES%
+    apply {
+%APPLY%
+    }
+}
+control egress(inout Headers headers, inout Metadata meta,
+               inout standard_metadata_t sm) { apply { } }
+control computeChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control deparse(packet_out packet, in Headers headers) {
+    apply { packet.emit(headers.h); }
+}
+
+V1Switch(parse(), verifyChecksum(), ingress(), egress(),
+         computeChecksum(), deparse()) main;
+    )");
+
+    std::stringstream tables, apply;
+    for (unsigned t = 0; t < 4 * groups; t++)
+        tables << "    table t" << t << " { key = { headers.h.f1 : exact; } "
+               << "actions = { set; NoAction; } default_action = NoAction(); }" << std::endl;
+    for (unsigned g = 0; g < groups; g++) {
+        unsigned t = 4 * g;
+        apply << "        t" << t << ".apply();" << std::endl
+              << "        if (t" << t + 1 << ".apply().hit) { t" << t + 2 << ".apply(); }"
+              << " else { t" << t + 2 << ".apply(); }" << std::endl
+              << "        switch (t" << t + 3 << ".apply().action_run) {" << std::endl
+              << "            set: { if (headers.h.f3 == " << g << ") { headers.h.f1 = 0; } }"
+              << std::endl
+              << "            default: { }" << std::endl
+              << "        }" << std::endl;
+    }
+    boost::replace_first(source, "%TABLES%", tables.str());
+    boost::replace_first(source, "%APPLY%", apply.str());
+    return FrontendTestCase::create(source, CompilerOptions::FrontendVersion::P4_16);
+}
+
+}  // namespace
+
+class BMV2CFG : public P4CTest { };
+
+TEST_F(BMV2CFG, LargePipeline) {
+    const unsigned groups = 500;
+    auto test = createPipeline(groups);
+    ASSERT_TRUE(test);
+
+    ReferenceMap refMap;
+    TypeMap typeMap;
+    auto program = test->program->apply(TypeChecking(&refMap, &typeMap, true));
+    ASSERT_TRUE(program != nullptr);
+    const IR::P4Control* ingress = nullptr;
+    for (auto obj : program->declarations)
+        if (auto control = obj->to<IR::P4Control>())
+            if (control->name == "ingress")
+                ingress = control;
+    ASSERT_TRUE(ingress != nullptr);
+
+    auto start = std::chrono::steady_clock::now();
+    BMV2::CFG cfg("ingress");
+    cfg.build(ingress, &refMap, &typeMap);
+    EXPECT_TRUE(cfg.checkImplementable());
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    LOG1("CFG of " << 4 * groups << " tables built in " << elapsed.count() << "ms");
+    EXPECT_EQ(0u, ::errorCount());
+
+    // entry, exit, 5 table nodes (t2 appears twice, always followed
+    // by t3) and 1 conditional per group
+    ASSERT_EQ(2 + 6 * groups, cfg.allNodes.size());
+    std::set<const IR::P4Table*> tables;
+    unsigned conditionals = 0;
+    for (unsigned i = 0; i < cfg.allNodes.size(); i++) {
+        auto node = cfg.allNodes.at(i);
+        EXPECT_EQ(i, node->id);
+        if (auto tn = node->to<BMV2::CFG::TableNode>())
+            tables.emplace(tn->table);
+        if (node->is<BMV2::CFG::IfNode>()) {
+            EXPECT_TRUE(node->name.startsWith("ingress.node_"));
+            EXPECT_EQ(2u, node->successors.size());
+            conditionals++;
+        }
+    }
+    EXPECT_EQ(4 * groups, tables.size());
+    EXPECT_EQ(groups, conditionals);
+    ASSERT_EQ(1u, cfg.entryPoint->successors.size());
+    EXPECT_TRUE(cfg.entryPoint->successors.front()->endpoint->is<BMV2::CFG::TableNode>());
+}
+
+}  // namespace Test
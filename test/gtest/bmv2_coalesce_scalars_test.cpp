@@ -0,0 +1,175 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <boost/optional.hpp>
+
+#include "gtest/gtest.h"
+#include "ir/ir.h"
+#include "helpers.h"
+
+#include "backends/bmv2/common/coalesceScalars.h"
+#include "frontends/p4/typeChecking/typeChecker.h"
+
+using namespace P4;
+
+namespace Test {
+
+namespace {
+
+class Coalesced {
+    std::map<cstring, const IR::Declaration_Variable*> byName;
+
+ public:
+    BMV2::ProgramStructure structure;
+
+    explicit Coalesced(const IR::P4Program* program) {
+        ReferenceMap refMap;
+        TypeMap typeMap;
+        program = program->apply(TypeChecking(&refMap, &typeMap));
+        program->apply(BMV2::CoalesceScalars(&refMap, &typeMap, &structure));
+        forAllMatching<IR::Declaration_Variable>(program,
+                [this](const IR::Declaration_Variable* decl) {
+            byName.emplace(decl->name.name, decl); });
+    }
+
+    /// The field of the variable originally named 'name'
+    cstring field(cstring name) const {
+        for (auto it : byName) {
+            if (it.first != name && !it.first.startsWith(name + "_"))
+                continue;
+            auto f = structure.scalarVariableFields.find(it.second);
+            return f == structure.scalarVariableFields.end() ? cstring() : f->second;
+        }
+        return cstring();
+    }
+
+    /// Width of the scalars holding the variables, without and with sharing
+    std::pair<unsigned, unsigned> widths() const {
+        unsigned before = 0, after = 0;
+        std::set<cstring> fields;
+        for (auto v : structure.scalarVariableFields) {
+            auto type = v.first->type->to<IR::Type_Bits>();
+            EXPECT_TRUE(type != nullptr);
+            before += type->size;
+            if (fields.insert(v.second).second)
+                after += type->size;
+        }
+        return std::make_pair(before, after);
+    }
+};
+
+}  // namespace
+
+class BMV2CoalesceScalars : public P4CTest { };
+
+TEST_F(BMV2CoalesceScalars, Lifetimes) {
+    auto test = FrontendTestCase::create(P4_SOURCE(P4Headers::V1MODEL, R"(
+header H { bit<8> a; bit<8> b; bit<8> c; bit<8> d; }
+struct Headers { H h; }
+struct Metadata { }
+
+parser parse(packet_in packet, out Headers headers, inout Metadata meta,
+             inout standard_metadata_t sm) {
+    state start { packet.extract(headers.h); transition accept; }
+}
+
+control verifyChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control ingress(inout Headers headers, inout Metadata meta,
+                inout standard_metadata_t sm) {
+    action disjoint() {
+        bit<8> x; bit<8> y;
+        x = headers.h.a; headers.h.b = x;
+        y = headers.h.c; headers.h.d = y;
+    }
+    action overlapping() {
+        bit<8> u; bit<8> v;
+        u = headers.h.a; v = headers.h.b;
+        headers.h.c = u + v;
+    }
+    action readFirst() {
+        bit<8> r;
+        headers.h.a = r;
+        r = headers.h.b;
+        headers.h.c = r;
+    }
+    action inList() {
+        bit<8> l;
+        l = headers.h.a;
+        digest(32w1, { l });
+    }
+    table t {
+        key = { headers.h.a : exact; }
+        actions = { disjoint; overlapping; readFirst; inList; }
+        default_action = disjoint;
+    }
+    apply {
+        bit<8> g;
+        g = headers.h.d;
+        headers.h.a = g;
+        t.apply();
+    }
+}
+control egress(inout Headers headers, inout Metadata meta,
+               inout standard_metadata_t sm) {
+    apply {
+        bit<8> e;
+        e = headers.h.a;
+        headers.h.b = e;
+    }
+}
+control computeChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control deparse(packet_out packet, in Headers headers) {
+    apply { packet.emit(headers.h); }
+}
+
+V1Switch(parse(), verifyChecksum(), ingress(), egress(),
+         computeChecksum(), deparse()) main;
+    )"), CompilerOptions::FrontendVersion::P4_16);
+    ASSERT_TRUE(test);
+    Coalesced result(test->program);
+    ASSERT_EQ(0u, ::errorCount());
+    ASSERT_EQ(8u, result.structure.scalarVariableFields.size());
+
+    // May share: disjoint lifetimes in an action, variables of different
+    // actions, and variables of different controls
+    EXPECT_EQ(result.field("x"), result.field("y"));
+    EXPECT_EQ(result.field("x"), result.field("u"));
+    EXPECT_EQ(result.field("x"), result.field("e"));
+
+    // Must not share: overlapping lifetimes in an action, an action
+    // variable and a variable of the control which invokes the action
+    EXPECT_NE(result.field("u"), result.field("v"));
+    EXPECT_NE(result.field("x"), result.field("g"));
+    EXPECT_NE(result.field("v"), result.field("g"));
+
+    // Must not share: read before written (bmv2 initializes it to 0)
+    // and used in a list
+    std::set<cstring> others;
+    for (auto n : { "x", "v", "g", "l" })
+        others.insert(result.field(n));
+    EXPECT_EQ(0u, others.count(result.field("r")));
+    others.clear();
+    for (auto n : { "x", "v", "g", "r" })
+        others.insert(result.field(n));
+    EXPECT_EQ(0u, others.count(result.field("l")));
+
+    // 8 variables in 5 fields
+    auto widths = result.widths();
+    EXPECT_EQ(64u, widths.first);
+    EXPECT_EQ(40u, widths.second);
+}
+
+}  // namespace Test
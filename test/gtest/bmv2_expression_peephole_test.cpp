@@ -0,0 +1,167 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "gtest/gtest.h"
+#include "helpers.h"
+#include "lib/json.h"
+
+#include "backends/bmv2/common/expressionPeephole.h"
+
+using namespace BMV2;
+
+namespace Test {
+
+namespace {
+
+Util::JsonObject* field(cstring name) {
+    auto result = new Util::JsonObject();
+    result->emplace("type", "field");
+    auto value = new Util::JsonArray();
+    value->append("scalars");
+    value->append(name);
+    result->emplace("value", value);
+    return result;
+}
+
+Util::JsonObject* hexstr(cstring value) {
+    auto result = new Util::JsonObject();
+    result->emplace("type", "hexstr");
+    result->emplace("value", value);
+    return result;
+}
+
+Util::JsonObject* wrap(Util::IJson* value) {
+    auto result = new Util::JsonObject();
+    result->emplace("type", "expression");
+    result->emplace("value", value);
+    return result;
+}
+
+Util::JsonObject* op(cstring name, Util::IJson* left, Util::IJson* right) {
+    auto e = new Util::JsonObject();
+    e->emplace("op", name);
+    e->emplace("left", left == nullptr ? Util::JsonValue::null : left);
+    e->emplace("right", right);
+    return wrap(e);
+}
+
+cstring typeOf(const Util::IJson* json) {
+    return json->to<Util::JsonObject>()->get("type")->to<Util::JsonValue>()->getString();
+}
+
+// The operation of an expression node, or nullptr
+const Util::JsonObject* operation(const Util::IJson* json) {
+    if (typeOf(json) != "expression")
+        return nullptr;
+    auto value = json->to<Util::JsonObject>()->get("value")->to<Util::JsonObject>();
+    return value->get("op") == nullptr ? nullptr : value;
+}
+
+cstring opOf(const Util::IJson* json) {
+    auto e = operation(json);
+    return e == nullptr ? cstring() : e->get("op")->to<Util::JsonValue>()->getString();
+}
+
+mpz_class valueOf(const Util::IJson* json) {
+    EXPECT_EQ("hexstr", typeOf(json));
+    std::string s = json->to<Util::JsonObject>()->get("value")
+            ->to<Util::JsonValue>()->getString().c_str();
+    return mpz_class(s.substr(2), 16);
+}
+
+}  // namespace
+
+class BMV2ExpressionPeephole : public P4CTest { };
+
+TEST_F(BMV2ExpressionPeephole, Casts) {
+    ExpressionPeephole peephole;
+    auto f = field("f");
+    auto g = field("g");
+    ExpressionPeephole::LeafWidths widths = { { f, 1 }, { g, 8 } };
+
+    // d2b(b2d(e)) is e
+    EXPECT_EQ(f, peephole.optimize(op("d2b", nullptr, op("b2d", nullptr, f)), widths));
+    // b2d(d2b(e)) is e only if e is 0 or 1
+    EXPECT_EQ(f, peephole.optimize(op("b2d", nullptr, op("d2b", nullptr, f)), widths));
+    auto wide = peephole.optimize(op("b2d", nullptr, op("d2b", nullptr, g)), widths);
+    EXPECT_EQ("b2d", opOf(wide));
+    auto unknown = peephole.optimize(op("b2d", nullptr, op("d2b", nullptr, field("h"))),
+                                     widths);
+    EXPECT_EQ("b2d", opOf(unknown));
+    EXPECT_EQ(4u, peephole.getStats().casts);
+}
+
+TEST_F(BMV2ExpressionPeephole, Masks) {
+    ExpressionPeephole peephole;
+    auto f = field("f");
+    auto g = field("g");
+    auto s = field("s");  // signed: no width
+    ExpressionPeephole::LeafWidths widths = { { f, 8 }, { g, 16 } };
+
+    // f fits in the mask, on either side
+    EXPECT_EQ(f, peephole.optimize(op("&", f, hexstr("0xff")), widths));
+    EXPECT_EQ(f, peephole.optimize(op("&", hexstr("0x0fff"), f), widths));
+    // g is wider than the mask; 0xfe is not 2^k-1
+    EXPECT_EQ("&", opOf(peephole.optimize(op("&", g, hexstr("0xff")), widths)));
+    EXPECT_EQ("&", opOf(peephole.optimize(op("&", f, hexstr("0xfe")), widths)));
+    // the width of signed leaves is unknown
+    EXPECT_EQ("&", opOf(peephole.optimize(op("&", s, hexstr("0xff")), widths)));
+    // + and - may carry or borrow out of the width of their operands
+    EXPECT_EQ("&", opOf(peephole.optimize(op("&", op("+", f, f), hexstr("0xff")), widths)));
+    EXPECT_EQ("&", opOf(peephole.optimize(op("&", op("-", f, f), hexstr("0xff")), widths)));
+    // | and ^ do not
+    EXPECT_EQ("|", opOf(peephole.optimize(op("&", op("|", f, f), hexstr("0xff")), widths)));
+    EXPECT_EQ(3u, peephole.getStats().masks);
+}
+
+TEST_F(BMV2ExpressionPeephole, Folding) {
+    ExpressionPeephole peephole;
+    ExpressionPeephole::LeafWidths widths;
+
+    EXPECT_EQ(5, valueOf(peephole.optimize(op("+", hexstr("0x2"), hexstr("0x3")), widths)));
+    EXPECT_EQ(0x30, valueOf(peephole.optimize(op("<<", hexstr("0x3"), hexstr("0x4")), widths)));
+    // nested constant operations are folded bottom-up
+    auto nested = op("*", op("+", hexstr("0x1"), hexstr("0x2")), hexstr("0x4"));
+    EXPECT_EQ(12, valueOf(peephole.optimize(nested, widths)));
+    auto compare = peephole.optimize(op("<", hexstr("0x1"), hexstr("0x2")), widths);
+    EXPECT_EQ("bool", typeOf(compare));
+
+    // negative constants and negative results are left to the target
+    EXPECT_EQ("+", opOf(peephole.optimize(op("+", hexstr("-0x2"), hexstr("0x3")), widths)));
+    EXPECT_EQ("-", opOf(peephole.optimize(op("-", hexstr("0x2"), hexstr("0x3")), widths)));
+    EXPECT_EQ(5u, peephole.getStats().folded);
+}
+
+TEST_F(BMV2ExpressionPeephole, Wrappers) {
+    ExpressionPeephole peephole;
+    auto f = field("f");
+    auto g = field("g");
+    ExpressionPeephole::LeafWidths widths;
+
+    // the operands are unwrapped; the operation keeps its expression node
+    auto original = op("+", wrap(wrap(f)), wrap(g));
+    auto result = peephole.optimize(original, widths);
+    ASSERT_EQ("+", opOf(result));
+    EXPECT_EQ(f, operation(result)->get("left"));
+    EXPECT_EQ(g, operation(result)->get("right"));
+    EXPECT_EQ(3u, peephole.getStats().wrappers);
+
+    // the nodes may be shared, so the original is unchanged
+    EXPECT_EQ("expression", typeOf(operation(original)->get("left")));
+    EXPECT_NE(original, result);
+}
+
+}  // namespace Test
@@ -0,0 +1,189 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <boost/optional.hpp>
+
+#include "gtest/gtest.h"
+#include "ir/ir.h"
+#include "helpers.h"
+#include "lib/json.h"
+
+#include "backends/bmv2/common/helpers.h"
+#include "backends/bmv2/common/options.h"
+#include "backends/bmv2/simple_switch/midend.h"
+#include "backends/bmv2/simple_switch/simpleSwitch.h"
+
+namespace Test {
+
+namespace {
+
+/// A program with a direct counter and a direct meter; @spacing is
+/// inserted in the ingress control.
+std::string program(const std::string& spacing) {
+    return R"(
+header H { bit<8> a; bit<8> b; }
+struct Headers { H h; }
+struct Metadata { bit<8> color; }
+
+parser parse(packet_in packet, out Headers headers, inout Metadata meta,
+             inout standard_metadata_t sm) {
+    state start { packet.extract(headers.h); transition accept; }
+}
+
+control verifyChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control ingress(inout Headers headers, inout Metadata meta,
+                inout standard_metadata_t sm) {
+    direct_counter(CounterType.packets) hits;
+    direct_meter<bit<8>>(MeterType.bytes) rate;
+    action color() { rate.read(meta.color); headers.h.b = meta.color; }
+    table t {
+        key = { headers.h.a : exact; }
+        actions = { color; NoAction; }
+        counters = hits;
+        meters = rate;
+    }
+    apply {)" + spacing + R"(t.apply(); }
+}
+control egress(inout Headers headers, inout Metadata meta,
+               inout standard_metadata_t sm) { apply { } }
+control computeChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control deparse(packet_out packet, in Headers headers) {
+    apply { packet.emit(headers.h); }
+}
+
+V1Switch(parse(), verifyChecksum(), ingress(), egress(),
+         computeChecksum(), deparse()) main;
+    )";
+}
+
+/// The serialized JSON of @source; the fragments are cached in @cache
+/// unless it is null.
+std::string compile(const std::string& source, cstring cache) {
+    auto test = FrontendTestCase::create(P4_SOURCE(P4Headers::V1MODEL, source.c_str()),
+                                         CompilerOptions::FrontendVersion::P4_16);
+    if (!test)
+        return "";
+    // the ids of each compilation start from 0, as in a new process
+    BMV2::IdScope ids;
+    auto options = new BMV2::BMV2Options();
+    options->langVersion = CompilerOptions::FrontendVersion::P4_16;
+    options->jsonCache = cache;
+    auto midEnd = new BMV2::SimpleSwitchMidEnd(*options);
+    const IR::P4Program* program = test->program;
+    auto toplevel = midEnd->process(program);
+    if (toplevel == nullptr)
+        return "";
+    auto backend = new BMV2::SimpleSwitchBackend(*options, &midEnd->refMap,
+                                                 &midEnd->typeMap, &midEnd->enumMap);
+    backend->convert(toplevel);
+    std::stringstream out;
+    backend->serialize(out);
+    return out.str();
+}
+
+std::vector<std::string> filesIn(cstring directory) {
+    std::vector<std::string> result;
+    auto dir = opendir(directory.c_str());
+    if (dir == nullptr)
+        return result;
+    while (auto entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name != "." && name != "..")
+            result.push_back(directory + "/" + name);
+    }
+    closedir(dir);
+    return result;
+}
+
+/// Replaces every @from with @to in the cached fragments
+void rewrite(cstring directory, const std::string& from, const std::string& to) {
+    for (auto file : filesIn(directory)) {
+        std::stringstream text;
+        text << std::ifstream(file).rdbuf();
+        std::string contents = text.str();
+        for (size_t pos = contents.find(from); pos != std::string::npos;
+             pos = contents.find(from, pos + to.size()))
+            contents.replace(pos, from.size(), to);
+        std::ofstream(file) << contents;
+    }
+}
+
+}  // namespace
+
+class BMV2FragmentCache : public P4CTest {
+ protected:
+    cstring directory;
+
+    void SetUp() override {
+        char name[] = "/tmp/p4c-fragment-cache-XXXXXX";
+        ASSERT_TRUE(mkdtemp(name) != nullptr);
+        directory = name;
+    }
+    void TearDown() override {
+        for (auto file : filesIn(directory))
+            unlink(file.c_str());
+        rmdir(directory.c_str());
+    }
+};
+
+TEST_F(BMV2FragmentCache, ReloadedSameAsConverted) {
+    auto source = program(" ");
+    auto uncached = compile(source, nullptr);
+    ASSERT_EQ(0u, ::errorCount());
+    ASSERT_NE("", uncached);
+    EXPECT_NE(std::string::npos, uncached.find("\"is_direct\" : true"));
+    EXPECT_NE(std::string::npos, uncached.find("\"binding\" : \"ingress.t\""));
+    EXPECT_NE(std::string::npos, uncached.find("\"result_target\""));
+
+    auto stored = compile(source, directory);
+    ASSERT_EQ(0u, ::errorCount());
+    EXPECT_EQ(uncached, stored);
+    // the parser, the ingress, the egress and the deparser
+    EXPECT_EQ(4u, filesIn(directory).size());
+
+    auto reloaded = compile(source, directory);
+    ASSERT_EQ(0u, ::errorCount());
+    EXPECT_EQ(uncached, reloaded);
+    EXPECT_EQ(4u, filesIn(directory).size());
+
+    // The fragments were read from the cache
+    rewrite(directory, "ingress.t", "ingress.cached");
+    auto modified = compile(source, directory);
+    ASSERT_EQ(0u, ::errorCount());
+    EXPECT_NE(std::string::npos, modified.find("\"binding\" : \"ingress.cached\""));
+}
+
+TEST_F(BMV2FragmentCache, SpacingChangesKey) {
+    (void)compile(program(" "), directory);
+    ASSERT_EQ(0u, ::errorCount());
+    rewrite(directory, "ingress.t", "ingress.cached");
+
+    // The column of t.apply() changes, although the first line of the
+    // ingress control does not
+    auto source = program("   ");
+    auto uncached = compile(source, nullptr);
+    auto cached = compile(source, directory);
+    ASSERT_EQ(0u, ::errorCount());
+    EXPECT_EQ(uncached, cached);
+    EXPECT_EQ(std::string::npos, cached.find("ingress.cached"));
+}
+
+}  // namespace Test
@@ -0,0 +1,164 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "gtest/gtest.h"
+#include "helpers.h"
+#include "lib/json.h"
+
+#include "backends/bmv2/common/JsonObjects.h"
+
+using namespace BMV2;
+
+namespace Test {
+
+namespace {
+
+Util::JsonObject* field(cstring name) {
+    auto result = new Util::JsonObject();
+    result->emplace("type", "field");
+    auto value = new Util::JsonArray();
+    value->append("scalars");
+    value->append(name);
+    result->emplace("value", value);
+    return result;
+}
+
+Util::JsonObject* hexstr(cstring value) {
+    auto result = new Util::JsonObject();
+    result->emplace("type", "hexstr");
+    result->emplace("value", value);
+    return result;
+}
+
+Util::JsonObject* typed(cstring type, Util::IJson* value) {
+    auto result = new Util::JsonObject();
+    result->emplace("type", type);
+    result->emplace("value", value);
+    return result;
+}
+
+void addCalculation(JsonObjects& json, cstring name, unsigned id, cstring algo) {
+    auto calc = new Util::JsonObject();
+    calc->emplace("name", name);
+    calc->emplace("id", id);
+    calc->emplace("algo", algo);
+    auto input = new Util::JsonArray();
+    input->append(field("a"));
+    input->append(field("b"));
+    calc->emplace("input", input);
+    json.calculations->append(calc);
+}
+
+void addList(Util::JsonArray* lists, cstring name, unsigned id, cstring element) {
+    auto list = new Util::JsonObject();
+    list->emplace("id", id);
+    list->emplace("name", name);
+    auto elements = new Util::JsonArray();
+    elements->append(field(element));
+    list->emplace("elements", elements);
+    lists->append(list);
+}
+
+Util::JsonArray* addPrimitive(Util::JsonArray* primitives, cstring op) {
+    auto primitive = new Util::JsonObject();
+    primitive->emplace("op", op);
+    auto parameters = new Util::JsonArray();
+    primitive->emplace("parameters", parameters);
+    primitives->append(primitive);
+    return parameters;
+}
+
+cstring stringOf(const Util::IJson* json) {
+    return json->to<Util::JsonValue>()->getString();
+}
+
+const Util::JsonObject* parameter(const Util::JsonArray* primitives, size_t p, size_t i) {
+    return primitives->at(p)->to<Util::JsonObject>()->get("parameters")
+            ->to<Util::JsonArray>()->at(i)->to<Util::JsonObject>();
+}
+
+std::vector<unsigned> ids(const Util::JsonArray* array) {
+    std::vector<unsigned> result;
+    for (auto e : *array)
+        result.push_back(e->to<Util::JsonObject>()->get("id")->to<Util::JsonValue>()->getInt());
+    return result;
+}
+
+}  // namespace
+
+class BMV2JsonObjects : public P4CTest { };
+
+TEST_F(BMV2JsonObjects, Deduplicate) {
+    JsonObjects json;
+    addCalculation(json, "calc", 0, "crc16");
+    addCalculation(json, "calc_0", 1, "crc16");
+    addCalculation(json, "calc_1", 2, "crc32");
+
+    addList(json.field_lists, "fl", 1, "a");
+    addList(json.field_lists, "fl_0", 2, "a");
+    addList(json.field_lists, "fl_1", 3, "b");
+
+    // learn lists with different names are different digests
+    addList(json.learn_lists, "digest", 1, "a");
+    addList(json.learn_lists, "digest", 2, "a");
+    addList(json.learn_lists, "other", 3, "a");
+
+    auto primitives = new Util::JsonArray();
+    auto clone = addPrimitive(primitives, "clone_ingress_pkt_to_egress");
+    clone->append(hexstr("0x00000005"));
+    clone->append(hexstr("0x00000002"));
+    auto digest = addPrimitive(primitives, "generate_digest");
+    digest->append(hexstr("0x00000001"));
+    digest->append(hexstr("0x00000002"));
+    auto other = addPrimitive(primitives, "generate_digest");
+    other->append(hexstr("0x00000001"));
+    other->append(hexstr("0x00000003"));
+    // the id is not a constant: nothing to rewrite
+    auto resubmit = addPrimitive(primitives, "resubmit");
+    resubmit->append(typed("runtime_data", new Util::JsonValue(0)));
+    auto modify = addPrimitive(primitives, "modify_field_with_hash_based_offset");
+    modify->append(field("c"));
+    modify->append(hexstr("0x0000"));
+    modify->append(typed("calculation", new Util::JsonValue("calc_0")));
+    modify->append(hexstr("0x00010000"));
+    auto params = new Util::JsonArray();
+    json.add_action("act", params, primitives);
+
+    auto checksum = new Util::JsonObject();
+    checksum->emplace("name", "cksum");
+    checksum->emplace("id", 0);
+    checksum->emplace("calculation", "calc_0");
+    json.checksums->append(checksum);
+
+    json.deduplicate();
+
+    EXPECT_EQ((std::vector<unsigned>{ 0, 2 }), ids(json.calculations));
+    EXPECT_EQ((std::vector<unsigned>{ 1, 3 }), ids(json.field_lists));
+    EXPECT_EQ((std::vector<unsigned>{ 1, 3 }), ids(json.learn_lists));
+
+    // the session is not a field list id
+    EXPECT_EQ("0x00000005", stringOf(parameter(primitives, 0, 0)->get("value")));
+    EXPECT_EQ("0x00000001", stringOf(parameter(primitives, 0, 1)->get("value")));
+    EXPECT_EQ("0x00000001", stringOf(parameter(primitives, 1, 1)->get("value")));
+    EXPECT_EQ("0x00000003", stringOf(parameter(primitives, 2, 1)->get("value")));
+    EXPECT_EQ("runtime_data", stringOf(parameter(primitives, 3, 0)->get("type")));
+    EXPECT_EQ("calculation", stringOf(parameter(primitives, 4, 2)->get("type")));
+    EXPECT_EQ("calc", stringOf(parameter(primitives, 4, 2)->get("value")));
+    EXPECT_EQ("0x0000", stringOf(parameter(primitives, 4, 1)->get("value")));
+    EXPECT_EQ("calc", stringOf(checksum->get("calculation")));
+}
+
+}  // namespace Test
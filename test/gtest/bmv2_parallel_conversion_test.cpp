@@ -0,0 +1,168 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <set>
+#include <sstream>
+
+#include "gtest/gtest.h"
+#include "helpers.h"
+#include "ir/ir.h"
+#include "lib/json.h"
+
+#include "frontends/common/resolveReferences/referenceMap.h"
+#include "frontends/p4/typeMap.h"
+#include "backends/bmv2/common/JsonObjects.h"
+#include "backends/bmv2/common/parallelConversion.h"
+
+using namespace BMV2;
+
+namespace Test {
+
+namespace {
+
+const unsigned parts = 3;
+
+// Converts a part the way the parser and control converters do: it
+// allocates ids and generates names, and the odd parts have a field list.
+void convertPart(ConversionContext* unit, unsigned part) {
+    auto parser = new Util::JsonObject();
+    parser->emplace("name", cstring("parser") + Util::toString(part));
+    parser->emplace("id", nextId("parser"));
+    auto states = new Util::JsonArray();
+    for (unsigned i = 0; i < 2; i++) {
+        auto state = new Util::JsonObject();
+        state->emplace("name", cstring("state") + Util::toString(i));
+        state->emplace("id", nextId("parse_states"));
+        states->append(state);
+    }
+    parser->emplace("parse_states", states);
+    unit->json->parsers->append(parser);
+
+    auto calc = new Util::JsonObject();
+    cstring calcName = unit->newName("calc_");
+    calc->emplace("name", calcName);
+    calc->emplace("id", nextId("calculations"));
+    unit->json->calculations->append(calc);
+    auto checksum = new Util::JsonObject();
+    checksum->emplace("name", unit->newName("cksum_"));
+    checksum->emplace("id", nextId("checksums"));
+    checksum->emplace("calculation", calcName);
+    unit->json->checksums->append(checksum);
+
+    if (part % 2 == 1) {
+        auto list = new Util::JsonObject();
+        list->emplace("id", nextId("field_lists"));
+        list->emplace("name", unit->newName("fl"));
+        unit->json->field_lists->append(list);
+    }
+}
+
+JsonObjects* convert(bool reverse) {
+    P4::ReferenceMap refMap;
+    P4::TypeMap typeMap;
+    auto json = new JsonObjects();
+    ConversionContext ctxt(&refMap, &typeMap, nullptr, nullptr, nullptr, json);
+    // the ids do not depend on the other tests
+    IdScope scope;
+    ParallelConversion conversion(&ctxt, [](P4::TypeMap*) -> ExpressionConverter* {
+        return nullptr; });
+    conversion.setReverseOrder(reverse);
+    for (unsigned p = 0; p < parts; p++)
+        conversion.add(nullptr, [p](ConversionContext* unit) { convertPart(unit, p); });
+    conversion.run();
+    return json;
+}
+
+std::string serialized(const JsonObjects* json) {
+    std::stringstream out;
+    json->toplevel->serialize(out);
+    return out.str();
+}
+
+std::vector<cstring> strings(const Util::JsonArray* array, cstring field) {
+    std::vector<cstring> result;
+    for (auto e : *array)
+        result.push_back(e->to<Util::JsonObject>()->get(field)
+                         ->to<Util::JsonValue>()->getString());
+    return result;
+}
+
+std::vector<unsigned> ids(const Util::JsonArray* array) {
+    std::vector<unsigned> result;
+    for (auto e : *array)
+        result.push_back(e->to<Util::JsonObject>()->get("id")->to<Util::JsonValue>()->getInt());
+    return result;
+}
+
+}  // namespace
+
+class BMV2ParallelConversion : public P4CTest { };
+
+TEST_F(BMV2ParallelConversion, SameOutputInAnyOrder) {
+    auto forward = convert(false);
+    auto backward = convert(true);
+    ASSERT_EQ(0u, ::errorCount());
+    EXPECT_EQ(serialized(forward), serialized(backward));
+
+    // The ids and names are those of a conversion in the order of the parts
+    EXPECT_EQ((std::vector<unsigned>{ 0, 1, 2 }), ids(forward->parsers));
+    std::vector<unsigned> states;
+    for (auto p : *forward->parsers)
+        for (auto id : ids(p->to<Util::JsonObject>()->get("parse_states")
+                           ->to<Util::JsonArray>()))
+            states.push_back(id);
+    EXPECT_EQ((std::vector<unsigned>{ 0, 1, 2, 3, 4, 5 }), states);
+    EXPECT_EQ((std::vector<unsigned>{ 0, 1, 2 }), ids(forward->calculations));
+    EXPECT_EQ((std::vector<unsigned>{ 0 }), ids(forward->field_lists));
+
+    P4::ReferenceMap refMap;
+    std::vector<cstring> calcs, checksums, lists;
+    for (unsigned p = 0; p < parts; p++) {
+        calcs.push_back(refMap.newName("calc_"));
+        checksums.push_back(refMap.newName("cksum_"));
+        if (p % 2 == 1)
+            lists.push_back(refMap.newName("fl"));
+    }
+    EXPECT_EQ(calcs, strings(forward->calculations, "name"));
+    EXPECT_EQ(checksums, strings(forward->checksums, "name"));
+    EXPECT_EQ(calcs, strings(forward->checksums, "calculation"));
+    EXPECT_EQ(lists, strings(forward->field_lists, "name"));
+}
+
+TEST_F(BMV2ParallelConversion, UniqueNodeIds) {
+    // Converting a part creates IR nodes, concurrently in threaded builds
+    const unsigned nodes = 10000;
+    std::vector<std::vector<int>> created(parts);
+    P4::ReferenceMap refMap;
+    P4::TypeMap typeMap;
+    ConversionContext ctxt(&refMap, &typeMap, nullptr, nullptr, nullptr, new JsonObjects());
+    ParallelConversion conversion(&ctxt, [](P4::TypeMap*) -> ExpressionConverter* {
+        return nullptr; });
+    for (unsigned p = 0; p < parts; p++)
+        conversion.add(nullptr, [p, &created](ConversionContext*) {
+            for (unsigned i = 0; i < nodes; i++)
+                created[p].push_back((new IR::Constant(IR::Type_Bits::get(8 + i % 8), i))->id);
+        });
+    conversion.run();
+    ASSERT_EQ(0u, ::errorCount());
+
+    std::set<int> ids;
+    for (auto& part : created)
+        ids.insert(part.begin(), part.end());
+    EXPECT_EQ(parts * nodes, ids.size());
+}
+
+}  // namespace Test
@@ -0,0 +1,233 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <sstream>
+#include <boost/optional.hpp>
+
+#include "gtest/gtest.h"
+#include "ir/ir.h"
+#include "helpers.h"
+#include "lib/json.h"
+
+#include "backends/bmv2/common/helpers.h"
+#include "backends/bmv2/common/tableEntries.h"
+#include "frontends/p4/typeChecking/typeChecker.h"
+
+using namespace P4;
+
+namespace Test {
+
+namespace {
+
+boost::optional<FrontendTestCase> createTable(const char* entries) {
+    std::string source = R"(
+header H { bit<8> a; bit<8> b; bit<32> c; bit<16> d; }
+struct Headers { H h; }
+struct Metadata { }
+
+parser parse(packet_in packet, out Headers headers, inout Metadata meta,
+             inout standard_metadata_t sm) {
+    state start { packet.extract(headers.h); transition accept; }
+}
+
+control verifyChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control ingress(inout Headers headers, inout Metadata meta,
+                inout standard_metadata_t sm) {
+    action set(bit<8> x, bit<16> y) { headers.h.a = x; headers.h.d = y; }
+    table t {
+        key = { headers.h.a : exact; headers.h.b : ternary;
+                headers.h.c : lpm; headers.h.d : range; }
+        actions = { set; NoAction; }
+        )";
+    source += entries;
+    source += R"(
+    }
+    apply { t.apply(); }
+}
+control egress(inout Headers headers, inout Metadata meta,
+               inout standard_metadata_t sm) { apply { } }
+control computeChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control deparse(packet_out packet, in Headers headers) {
+    apply { packet.emit(headers.h); }
+}
+
+V1Switch(parse(), verifyChecksum(), ingress(), egress(),
+         computeChecksum(), deparse()) main;
+    )";
+    return FrontendTestCase::create(P4_SOURCE(P4Headers::V1MODEL, source.c_str()),
+                                    CompilerOptions::FrontendVersion::P4_16);
+}
+
+const IR::P4Table* findTable(const IR::P4Program* program, cstring name) {
+    const IR::P4Table* result = nullptr;
+    forAllMatching<IR::P4Table>(program, [&](const IR::P4Table* table) {
+        if (table->name == name)
+            result = table;
+    });
+    return result;
+}
+
+/// The match type and width of each key element of @table in @program
+std::vector<BMV2::TableEntries::Key> keysOf(const IR::P4Program* program,
+                                            const IR::P4Table* table) {
+    ReferenceMap refMap;
+    TypeMap typeMap;
+    program->apply(TypeChecking(&refMap, &typeMap));
+    std::vector<BMV2::TableEntries::Key> keys;
+    for (auto ke : table->getKey()->keyElements)
+        keys.push_back({ ke->matchType->path->name.name,
+                         typeMap.getType(ke->expression, true)->width_bits() });
+    return keys;
+}
+
+/// Action ids by name: set is 3, every other action is 1
+std::map<cstring, unsigned> actionIdsOf(const IR::EntriesList* entries) {
+    std::map<cstring, unsigned> ids;
+    for (auto e : entries->entries) {
+        auto call = e->getAction()->to<IR::MethodCallExpression>();
+        auto name = call->method->to<IR::PathExpression>()->path->name.name;
+        ids[name] = call->arguments->empty() ? 1 : 3;
+    }
+    return ids;
+}
+
+/// The entries in the layout of the JsonObject output the BMv2 back-end
+/// produced before the entries were streamed.
+Util::JsonArray* referenceEntries(const IR::EntriesList* entries,
+                                  const std::vector<BMV2::TableEntries::Key>& keys,
+                                  const std::map<cstring, unsigned>& actionIds) {
+    auto result = new Util::JsonArray();
+    int entryPriority = 1;
+    for (auto e : entries->entries) {
+        auto entry = new Util::JsonObject();
+        auto matchKeys = new Util::JsonArray();
+        entry->emplace("match_key", matchKeys);
+        size_t keyIndex = 0;
+        for (auto k : e->getKeys()->components) {
+            auto& key = keys.at(keyIndex++);
+            unsigned k8 = ROUNDUP(key.width, 8);
+            auto json = new Util::JsonObject();
+            json->emplace("match_type", key.matchType);
+            if (key.matchType == "exact") {
+                json->emplace("key", BMV2::stringRepr(k->to<IR::Constant>()->value, k8));
+            } else if (key.matchType == "ternary") {
+                if (auto km = k->to<IR::Mask>()) {
+                    json->emplace("key", BMV2::stringRepr(km->left->to<IR::Constant>()->value, k8));
+                    json->emplace("mask",
+                                  BMV2::stringRepr(km->right->to<IR::Constant>()->value, k8));
+                } else if (k->is<IR::Constant>()) {
+                    json->emplace("key", BMV2::stringRepr(k->to<IR::Constant>()->value, k8));
+                    json->emplace("mask", BMV2::stringRepr(Util::mask(key.width), k8));
+                } else {
+                    json->emplace("key", BMV2::stringRepr(0, k8));
+                    json->emplace("mask", BMV2::stringRepr(0, k8));
+                }
+            } else if (key.matchType == "lpm") {
+                if (auto km = k->to<IR::Mask>()) {
+                    json->emplace("key", BMV2::stringRepr(km->left->to<IR::Constant>()->value, k8));
+                    unsigned long mask = km->right->to<IR::Constant>()->value.get_ui();
+                    json->emplace("prefix_length", key.width - __builtin_ctzl(mask));
+                } else if (k->is<IR::Constant>()) {
+                    json->emplace("key", BMV2::stringRepr(k->to<IR::Constant>()->value, k8));
+                    json->emplace("prefix_length", key.width);
+                } else {
+                    json->emplace("key", BMV2::stringRepr(0, k8));
+                    json->emplace("prefix_length", 0);
+                }
+            } else {
+                if (auto kr = k->to<IR::Range>()) {
+                    json->emplace("start",
+                                  BMV2::stringRepr(kr->left->to<IR::Constant>()->value, k8));
+                    json->emplace("end",
+                                  BMV2::stringRepr(kr->right->to<IR::Constant>()->value, k8));
+                } else {
+                    json->emplace("start", BMV2::stringRepr(0, k8));
+                    json->emplace("end", BMV2::stringRepr(Util::mask(key.width), k8));
+                }
+            }
+            matchKeys->append(json);
+        }
+
+        auto action = new Util::JsonObject();
+        auto call = e->getAction()->to<IR::MethodCallExpression>();
+        auto name = call->method->to<IR::PathExpression>()->path->name.name;
+        action->emplace("action_id", actionIds.at(name));
+        auto actionData = new Util::JsonArray();
+        for (auto arg : *call->arguments)
+            actionData->append(BMV2::stringRepr(arg->expression->to<IR::Constant>()->value, 0));
+        action->emplace("action_data", actionData);
+        entry->emplace("action_entry", action);
+
+        if (auto priority = e->getAnnotation("priority"))
+            entry->emplace("priority", priority->expr.front()->to<IR::Constant>()->value);
+        else
+            entry->emplace("priority", entryPriority);
+        entryPriority++;
+        result->append(entry);
+    }
+    return result;
+}
+
+/// The streamed entries, and the reference output
+std::pair<std::string, std::string> serialize(const IR::EntriesList* entries,
+                                              const std::vector<BMV2::TableEntries::Key>& keys) {
+    auto actionIds = actionIdsOf(entries);
+    BMV2::TableEntries streamed(entries, keys, actionIds);
+    streamed.check();
+    std::ostringstream actual;
+    streamed.serialize(actual);
+    std::ostringstream expected;
+    referenceEntries(entries, keys, actionIds)->serialize(expected);
+    return { actual.str(), expected.str() };
+}
+
+}  // namespace
+
+class BMV2TableEntries : public P4CTest { };
+
+TEST_F(BMV2TableEntries, SameAsJsonObjects) {
+    auto test = createTable(R"(
+        const entries = {
+            (1, 0x0a &&& 0x0f, 0x0a000000 &&& 0xff000000, 1..5) : set(7, 0x300);
+            (2, _, 0x0b000000, _) : NoAction();
+            (0xff, 3, _, 0..0xffff) : set(0, 0) @priority(10);
+            (4, 0x10 &&& 0xf0, 0xc0a80100 &&& 0xffffff00, 0x8000..0x8fff) : NoAction();
+        }
+    )");
+    ASSERT_TRUE(test);
+    ASSERT_EQ(0u, ::errorCount());
+    auto table = findTable(test->program, "t");
+    ASSERT_TRUE(table != nullptr);
+    ASSERT_TRUE(table->getEntries() != nullptr);
+    auto output = serialize(table->getEntries(), keysOf(test->program, table));
+    EXPECT_EQ(0u, ::errorCount());
+    EXPECT_EQ(output.second, output.first);
+    EXPECT_NE(std::string::npos, output.first.find("\"prefix_length\" : 24"));
+    EXPECT_NE(std::string::npos, output.first.find("\"priority\" : 10"));
+    EXPECT_NE(std::string::npos, output.first.find("\"priority\" : 4"));
+    EXPECT_NE(std::string::npos, output.first.find("\"0x300\""));
+}
+
+TEST_F(BMV2TableEntries, EmptyList) {
+    // The grammar requires at least one entry, so build the list directly
+    auto entries = new IR::EntriesList(IR::Vector<IR::Entry>());
+    auto output = serialize(entries, { { "exact", 8 } });
+    EXPECT_EQ(0u, ::errorCount());
+    EXPECT_EQ("[]", output.first);
+    EXPECT_EQ(output.second, output.first);
+}
+
+}  // namespace Test
@@ -0,0 +1,126 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <boost/optional.hpp>
+
+#include "gtest/gtest.h"
+#include "ir/ir.h"
+#include "helpers.h"
+
+#include "backends/bmv2/common/tableKeyLayout.h"
+
+using namespace P4;
+
+namespace Test {
+
+namespace {
+
+boost::optional<FrontendTestCase> createTables() {
+    return FrontendTestCase::create(P4_SOURCE(P4Headers::V1MODEL, R"(
+header H { bit<32> f; bit<8> g; }
+struct Headers { H h; }
+struct Metadata { }
+
+parser parse(packet_in packet, out Headers headers, inout Metadata meta,
+             inout standard_metadata_t sm) {
+    state start { packet.extract(headers.h); transition accept; }
+}
+
+control verifyChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control ingress(inout Headers headers, inout Metadata meta,
+                inout standard_metadata_t sm) {
+    action set(bit<8> v) { headers.h.g = v; }
+    table slices {
+        key = { headers.h.g : ternary; headers.h.f[31:16] : exact;
+                headers.h.f[15:0] : exact; }
+        actions = { set; NoAction; }
+        const entries = { (_, 2, 3) : set(1); }
+    }
+    table single {
+        key = { headers.h.g : ternary; headers.h.f : lpm; }
+        actions = { set; NoAction; }
+        const entries = {
+            (1 &&& 0xff, 2 &&& 0xffffffff) : set(1);
+            (2, 3 &&& 0xffffffff) : set(2);
+        }
+    }
+    apply { slices.apply(); single.apply(); }
+}
+control egress(inout Headers headers, inout Metadata meta,
+               inout standard_metadata_t sm) { apply { } }
+control computeChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control deparse(packet_out packet, in Headers headers) {
+    apply { packet.emit(headers.h); }
+}
+
+V1Switch(parse(), verifyChecksum(), ingress(), egress(),
+         computeChecksum(), deparse()) main;
+    )"), CompilerOptions::FrontendVersion::P4_16);
+}
+
+const IR::P4Table* findTable(const IR::P4Program* program, cstring name) {
+    const IR::P4Table* result = nullptr;
+    forAllMatching<IR::P4Table>(program, [&](const IR::P4Table* table) {
+        if (table->name == name)
+            result = table;
+    });
+    return result;
+}
+
+cstring keyName(const IR::KeyElement* element) {
+    auto annotation = element->getAnnotation(IR::Annotation::nameAnnotation);
+    return annotation->expr[0]->to<IR::StringLiteral>()->value;
+}
+
+}  // namespace
+
+class BMV2TableKeyLayout : public P4CTest { };
+
+TEST_F(BMV2TableKeyLayout, Tables) {
+    auto test = createTables();
+    ASSERT_TRUE(test);
+    auto program = test->program->apply(BMV2::TableKeyLayout(false));
+    ASSERT_TRUE(program != nullptr);
+    EXPECT_EQ(0u, ::errorCount());
+
+    // the exact slices move before the ternary field and are merged
+    auto slices = findTable(program, "slices");
+    ASSERT_TRUE(slices != nullptr);
+    auto& keys = slices->getKey()->keyElements;
+    ASSERT_EQ(2u, keys.size());
+    EXPECT_EQ("headers.h.f", keyName(keys.at(0)));
+    EXPECT_EQ("exact", keys.at(0)->matchType->path->name.name);
+    EXPECT_TRUE(keys.at(0)->expression->is<IR::Member>());
+    EXPECT_EQ("headers.h.g", keyName(keys.at(1)));
+    EXPECT_EQ("ternary", keys.at(1)->matchType->path->name.name);
+    auto entry = slices->getEntries()->entries.at(0)->keys->components;
+    ASSERT_EQ(2u, entry.size());
+    EXPECT_EQ(0x20003, entry.at(0)->to<IR::Constant>()->asInt());
+    EXPECT_TRUE(entry.at(1)->is<IR::DefaultExpression>());
+
+    // only single values are matched: the table becomes exact
+    auto single = findTable(program, "single");
+    ASSERT_TRUE(single != nullptr);
+    ASSERT_EQ(2u, single->getKey()->keyElements.size());
+    for (auto ke : single->getKey()->keyElements)
+        EXPECT_EQ("exact", ke->matchType->path->name.name);
+    EXPECT_EQ("headers.h.g", keyName(single->getKey()->keyElements.at(0)));
+    for (auto e : single->getEntries()->entries)
+        for (auto k : e->keys->components)
+            EXPECT_TRUE(k->is<IR::Constant>());
+}
+
+}  // namespace Test
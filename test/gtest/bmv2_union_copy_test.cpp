@@ -0,0 +1,164 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <boost/optional.hpp>
+
+#include "gtest/gtest.h"
+#include "ir/ir.h"
+#include "helpers.h"
+#include "lib/json.h"
+
+#include "backends/bmv2/common/options.h"
+#include "backends/bmv2/simple_switch/midend.h"
+#include "backends/bmv2/simple_switch/simpleSwitch.h"
+
+namespace Test {
+
+namespace {
+
+/// The JSON of a program whose ingress has the actions @actions, which
+/// table t can call.  @actionList is the list of their names.
+const BMV2::JsonObjects* convert(const std::string& actions, const std::string& actionList) {
+    std::string source = R"(
+header A { bit<8> a; }
+header B { bit<16> b; }
+header_union U { A a; B b; }
+struct Headers { U u1; U u2; }
+struct Metadata { bit<8> x; }
+
+parser parse(packet_in packet, out Headers headers, inout Metadata meta,
+             inout standard_metadata_t sm) {
+    state start { packet.extract(headers.u2.a); transition accept; }
+}
+
+control verifyChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control ingress(inout Headers headers, inout Metadata meta,
+                inout standard_metadata_t sm) {
+)" + actions + R"(
+    table t {
+        key = { meta.x : exact; }
+        actions = { )" + actionList + R"( }
+    }
+    apply { t.apply(); }
+}
+control egress(inout Headers headers, inout Metadata meta,
+               inout standard_metadata_t sm) { apply { } }
+control computeChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control deparse(packet_out packet, in Headers headers) {
+    apply { packet.emit(headers.u1); }
+}
+
+V1Switch(parse(), verifyChecksum(), ingress(), egress(),
+         computeChecksum(), deparse()) main;
+    )";
+    auto test = FrontendTestCase::create(P4_SOURCE(P4Headers::V1MODEL, source.c_str()),
+                                         CompilerOptions::FrontendVersion::P4_16);
+    if (!test)
+        return nullptr;
+    auto options = new BMV2::BMV2Options();
+    options->langVersion = CompilerOptions::FrontendVersion::P4_16;
+    auto midEnd = new BMV2::SimpleSwitchMidEnd(*options);
+    const IR::P4Program* program = test->program;
+    auto toplevel = midEnd->process(program);
+    if (toplevel == nullptr)
+        return nullptr;
+    auto backend = new BMV2::SimpleSwitchBackend(*options, &midEnd->refMap,
+                                                 &midEnd->typeMap, &midEnd->enumMap);
+    backend->convert(toplevel);
+    return backend->json;
+}
+
+/// The ops of the primitives of the action whose name ends with @name
+std::vector<cstring> primitivesOf(const BMV2::JsonObjects* json, cstring name) {
+    std::vector<cstring> result;
+    for (auto a : *json->actions) {
+        auto action = a->to<Util::JsonObject>();
+        cstring actionName = action->get("name")->to<Util::JsonValue>()->getString();
+        if (actionName != name && !actionName.endsWith("." + name))
+            continue;
+        for (auto p : *action->get("primitives")->to<Util::JsonArray>())
+            result.push_back(p->to<Util::JsonObject>()->get("op")
+                             ->to<Util::JsonValue>()->getString());
+    }
+    return result;
+}
+
+/// The parameters of the first primitive of the action whose name ends with @name
+const Util::JsonArray* firstParameters(const BMV2::JsonObjects* json, cstring name) {
+    for (auto a : *json->actions) {
+        auto action = a->to<Util::JsonObject>();
+        cstring actionName = action->get("name")->to<Util::JsonValue>()->getString();
+        if (actionName != name && !actionName.endsWith("." + name))
+            continue;
+        auto primitives = action->get("primitives")->to<Util::JsonArray>();
+        if (primitives->empty())
+            return nullptr;
+        return primitives->at(0)->to<Util::JsonObject>()->get("parameters")
+                ->to<Util::JsonArray>();
+    }
+    return nullptr;
+}
+
+cstring stringOf(const Util::IJson* json, cstring field) {
+    return json->to<Util::JsonObject>()->get(field)->to<Util::JsonValue>()->getString();
+}
+
+}  // namespace
+
+class BMV2UnionCopy : public P4CTest { };
+
+TEST_F(BMV2UnionCopy, SplitCopiesFused) {
+    auto json = convert(R"(
+    action copy() { headers.u1 = headers.u2; }
+    // the same copies written by hand, in another order
+    action byHeader() { headers.u1.b = headers.u2.b; headers.u1.a = headers.u2.a; }
+    )", "copy; byHeader;");
+    ASSERT_TRUE(json != nullptr);
+    ASSERT_EQ(0u, ::errorCount());
+
+    EXPECT_EQ(std::vector<cstring>{ "assign_union" }, primitivesOf(json, "copy"));
+    auto parameters = firstParameters(json, "copy");
+    ASSERT_TRUE(parameters != nullptr);
+    ASSERT_EQ(2u, parameters->size());
+    EXPECT_EQ("header_union", stringOf(parameters->at(0), "type"));
+    EXPECT_EQ("u1", stringOf(parameters->at(0), "value"));
+    EXPECT_EQ("header_union", stringOf(parameters->at(1), "type"));
+    EXPECT_EQ("u2", stringOf(parameters->at(1), "value"));
+
+    EXPECT_EQ(std::vector<cstring>{ "assign_union" }, primitivesOf(json, "byHeader"));
+}
+
+TEST_F(BMV2UnionCopy, InterleavedOrPartialCopiesNotFused) {
+    auto json = convert(R"(
+    action interleaved() {
+        headers.u1.a = headers.u2.a;
+        meta.x = 1;
+        headers.u1.b = headers.u2.b;
+    }
+    action partial() { headers.u1.a = headers.u2.a; }
+    action crossed() { headers.u1.a = headers.u2.a; headers.u2.b = headers.u1.b; }
+    )", "interleaved; partial; crossed;");
+    ASSERT_TRUE(json != nullptr);
+    ASSERT_EQ(0u, ::errorCount());
+
+    EXPECT_EQ((std::vector<cstring>{ "assign_header", "assign", "assign_header" }),
+              primitivesOf(json, "interleaved"));
+    EXPECT_EQ(std::vector<cstring>{ "assign_header" }, primitivesOf(json, "partial"));
+    EXPECT_EQ((std::vector<cstring>{ "assign_header", "assign_header" }),
+              primitivesOf(json, "crossed"));
+}
+
+}  // namespace Test
@@ -52,4 +52,77 @@ TEST(CallGraph, Acyclic) {
     EXPECT_EQ('a', sorted.at(2));
 }
 
+TEST(CallGraph, Cyclic) {
+    P4::CallGraph<char> cyclic("cyclic");
+    // a->b->c<->d   e
+    cyclic.calls('a', 'b');
+    cyclic.calls('b', 'c');
+    cyclic.calls('c', 'd');
+    cyclic.calls('d', 'c');
+    cyclic.add('e');
+
+    std::vector<char> sorted;
+    EXPECT_TRUE(cyclic.sort(sorted));
+    EXPECT_EQ((std::vector<char>{'d', 'c', 'b', 'a', 'e'}), sorted);
+
+    // start nodes that are not in the graph are kept
+    std::vector<char> start = { 'z', 'b' };
+    std::vector<char> partial;
+    EXPECT_TRUE(cyclic.sort(start, partial));
+    EXPECT_EQ((std::vector<char>{'z', 'd', 'c', 'b'}), partial);
+
+    std::set<char> reach;
+    cyclic.reachable('b', reach);
+    EXPECT_EQ((std::set<char>{'b', 'c', 'd'}), reach);
+}
+
+TEST(CallGraph, CompactLarge) {
+    // A parser-like graph with thousands of states: a long chain
+    // with a back-edge every 10 states.
+    const int size = 5000;
+    P4::CallGraph<int> large("large");
+    for (int i = 0; i < size - 1; i++) {
+        large.calls(i, i + 1);
+        if (i % 10 == 9)
+            large.calls(i, i - 9);
+    }
+
+    P4::CompactCallGraph<int> compact(large);
+    EXPECT_EQ(static_cast<size_t>(size), compact.size());
+    EXPECT_EQ(compact.getNode(compact.getId(1234)), 1234);
+    EXPECT_EQ(static_cast<int>(size - 100), compact.reachable(compact.getId(100)).popcount());
+
+    std::vector<int> sorted;
+    EXPECT_TRUE(large.sccSort(0, sorted));
+    EXPECT_EQ(static_cast<size_t>(size), sorted.size());
+    // callees are sorted before callers
+    EXPECT_EQ(size - 1, sorted.front());
+    EXPECT_EQ(0, sorted.back());
+
+    std::vector<int> topo;
+    EXPECT_TRUE(compact.topologicalSort(topo));
+    EXPECT_EQ(0, topo.front());
+    EXPECT_EQ(size - 1, topo.back());
+}
+
+TEST(CallGraph, QueryUnknownNode) {
+    P4::CallGraph<char> graph("graph");
+    graph.calls('a', 'b');
+
+    // querying a node does not add it to the graph
+    EXPECT_EQ(nullptr, graph.getCallees('z'));
+    EXPECT_EQ(nullptr, graph.getCallers('z'));
+    std::set<char> callees;
+    graph.getCallees('z', callees);
+    EXPECT_TRUE(callees.empty());
+
+    P4::CompactCallGraph<char> compact(graph);
+    EXPECT_EQ(2u, compact.size());
+    EXPECT_EQ(1u, compact.edgeCount());
+    EXPECT_FALSE(compact.contains('z'));
+    std::vector<char> sorted;
+    EXPECT_FALSE(graph.sort(sorted));
+    EXPECT_EQ((std::vector<char>{'b', 'a'}), sorted);
+}
+
 }  // namespace Test
@@ -0,0 +1,120 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <boost/optional.hpp>
+
+#include "gtest/gtest.h"
+#include "ir/ir.h"
+#include "helpers.h"
+
+#include "frontends/common/resolveReferences/referenceMap.h"
+#include "frontends/p4/typeMap.h"
+#include "midend/commonSubexpressions.h"
+
+using namespace P4;
+
+namespace Test {
+
+namespace {
+
+boost::optional<FrontendTestCase> createActions() {
+    return FrontendTestCase::create(P4_SOURCE(P4Headers::V1MODEL, R"(
+header H { bit<8> a; bit<8> b; bit<8> c; }
+struct Headers { H h; H[4] hs; }
+struct Metadata { bit<32> i; bool c; bool x; bool y; }
+
+extern bit<8> sideEffect(in bit<8> data);
+
+parser parse(packet_in packet, out Headers headers, inout Metadata meta,
+             inout standard_metadata_t sm) {
+    state start { packet.extract(headers.h); transition accept; }
+}
+
+control verifyChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control ingress(inout Headers headers, inout Metadata meta,
+                inout standard_metadata_t sm) {
+    action unconditional() {
+        headers.h.a = (headers.hs[meta.i].a + 1) << 1;
+        headers.h.b = ((headers.hs[meta.i].a + 1) << 1) | 1;
+    }
+    action safe() {
+        meta.x = meta.c && ((headers.h.b + headers.h.c) << 1) == 2;
+        meta.y = meta.c && ((headers.h.b + headers.h.c) << 1) == 4;
+    }
+    action outOfRange() {
+        meta.x = meta.i < 4 && ((headers.hs[meta.i].a + 1) << 1) == 2;
+        meta.y = meta.i >= 4 || ((headers.hs[meta.i].a + 1) << 1) == 4;
+        headers.h.a = meta.i < 4 ? (headers.hs[meta.i].a + 1) << 1 : 0;
+    }
+    action sideEffects() {
+        meta.x = meta.c && sideEffect(headers.h.b + headers.h.c + 1) == 2;
+        meta.y = meta.c && sideEffect(headers.h.b + headers.h.c + 1) == 4;
+    }
+    table t {
+        actions = { unconditional; safe; outOfRange; sideEffects; }
+        default_action = unconditional();
+    }
+    apply { t.apply(); }
+}
+control egress(inout Headers headers, inout Metadata meta,
+               inout standard_metadata_t sm) { apply { } }
+control computeChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control deparse(packet_out packet, in Headers headers) {
+    apply { packet.emit(headers.h); }
+}
+
+V1Switch(parse(), verifyChecksum(), ingress(), egress(),
+         computeChecksum(), deparse()) main;
+    )"), CompilerOptions::FrontendVersion::P4_16);
+}
+
+/// The temporaries declared by each action after the elimination
+std::map<cstring, unsigned> temporaries(const IR::P4Program* program) {
+    ReferenceMap refMap;
+    TypeMap typeMap;
+    program = program->apply(CommonSubexpressionElimination(&refMap, &typeMap));
+    std::map<cstring, unsigned> result;
+    forAllMatching<IR::P4Action>(program, [&](const IR::P4Action* action) {
+        auto& count = result[action->externalName()];
+        for (auto c : action->body->components)
+            if (c->is<IR::Declaration_Variable>())
+                count++;
+    });
+    return result;
+}
+
+}  // namespace
+
+class P4CCommonSubexpressions : public P4CTest { };
+
+TEST_F(P4CCommonSubexpressions, ConditionalOperands) {
+    auto test = createActions();
+    ASSERT_TRUE(test);
+    auto result = temporaries(test->program);
+    ASSERT_EQ(0u, ::errorCount());
+
+    // tmp = (hs[i].a + 1) << 1 is evaluated by both statements anyway
+    EXPECT_EQ(1u, result["ingress.unconditional"]);
+    // the operand of && cannot fail, so evaluating it early is harmless
+    EXPECT_EQ(1u, result["ingress.safe"]);
+    // hs[i] is only read when i is in range
+    EXPECT_EQ(0u, result["ingress.outOfRange"]);
+    // the call is only made when meta.c holds, and its
+    // argument is not evaluated before it
+    EXPECT_EQ(0u, result["ingress.sideEffects"]);
+}
+
+}  // namespace Test
@@ -0,0 +1,106 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <boost/optional.hpp>
+
+#include "gtest/gtest.h"
+#include "ir/ir.h"
+#include "helpers.h"
+
+#include "frontends/common/resolveReferences/referenceMap.h"
+#include "frontends/p4/typeMap.h"
+#include "midend/deadFields.h"
+
+using namespace P4;
+
+namespace Test {
+
+namespace {
+
+/// The names of the fields of a struct
+std::vector<cstring> fieldsOf(const IR::P4Program* program, cstring name) {
+    std::vector<cstring> result;
+    auto type = program->getDeclByName(name)->to<IR::Type_Struct>();
+    BUG_CHECK(type != nullptr, "%1%: no such struct", name);
+    for (auto f : type->fields)
+        result.push_back(f->name.name);
+    return result;
+}
+
+}  // namespace
+
+class P4CDeadFields : public P4CTest { };
+
+TEST_F(P4CDeadFields, ListInitializers) {
+    auto test = FrontendTestCase::create(P4_SOURCE(P4Headers::V1MODEL, R"(
+header H { bit<8> a; bit<8> b; bit<8> c; }
+struct Headers { H h; }
+struct Pair { bit<8> x; bit<8> y; }
+struct Outer { Pair p; bit<8> z; }
+struct Local { bit<8> used; bit<8> dead; }
+struct Metadata { }
+
+parser parse(packet_in packet, out Headers headers, inout Metadata meta,
+             inout standard_metadata_t sm) {
+    state start { packet.extract(headers.h); transition accept; }
+}
+
+control verifyChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control ingress(inout Headers headers, inout Metadata meta,
+                inout standard_metadata_t sm) {
+    apply {
+        Local l;
+        l.used = headers.h.c;
+        Outer o = { { headers.h.a, 2 }, headers.h.b };
+        l.dead = headers.h.c;
+        headers.h.a = l.used;
+        headers.h.b = o.p.x;
+        headers.h.c = o.z;
+    }
+}
+control egress(inout Headers headers, inout Metadata meta,
+               inout standard_metadata_t sm) { apply { } }
+control computeChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control deparse(packet_out packet, in Headers headers) {
+    apply { packet.emit(headers.h); }
+}
+
+V1Switch(parse(), verifyChecksum(), ingress(), egress(),
+         computeChecksum(), deparse()) main;
+    )"), CompilerOptions::FrontendVersion::P4_16);
+    ASSERT_TRUE(test);
+
+    ReferenceMap refMap;
+    TypeMap typeMap;
+    auto program = test->program->apply(EliminateDeadFields(&refMap, &typeMap));
+    ASSERT_TRUE(program != nullptr);
+    ASSERT_EQ(0u, ::errorCount());
+
+    // Local has as many fields as the lists, but no list initializes it
+    EXPECT_EQ(std::vector<cstring>({ "used" }), fieldsOf(program, "Local"));
+    bool written = false;
+    forAllMatching<IR::AssignmentStatement>(program, [&](const IR::AssignmentStatement* a) {
+        if (a->left->toString().endsWith(".dead"))
+            written = true; });
+    EXPECT_FALSE(written);
+
+    // Outer is initialized by a list, and Pair by a list nested in it:
+    // the fields match by position and none of them is removed
+    EXPECT_EQ(std::vector<cstring>({ "p", "z" }), fieldsOf(program, "Outer"));
+    EXPECT_EQ(std::vector<cstring>({ "x", "y" }), fieldsOf(program, "Pair"));
+}
+
+}  // namespace Test
@@ -0,0 +1,149 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <boost/optional.hpp>
+
+#include "gtest/gtest.h"
+#include "ir/ir.h"
+#include "helpers.h"
+#include "lib/exceptions.h"
+
+#include "frontends/common/resolveReferences/referenceMap.h"
+#include "frontends/p4/def_use.h"
+#include "frontends/p4/typeChecking/typeChecker.h"
+#include "frontends/p4/typeMap.h"
+
+using namespace P4;
+
+namespace Test {
+
+namespace {
+
+boost::optional<FrontendTestCase> createControls() {
+    return FrontendTestCase::create(P4_SOURCE(P4Headers::V1MODEL, R"(
+header H { bit<8> a; bit<8> b; }
+struct Headers { H h; }
+struct Metadata { }
+
+parser parse(packet_in packet, out Headers headers, inout Metadata meta,
+             inout standard_metadata_t sm) {
+    state start { packet.extract(headers.h); transition accept; }
+}
+
+control verifyChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control ingress(inout Headers headers, inout Metadata meta,
+                inout standard_metadata_t sm) {
+    apply {
+        bit<8> x;
+        if (headers.h.b == 0)
+            x = 1;
+        else
+            x = 2;
+        headers.h.a = x;
+    }
+}
+control egress(inout Headers headers, inout Metadata meta,
+               inout standard_metadata_t sm) {
+    apply { headers.h.a = headers.h.b; }
+}
+control computeChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control deparse(packet_out packet, in Headers headers) {
+    apply { packet.emit(headers.h); }
+}
+
+V1Switch(parse(), verifyChecksum(), ingress(), egress(),
+         computeChecksum(), deparse()) main;
+    )"), CompilerOptions::FrontendVersion::P4_16);
+}
+
+const IR::P4Control* findControl(const IR::P4Program* program, cstring name) {
+    auto control = program->getDeclByName(name)->to<IR::P4Control>();
+    BUG_CHECK(control != nullptr, "%1%: no such control", name);
+    return control;
+}
+
+}  // namespace
+
+class P4CDefUse : public P4CTest { };
+
+TEST_F(P4CDefUse, ProgramPointNumbering) {
+    auto test = createControls();
+    ASSERT_TRUE(test);
+    auto ingress = findControl(test->program, "ingress");
+    auto egress = findControl(test->program, "egress");
+
+    ProgramPointNumbering numbering;
+    EXPECT_EQ(0u, numbering.id(ProgramPoint::beforeStart));
+    EXPECT_EQ(1u, numbering.id(ProgramPoint(ingress)));
+    EXPECT_EQ(2u, numbering.id(ProgramPoint(ProgramPoint(ingress), egress)));
+    EXPECT_EQ(1u, numbering.id(ProgramPoint(ingress)));
+    EXPECT_TRUE(numbering.point(1) == ProgramPoint(ingress));
+
+    numbering.clear();
+    EXPECT_EQ(0u, numbering.id(ProgramPoint::beforeStart));
+    EXPECT_EQ(1u, numbering.id(ProgramPoint(egress)));
+    EXPECT_THROW(numbering.point(2), Util::CompilerBug);
+}
+
+TEST_F(P4CDefUse, DefinitionsAfterIf) {
+    auto test = createControls();
+    ASSERT_TRUE(test);
+    ReferenceMap refMap;
+    TypeMap typeMap;
+    auto program = test->program->apply(TypeChecking(&refMap, &typeMap));
+    ASSERT_TRUE(program != nullptr);
+    auto ingress = findControl(program, "ingress");
+
+    AllDefinitions definitions(&refMap, &typeMap);
+    ingress->apply(ComputeWriteSet(&definitions));
+    ASSERT_EQ(0u, ::errorCount());
+
+    const IR::IfStatement* ifStatement = nullptr;
+    forAllMatching<IR::IfStatement>(ingress->body, [&](const IR::IfStatement* s) {
+        ifStatement = s; });
+    ASSERT_TRUE(ifStatement != nullptr);
+    const IR::Declaration_Variable* x = nullptr;
+    for (auto d : ingress->controlLocals)
+        if (auto v = d->to<IR::Declaration_Variable>())
+            x = v;
+    ASSERT_TRUE(x != nullptr);
+    auto loc = definitions.storageMap->getStorage(x);
+    ASSERT_TRUE(loc != nullptr);
+
+    // Both assignments reach the statement after the if
+    auto defs = definitions.get(ProgramPoint(ifStatement))->get(loc->to<BaseLocation>());
+    EXPECT_EQ(2u, defs->size());
+    EXPECT_FALSE(defs->containsBeforeStart());
+    std::set<int> values;
+    for (auto p : *defs) {
+        auto assign = p.last()->to<IR::AssignmentStatement>();
+        ASSERT_TRUE(assign != nullptr);
+        values.emplace(assign->right->to<IR::Constant>()->asInt());
+    }
+    EXPECT_EQ((std::set<int>{ 1, 2 }), values);
+
+    // Before the if, x is not initialized
+    auto before = definitions.get(ProgramPoint(ingress))->get(loc->to<BaseLocation>());
+    EXPECT_TRUE(before->containsBeforeStart());
+
+    // A new run starts from scratch: the points of ingress are forgotten
+    auto egress = findControl(program, "egress");
+    egress->apply(ComputeWriteSet(&definitions));
+    EXPECT_THROW(definitions.get(ProgramPoint(ifStatement)), Util::CompilerBug);
+    EXPECT_TRUE(definitions.get(ProgramPoint(egress)) != nullptr);
+}
+
+}  // namespace Test
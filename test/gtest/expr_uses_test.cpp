@@ -19,6 +19,7 @@ limitations under the License.
 #include "ir/visitor.h"
 #include "lib/exceptions.h"
 #include "midend/expr_uses.h"
+#include "midend/has_side_effects.h"
 
 TEST(expr_uses, expr_uses) {
     auto obj1 = new IR::PathExpression("obj1");
@@ -41,3 +42,24 @@ TEST(expr_uses, expr_uses) {
     EXPECT_TRUE(exprUses(sub, "obj1"));
     EXPECT_TRUE(exprUses(sub, "obj2"));
 }
+
+TEST(expr_uses, summary) {
+    auto stack = new IR::PathExpression("stack");
+    auto elem = new IR::ArrayIndex(stack, new IR::Constant(2));
+    auto field = new IR::Member(elem, "f");
+    auto dynamic = new IR::ArrayIndex(stack, new IR::PathExpression("i"));
+    auto assign = new IR::AssignmentStatement(field, new IR::Member(dynamic, "g"));
+
+    auto summary = NodeSummary::get(assign);
+    EXPECT_TRUE(summary->sideEffects);
+    EXPECT_TRUE(summary->writesLocation(Locations::intern("stack[2].f")));
+    EXPECT_FALSE(summary->writesLocation(Locations::intern("stack[1]")));
+    EXPECT_TRUE(summary->readsLocation(Locations::intern("i")));
+    // a non-constant index may denote any element
+    EXPECT_TRUE(summary->readsLocation(Locations::intern("stack[1].f")));
+    EXPECT_FALSE(hasSideEffects(field));
+    EXPECT_TRUE(exprUses(field, "stack[2]"));
+    EXPECT_FALSE(exprUses(field, "stack[3]"));
+    // subtrees are summarized once
+    EXPECT_EQ(NodeSummary::get(field), NodeSummary::get(field));
+}
@@ -0,0 +1,136 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "gtest/gtest.h"
+#include "ir/ir.h"
+#include "helpers.h"
+
+#include "frontends/common/parseInput.h"
+#include "midend/fuseParserStates.h"
+
+using namespace P4;
+
+namespace Test {
+
+namespace {
+
+// The frontend would already collapse 'single' and 'tail', so the
+// pass is applied to the parsed program.
+const char* parsers = R"(
+header H { bit<8> a; bit<8> b; }
+header mpls_t { bit<20> label; bit<3> tc; bit<1> bos; bit<8> ttl; }
+struct Headers { H h; H i; mpls_t[4] mpls; }
+struct Metadata { }
+
+parser parse(packet_in packet, out Headers headers, inout Metadata meta,
+             inout standard_metadata_t sm) {
+    state start {
+        packet.extract(headers.h);
+        transition select(headers.h.a) { 1: one; 2: two; default: single; }
+    }
+    state one { headers.h.b = 1; transition common; }
+    state two { headers.h.b = 2; transition common; }
+    state common { packet.extract(headers.i); transition accept; }
+    state single { headers.h.b = 3; transition tail; }
+    state tail { packet.extract(headers.i); transition accept; }
+}
+
+parser spin(packet_in packet, out Headers headers, inout Metadata meta,
+            inout standard_metadata_t sm) {
+    state start { transition loop; }
+    state loop { packet.extract(headers.mpls.next); transition loop; }
+}
+
+control verifyChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control ingress(inout Headers headers, inout Metadata meta,
+                inout standard_metadata_t sm) { apply { } }
+control egress(inout Headers headers, inout Metadata meta,
+               inout standard_metadata_t sm) { apply { } }
+control computeChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control deparse(packet_out packet, in Headers headers) {
+    apply { packet.emit(headers.h); }
+}
+
+V1Switch(parse(), verifyChecksum(), ingress(), egress(),
+         computeChecksum(), deparse()) main;
+)";
+
+/// The states of parser @name after fusion
+std::map<cstring, const IR::ParserState*> fuse(cstring name, unsigned maxStatements) {
+    std::map<cstring, const IR::ParserState*> result;
+    auto program = parseP4String(P4_SOURCE(P4Headers::V1MODEL, parsers),
+                                 CompilerOptions::FrontendVersion::P4_16);
+    if (program == nullptr)
+        return result;
+    program = program->apply(FuseParserStates(maxStatements));
+    forAllMatching<IR::P4Parser>(program, [&](const IR::P4Parser* parser) {
+        if (parser->name == name)
+            for (auto s : parser->states)
+                result.emplace(s->name.name, s);
+    });
+    return result;
+}
+
+/// The state a state transitions to unconditionally
+cstring next(const IR::ParserState* state) {
+    auto path = state->selectExpression->to<IR::PathExpression>();
+    return path == nullptr ? cstring() : path->path->name.name;
+}
+
+}  // namespace
+
+class P4CFuseParserStates : public P4CTest { };
+
+TEST_F(P4CFuseParserStates, Fusion) {
+    auto states = fuse("parse", 16);
+    ASSERT_EQ(0u, ::errorCount());
+    EXPECT_EQ(4u, states.size());
+    EXPECT_EQ(1u, states.count("start"));
+    EXPECT_EQ(0u, states.count("common"));
+    EXPECT_EQ(0u, states.count("tail"));
+    // 'common' is duplicated into both of its predecessors
+    for (auto name : { "one", "two", "single" }) {
+        ASSERT_EQ(1u, states.count(name));
+        EXPECT_EQ(2u, states[name]->components.size());
+        EXPECT_EQ("accept", next(states[name]));
+    }
+}
+
+TEST_F(P4CFuseParserStates, MaxStatements) {
+    auto states = fuse("parse", 1);
+    ASSERT_EQ(0u, ::errorCount());
+    // 'common' would have two statements in each copy
+    ASSERT_EQ(1u, states.count("common"));
+    EXPECT_EQ(1u, states["one"]->components.size());
+    EXPECT_EQ("common", next(states["one"]));
+    EXPECT_EQ(1u, states["two"]->components.size());
+    // 'tail' has a single predecessor, so it is not copied and the cap does not apply
+    EXPECT_EQ(0u, states.count("tail"));
+    EXPECT_EQ(2u, states["single"]->components.size());
+}
+
+TEST_F(P4CFuseParserStates, SelfLoop) {
+    auto states = fuse("spin", 3);
+    ASSERT_EQ(0u, ::errorCount());
+    // the loop is unrolled into 'start' up to the cap, and is still reachable
+    ASSERT_EQ(2u, states.size());
+    EXPECT_EQ(3u, states["start"]->components.size());
+    EXPECT_EQ("loop", next(states["start"]));
+    EXPECT_EQ(1u, states["loop"]->components.size());
+    EXPECT_EQ("loop", next(states["loop"]));
+}
+
+}  // namespace Test
@@ -0,0 +1,143 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <sstream>
+
+#include "gtest/gtest.h"
+#include "ir/ir.h"
+#include "helpers.h"
+
+#include "frontends/common/parseInput.h"
+#include "frontends/common/resolveReferences/resolveReferences.h"
+#include "frontends/p4/createBuiltins.h"
+#include "frontends/p4/evaluator/evaluator.h"
+#include "frontends/p4/frontend.h"
+#include "frontends/p4/inlining.h"
+#include "frontends/p4/toP4/toP4.h"
+#include "frontends/p4/typeChecking/typeChecker.h"
+
+using namespace P4;
+
+namespace Test {
+
+namespace {
+
+// Two chains of the same depth; the calls of the chain declared first
+// are all scheduled before the calls of the second one.
+const char* hierarchy = R"(
+header H { bit<8> a; bit<8> b; }
+struct Headers { H h; }
+struct Metadata { }
+
+parser parse(packet_in packet, out Headers headers, inout Metadata meta,
+             inout standard_metadata_t sm) {
+    state start { packet.extract(headers.h); transition accept; }
+}
+
+control a3(inout H h) { apply { h.a = h.a + 3; } }
+control a2(inout H h) { a3() i; apply { i.apply(h); h.a = h.a + 2; } }
+control a1(inout H h) { a2() i; apply { h.b = h.b + 1; i.apply(h); } }
+control b3(inout H h) { apply { h.b = h.a; } }
+control b2(inout H h) { b3() i; apply { if (h.a == 0) { i.apply(h); } } }
+control b1(inout H h) { b2() i; apply { i.apply(h); h.b = h.b + 1; } }
+
+control verifyChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control ingress(inout Headers headers, inout Metadata meta,
+                inout standard_metadata_t sm) {
+    a1() a;
+    b1() b;
+    apply { a.apply(headers.h); b.apply(headers.h); }
+}
+control egress(inout Headers headers, inout Metadata meta,
+               inout standard_metadata_t sm) { apply { } }
+control computeChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control deparse(packet_out packet, in Headers headers) {
+    apply { packet.emit(headers.h); }
+}
+
+V1Switch(parse(), verifyChecksum(), ingress(), egress(),
+         computeChecksum(), deparse()) main;
+)";
+
+/// The number of sweeps of the inliner over the hierarchy
+unsigned sweeps(bool byLevel) {
+    auto program = parseP4String(P4_SOURCE(P4Headers::V1MODEL, hierarchy),
+                                 CompilerOptions::FrontendVersion::P4_16);
+    if (program == nullptr)
+        return 0;
+    ReferenceMap refMap;
+    TypeMap typeMap;
+    auto evaluator = new EvaluatorPass(&refMap, &typeMap);
+    PassManager passes = {
+        new CreateBuiltins(),
+        new ResolveReferences(&refMap),
+        new TypeInference(&refMap, &typeMap, false),
+        evaluator,
+    };
+    program = program->apply(passes);
+    if (program == nullptr)
+        return 0;
+
+    InlineWorkList list(byLevel);
+    program->apply(DiscoverInlining(&list, &refMap, &typeMap, evaluator));
+    list.analyze(true);
+    unsigned result = 0;
+    while (list.next() != nullptr)
+        result++;
+    return result;
+}
+
+/// The program after the frontend
+std::string inlined(bool byLevel) {
+    auto program = parseP4String(P4_SOURCE(P4Headers::V1MODEL, hierarchy),
+                                 CompilerOptions::FrontendVersion::P4_16);
+    if (program == nullptr)
+        return "";
+    CompilerOptions options;
+    options.langVersion = CompilerOptions::FrontendVersion::P4_16;
+    options.inlineByLevel = byLevel;
+    program = FrontEnd().run(options, program, true);
+    if (program == nullptr)
+        return "";
+    std::stringstream out;
+    program->apply(ToP4(&out, false));
+    return out.str();
+}
+
+}  // namespace
+
+class P4CInlining : public P4CTest { };
+
+TEST_F(P4CInlining, SweepsByLevel) {
+    // the callers a2 and b2, a1 and b1, then ingress
+    EXPECT_EQ(3u, sweeps(true));
+    // a2; a1 and b2; b1 and the call of a1 in ingress; the call of b1
+    EXPECT_EQ(4u, sweeps(false));
+    EXPECT_EQ(0u, ::errorCount());
+}
+
+TEST_F(P4CInlining, SameOutputByLevel) {
+    auto expected = inlined(false);
+    ASSERT_EQ(0u, ::errorCount());
+    auto actual = inlined(true);
+    ASSERT_EQ(0u, ::errorCount());
+    EXPECT_EQ(expected, actual);
+    // nothing is left to inline
+    EXPECT_EQ(std::string::npos, actual.find("a3() "));
+    EXPECT_EQ(std::string::npos, actual.find("b3() "));
+}
+
+}  // namespace Test
@@ -71,4 +71,24 @@ TEST(Util, Json) {
               obj->toString());
 }
 
+TEST(Util, JsonParse) {
+    auto obj = new JsonObject();
+    obj->emplace("x", "x y");
+    auto arr = new JsonArray();
+    arr->append(-5);
+    arr->append(false);
+    arr->append(new JsonArray());
+    arr->append(new JsonObject());
+    arr->append(new JsonValue());
+    obj->emplace("y", arr);
+    std::stringstream str;
+    obj->serialize(str);
+    auto parsed = IJson::parse(str);
+    ASSERT_TRUE(parsed->is<JsonObject>());
+    EXPECT_EQ(obj->toString(), parsed->toString());
+
+    std::stringstream bad("{\"x\" : [1, 2}");
+    EXPECT_THROW(IJson::parse(bad), std::logic_error);
+}
+
 }  // namespace Util
@@ -0,0 +1,112 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <boost/optional.hpp>
+
+#include "gtest/gtest.h"
+#include "ir/ir.h"
+#include "helpers.h"
+
+#include "frontends/common/resolveReferences/referenceMap.h"
+#include "frontends/p4/typeMap.h"
+#include "midend/local_copyprop.h"
+
+using namespace P4;
+
+namespace Test {
+
+namespace {
+
+/// The values assigned to a field in a control, in program order
+std::vector<cstring> valuesOf(const IR::P4Program* program, cstring control, cstring field) {
+    std::vector<cstring> result;
+    forAllMatching<IR::P4Control>(program, [&](const IR::P4Control* c) {
+        if (c->name != control)
+            return;
+        forAllMatching<IR::AssignmentStatement>(c->body, [&](const IR::AssignmentStatement* a) {
+            if (a->left->toString() == field)
+                result.push_back(a->right->toString()); });
+    });
+    return result;
+}
+
+}  // namespace
+
+class P4CLocalCopyPropagation : public P4CTest { };
+
+TEST_F(P4CLocalCopyPropagation, BranchesAndControls) {
+    auto test = FrontendTestCase::create(P4_SOURCE(P4Headers::V1MODEL, R"(
+header H { bit<8> a; bit<8> b; bit<8> c; }
+struct Headers { H h; }
+struct Metadata { }
+
+parser parse(packet_in packet, out Headers headers, inout Metadata meta,
+             inout standard_metadata_t sm) {
+    state start { packet.extract(headers.h); transition accept; }
+}
+
+control verifyChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control ingress(inout Headers headers, inout Metadata meta,
+                inout standard_metadata_t sm) {
+    apply {
+        bit<8> t = headers.h.a;
+        if (headers.h.b == 0) {
+            headers.h.a = 1;
+            headers.h.c = t;
+        } else {
+            headers.h.a = 2;
+            headers.h.c = t;
+        }
+    }
+}
+control egress(inout Headers headers, inout Metadata meta,
+               inout standard_metadata_t sm) {
+    apply {
+        bit<8> u = headers.h.b;
+        headers.h.c = u;
+    }
+}
+control computeChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control deparse(packet_out packet, in Headers headers) {
+    apply { packet.emit(headers.h); }
+}
+
+V1Switch(parse(), verifyChecksum(), ingress(), egress(),
+         computeChecksum(), deparse()) main;
+    )"), CompilerOptions::FrontendVersion::P4_16);
+    ASSERT_TRUE(test);
+
+    ReferenceMap refMap;
+    TypeMap typeMap;
+    auto program = test->program->apply(LocalCopyPropagation(&refMap, &typeMap));
+    ASSERT_TRUE(program != nullptr);
+    ASSERT_EQ(0u, ::errorCount());
+
+    // Both branches write headers.h.a, which the value of t reads, so
+    // neither may replace t by headers.h.a
+    auto ingress = valuesOf(program, "ingress", "headers.h.c");
+    ASSERT_EQ(2u, ingress.size());
+    EXPECT_NE("headers.h.a", ingress.at(0));
+    EXPECT_NE("headers.h.a", ingress.at(1));
+    EXPECT_EQ(ingress.at(0), ingress.at(1));
+
+    // The second control has its own names, and nothing kills the value of u
+    auto egress = valuesOf(program, "egress", "headers.h.c");
+    ASSERT_EQ(1u, egress.size());
+    EXPECT_EQ("headers.h.b", egress.at(0));
+}
+
+}  // namespace Test
@@ -0,0 +1,130 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <boost/optional.hpp>
+
+#include "gtest/gtest.h"
+#include "ir/ir.h"
+#include "helpers.h"
+
+#include "frontends/common/resolveReferences/referenceMap.h"
+#include "frontends/p4/typeMap.h"
+#include "midend/optimizeSelectCases.h"
+
+using namespace P4;
+
+namespace Test {
+
+namespace {
+
+boost::optional<FrontendTestCase> createParser() {
+    return FrontendTestCase::create(P4_SOURCE(P4Headers::V1MODEL, R"(
+header H { bit<16> etherType; }
+header P { bit<32> data; }
+struct Headers { H h; P p; }
+struct Metadata { }
+
+parser parse(packet_in packet, out Headers headers, inout Metadata meta,
+             inout standard_metadata_t sm) {
+    state start {
+        packet.extract(headers.h);
+        transition select(headers.h.etherType) {
+            16w0x0800: ipv4;
+            16w0x0806: arp;
+            16w0x0801: ipv4;
+            16w0x0800: arp;
+            16w0x0806 &&& 16w0xffff: ipv4;
+            default: accept;
+        }
+    }
+    state ipv4 { packet.extract(headers.p); transition accept; }
+    state arp { headers.p.setValid(); transition accept; }
+}
+
+control verifyChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control ingress(inout Headers headers, inout Metadata meta,
+                inout standard_metadata_t sm) { apply { } }
+control egress(inout Headers headers, inout Metadata meta,
+               inout standard_metadata_t sm) { apply { } }
+control computeChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control deparse(packet_out packet, in Headers headers) {
+    apply { packet.emit(headers.h); }
+}
+
+V1Switch(parse(), verifyChecksum(), ingress(), egress(),
+         computeChecksum(), deparse()) main;
+    )"), CompilerOptions::FrontendVersion::P4_16);
+}
+
+/// The cases of the select expression after optimization
+std::vector<const IR::SelectCase*> optimize(const IR::P4Program* program, bool allowMasks) {
+    ReferenceMap refMap;
+    TypeMap typeMap;
+    program = program->apply(OptimizeSelectCases(&refMap, &typeMap, allowMasks));
+    std::vector<const IR::SelectCase*> result;
+    forAllMatching<IR::SelectCase>(program, [&](const IR::SelectCase* c) {
+        result.push_back(c); });
+    return result;
+}
+
+cstring next(const IR::SelectCase* c)
+{ return c->state->path->name.name; }
+
+}  // namespace
+
+class P4COptimizeSelectCases : public P4CTest { };
+
+TEST_F(P4COptimizeSelectCases, MergeSingleBit) {
+    auto test = createParser();
+    ASSERT_TRUE(test);
+    auto cases = optimize(test->program, true);
+    ASSERT_EQ(0u, ::errorCount());
+
+    // 0x0800 &&& 0xfffe: ipv4; 0x0806: arp; default: accept
+    ASSERT_EQ(3u, cases.size());
+    auto mask = cases[0]->keyset->to<IR::Mask>();
+    ASSERT_TRUE(mask != nullptr);
+    ASSERT_TRUE(mask->left->is<IR::Constant>());
+    ASSERT_TRUE(mask->right->is<IR::Constant>());
+    EXPECT_EQ(0x0800, mask->left->to<IR::Constant>()->asInt());
+    EXPECT_EQ(0xfffe, mask->right->to<IR::Constant>()->asInt());
+    EXPECT_EQ("ipv4", next(cases[0]));
+    ASSERT_TRUE(cases[1]->keyset->is<IR::Constant>());
+    EXPECT_EQ(0x0806, cases[1]->keyset->to<IR::Constant>()->asInt());
+    EXPECT_EQ("arp", next(cases[1]));
+    EXPECT_TRUE(cases[2]->keyset->is<IR::DefaultExpression>());
+}
+
+TEST_F(P4COptimizeSelectCases, RemoveShadowed) {
+    auto test = createParser();
+    ASSERT_TRUE(test);
+    auto cases = optimize(test->program, false);
+    ASSERT_EQ(0u, ::errorCount());
+
+    // 0x0800 is shadowed by the first case; the mask of the fifth
+    // covers all the bits, so it is shadowed by the second case.
+    ASSERT_EQ(4u, cases.size());
+    std::vector<int> values;
+    for (size_t i = 0; i < 3; i++) {
+        ASSERT_TRUE(cases[i]->keyset->is<IR::Constant>());
+        values.push_back(cases[i]->keyset->to<IR::Constant>()->asInt());
+    }
+    EXPECT_EQ(std::vector<int>({ 0x0800, 0x0806, 0x0801 }), values);
+    EXPECT_EQ("ipv4", next(cases[2]));
+    EXPECT_TRUE(cases[3]->keyset->is<IR::DefaultExpression>());
+}
+
+}  // namespace Test
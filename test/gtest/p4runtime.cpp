@@ -14,9 +14,12 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include <google/protobuf/text_format.h>
+#include <google/protobuf/util/json_util.h>
 #include <google/protobuf/util/message_differencer.h>
 
 #include <iterator>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -718,7 +721,7 @@ TEST_F(P4Runtime, StaticTableEntries) {
     ASSERT_TRUE(test);
     EXPECT_EQ(0u, ::diagnosticCount());
 
-    auto entries = test->entries;
+    auto entries = test->entries->toWriteRequest();
     const auto& updates = entries->updates();
     ASSERT_EQ(6, updates.size());
 
@@ -805,6 +808,150 @@ TEST_F(P4Runtime, StaticTableEntries) {
     }
 }
 
+namespace {
+
+/// A program whose table 't' has the const entries in @entries, with a
+/// bit<@width> exact key and an action 'a' with parameters of @params.
+std::string staticEntriesProgram(int width, const std::string& params,
+                                 const std::string& entries) {
+    std::ostringstream source;
+    source << R"(
+        header Header { bit<)" << width << R"(> f; }
+        struct Headers { Header h; }
+        struct Metadata { }
+
+        parser parse(packet_in p, out Headers h, inout Metadata m,
+                     inout standard_metadata_t sm) {
+            state start { transition accept; } }
+        control verifyChecksum(inout Headers h, inout Metadata m) { apply { } }
+        control egress(inout Headers h, inout Metadata m,
+                        inout standard_metadata_t sm) { apply { } }
+        control computeChecksum(inout Headers h, inout Metadata m) { apply { } }
+        control deparse(packet_out p, in Headers h) { apply { } }
+
+        control ingress(inout Headers h, inout Metadata m,
+                        inout standard_metadata_t sm) {
+            action a()" << params << R"() { }
+            table t {
+                key = { h.h.f : exact; }
+                actions = { a; }
+                )" << entries << R"(
+            }
+            apply { t.apply(); }
+        }
+        V1Switch(parse(), verifyChecksum(), ingress(), egress(),
+                 computeChecksum(), deparse()) main;
+    )";
+    return source.str();
+}
+
+/// The streamed entries in each format, and the same WriteRequest
+/// message serialized in one piece.
+void checkSerializedEntries(P4::P4RuntimeAPI& api) {
+    auto request = api.entries->toWriteRequest();
+
+    std::ostringstream binary;
+    api.serializeEntriesTo(&binary, P4::P4RuntimeFormat::BINARY);
+    EXPECT_EQ(request->SerializeAsString(), binary.str());
+
+    std::ostringstream text;
+    api.serializeEntriesTo(&text, P4::P4RuntimeFormat::TEXT);
+    std::string expectedText;
+    ASSERT_TRUE(google::protobuf::TextFormat::PrintToString(*request, &expectedText));
+    EXPECT_EQ(expectedText, text.str());
+
+    std::ostringstream json;
+    api.serializeEntriesTo(&json, P4::P4RuntimeFormat::JSON);
+    google::protobuf::util::JsonPrintOptions options;
+    options.add_whitespace = true;
+    std::string expectedJson;
+    ASSERT_TRUE(google::protobuf::util::MessageToJsonString(*request, &expectedJson, options)
+                .ok());
+    EXPECT_EQ(expectedJson, json.str());
+    EXPECT_EQ(0u, ::errorCount());
+}
+
+}  // namespace
+
+TEST_F(P4Runtime, StaticTableEntriesSerialization) {
+    auto test = createP4RuntimeTestCase(P4_SOURCE(P4Headers::V1MODEL,
+        staticEntriesProgram(16, "bit<8> x", R"(
+            const entries = {
+                0x0001 : a(1);
+                0x0203 : a(2);
+                0xffff : a(3);
+            }
+        )").c_str()));
+    ASSERT_TRUE(test);
+    EXPECT_EQ(0u, ::diagnosticCount());
+    EXPECT_EQ(3, test->entries->toWriteRequest()->updates().size());
+    checkSerializedEntries(*test);
+}
+
+TEST_F(P4Runtime, StaticTableEntriesSerializationEmpty) {
+    auto test = createP4RuntimeTestCase(P4_SOURCE(P4Headers::V1MODEL,
+        staticEntriesProgram(16, "", "default_action = a;").c_str()));
+    ASSERT_TRUE(test);
+    EXPECT_EQ(0u, ::diagnosticCount());
+    EXPECT_EQ(0, test->entries->toWriteRequest()->updates().size());
+    checkSerializedEntries(*test);
+
+    // An empty request is an empty binary message and an empty text message
+    std::ostringstream binary, text;
+    test->serializeEntriesTo(&binary, P4::P4RuntimeFormat::BINARY);
+    test->serializeEntriesTo(&text, P4::P4RuntimeFormat::TEXT);
+    EXPECT_EQ("", binary.str());
+    EXPECT_EQ("", text.str());
+}
+
+TEST_F(P4Runtime, StaticTableEntriesKeyEncoding) {
+    // The key is exactly the bytes of the value, big-endian, padded to the
+    // width of the key; up to 64 bits the value is encoded directly.
+    auto key = [](int width, const std::string& value) {
+        auto test = createP4RuntimeTestCase(P4_SOURCE(P4Headers::V1MODEL,
+            staticEntriesProgram(width, "", "const entries = { " + value + " : a(); }")
+                .c_str()));
+        EXPECT_TRUE(test);
+        if (!test) return std::string();
+        EXPECT_EQ(0u, ::diagnosticCount());
+        auto request = test->entries->toWriteRequest();
+        EXPECT_EQ(1, request->updates().size());
+        if (request->updates().size() != 1) return std::string();
+        return request->updates(0).entity().table_entry().match(0).exact().value();
+    };
+
+    EXPECT_EQ(std::string("\x00\x00\x00\x00\x0a\x0b", 6), key(48, "0x0a0b"));
+    EXPECT_EQ(std::string("\x00\x00\x00\x00\x00\x00\x00\x00", 8), key(64, "0"));
+    EXPECT_EQ("\x01\x02\x03\x04\x05\x06\x07\x08", key(64, "0x0102030405060708"));
+    EXPECT_EQ("\xff\xff\xff\xff\xff\xff\xff\xff", key(64, "0xffffffffffffffff"));
+    // wider keys go through mpz_export
+    EXPECT_EQ(std::string("\x00\x01\x02\x03\x04\x05\x06\x07\x08", 9),
+              key(72, "0x0102030405060708"));
+    EXPECT_EQ("\x01\x02\x03\x04\x05\x06\x07\x08\x09", key(72, "0x010203040506070809"));
+    // a width which is not a multiple of 8
+    EXPECT_EQ(std::string("\x00\x05", 2), key(9, "5"));
+}
+
+TEST_F(P4Runtime, StaticTableEntriesParameterWidths) {
+    // Each argument is encoded with the width of its own parameter.
+    auto test = createP4RuntimeTestCase(P4_SOURCE(P4Headers::V1MODEL,
+        staticEntriesProgram(8, "bit<8> x, bit<16> y, bit<32> z",
+                             "const entries = { 1 : a(1, 2, 3); }").c_str()));
+    ASSERT_TRUE(test);
+    EXPECT_EQ(0u, ::diagnosticCount());
+    auto request = test->entries->toWriteRequest();
+    ASSERT_EQ(1, request->updates().size());
+    const auto& params = request->updates(0).entity().table_entry().action().action().params();
+    ASSERT_EQ(3, params.size());
+    EXPECT_EQ(1u, params.Get(0).param_id());
+    EXPECT_EQ("\x01", params.Get(0).value());
+    EXPECT_EQ(2u, params.Get(1).param_id());
+    EXPECT_EQ(std::string("\x00\x02", 2), params.Get(1).value());
+    EXPECT_EQ(3u, params.Get(2).param_id());
+    EXPECT_EQ(std::string("\x00\x00\x00\x03", 4), params.Get(2).value());
+    checkSerializedEntries(*test);
+}
+
 TEST_F(P4Runtime, IsConstTable) {
     auto test = createP4RuntimeTestCase(P4_SOURCE(P4Headers::V1MODEL, R"(
         header Header { bit<8> hfA; }
@@ -0,0 +1,152 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <boost/optional.hpp>
+
+#include "gtest/gtest.h"
+#include "ir/ir.h"
+#include "helpers.h"
+
+#include "frontends/common/resolveReferences/referenceMap.h"
+#include "frontends/p4/typeMap.h"
+#include "midend/parserUnroll.h"
+
+using namespace P4;
+
+namespace Test {
+
+namespace {
+
+/// A program whose parser has the given states
+boost::optional<FrontendTestCase> createParser(const std::string& states) {
+    std::string source = R"(
+header H { bit<8> a; bit<8> b; }
+header mpls_t { bit<20> label; bit<3> tc; bit<1> bos; bit<8> ttl; }
+struct Headers { H h; mpls_t[4] mpls; }
+struct Metadata { }
+
+parser parse(packet_in packet, out Headers headers, inout Metadata meta,
+             inout standard_metadata_t sm) {
+)" + states + R"(
+}
+
+control verifyChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control ingress(inout Headers headers, inout Metadata meta,
+                inout standard_metadata_t sm) { apply { } }
+control egress(inout Headers headers, inout Metadata meta,
+               inout standard_metadata_t sm) { apply { } }
+control computeChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control deparse(packet_out packet, in Headers headers) {
+    apply { packet.emit(headers.h); }
+}
+
+V1Switch(parse(), verifyChecksum(), ingress(), egress(),
+         computeChecksum(), deparse()) main;
+    )";
+    return FrontendTestCase::create(P4_SOURCE(P4Headers::V1MODEL, source.c_str()),
+                                    CompilerOptions::FrontendVersion::P4_16);
+}
+
+// 'left' and 'right' reach 'mpls' with the same values
+const char* loop = R"(
+    state start {
+        packet.extract(headers.h);
+        transition select(headers.h.a) { 1: left; 2: right; default: accept; }
+    }
+    state left { transition mpls; }
+    state right { transition mpls; }
+    state mpls {
+        packet.extract(headers.mpls.next);
+        transition select(headers.mpls.last.bos) { 0: mpls; default: accept; }
+    }
+)";
+
+const char* overflow = R"(
+    state start {
+        packet.extract(headers.mpls.next);
+        packet.extract(headers.mpls.next);
+        packet.extract(headers.mpls.next);
+        packet.extract(headers.mpls.next);
+        packet.extract(headers.mpls.next);
+        transition accept;
+    }
+)";
+
+/// The statistics of the symbolic evaluation of the parser
+ParserUnrollStatistics analyze(const IR::P4Program* program, unsigned budget) {
+    ReferenceMap refMap;
+    TypeMap typeMap;
+    program = program->apply(TypeChecking(&refMap, &typeMap));
+    ParserUnrollStatistics result;
+    forAllMatching<IR::P4Parser>(program, [&](const IR::P4Parser* parser) {
+        ParserStructure structure;
+        structure.setParser(parser);
+        parser->apply(AnalyzeParser(&refMap, &structure));
+        structure.analyze(&refMap, &typeMap, false, budget);
+        result = structure.stats;
+    });
+    return result;
+}
+
+unsigned warningCount()
+{ return BaseCompileContext::get().errorReporter().getWarningCount(); }
+
+}  // namespace
+
+class P4CParserUnroll : public P4CTest { };
+
+TEST_F(P4CParserUnroll, Memoized) {
+    auto test = createParser(loop);
+    ASSERT_TRUE(test);
+    auto stats = analyze(test->program, 10000);
+    // start, right, mpls 5 times and left; 'mpls' after 'left' is memoized
+    EXPECT_EQ(8u, stats.evaluated);
+    EXPECT_EQ(1u, stats.memoized);
+    EXPECT_EQ(0u, stats.loops);
+    EXPECT_FALSE(stats.budgetExhausted);
+    // the fifth extract overflows the stack in a copy of 'mpls'
+    EXPECT_EQ(0u, ::diagnosticCount());
+}
+
+TEST_F(P4CParserUnroll, Budget) {
+    auto test = createParser(loop);
+    ASSERT_TRUE(test);
+    auto stats = analyze(test->program, 3);
+    EXPECT_EQ(3u, stats.evaluated);
+    EXPECT_TRUE(stats.budgetExhausted);
+    EXPECT_EQ(1u, warningCount());
+    EXPECT_EQ(0u, ::errorCount());
+}
+
+TEST_F(P4CParserUnroll, ErrorInOriginalState) {
+    auto test = createParser(overflow);
+    ASSERT_TRUE(test);
+    auto stats = analyze(test->program, 10000);
+    EXPECT_EQ(1u, stats.evaluated);
+    EXPECT_EQ(1u, ::errorCount());
+}
+
+TEST_F(P4CParserUnroll, Pass) {
+    auto test = createParser(loop);
+    ASSERT_TRUE(test);
+    ReferenceMap refMap;
+    TypeMap typeMap;
+    test->program->apply(ParsersUnroll(false, &refMap, &typeMap, 3));
+    EXPECT_EQ(1u, warningCount());
+    EXPECT_EQ(0u, ::errorCount());
+}
+
+}  // namespace Test
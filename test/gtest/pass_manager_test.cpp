@@ -0,0 +1,89 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "helpers.h"
+#include "ir/ir.h"
+#include "ir/pass_manager.h"
+
+namespace Test {
+
+namespace {
+
+// Replaces the constants 1 by 2 and records the declarations it visits
+class RewriteOnes : public Transform {
+ public:
+    std::vector<cstring> visited;
+
+    RewriteOnes() { declarationLocal = true; setName("RewriteOnes"); }
+    const IR::Node* preorder(IR::Declaration_Constant* decl) override {
+        visited.push_back(decl->name.name);
+        return decl; }
+    const IR::Node* postorder(IR::Constant* constant) override {
+        if (constant->value == 1)
+            return new IR::Constant(constant->type, 2);
+        return constant; }
+};
+
+const IR::P4Program* makeProgram() {
+    auto type = IR::Type_Bits::get(8);
+    IR::IndexedVector<IR::Node> declarations;
+    declarations.push_back(new IR::Declaration_Constant(
+        IR::ID("a"), type, new IR::Constant(type, 1)));
+    declarations.push_back(new IR::Declaration_Constant(
+        IR::ID("b"), type, new IR::PathExpression(IR::ID("a"))));
+    declarations.push_back(new IR::Declaration_Constant(
+        IR::ID("c"), type, new IR::Constant(type, 3)));
+    return new IR::P4Program(declarations);
+}
+
+}  // namespace
+
+class P4C_PassManager : public P4CTest { };
+
+TEST_F(P4C_PassManager, ChangeDrivenPassRepeated) {
+    auto rewrite = new RewriteOnes;
+    PassRepeated repeated({ rewrite });
+    repeated.setChangeDriven();
+    auto program = makeProgram()->apply(repeated);
+    ASSERT_TRUE(program != nullptr);
+    EXPECT_EQ(2u, repeated.getIterations());
+
+    // The second iteration revisits a, which was replaced, and b, which
+    // names a; c did not change and is skipped.
+    std::vector<cstring> expected = { "a", "b", "c", "a", "b" };
+    EXPECT_EQ(expected, rewrite->visited);
+
+    auto a = program->getDeclByName("a")->to<IR::Declaration_Constant>();
+    ASSERT_TRUE(a != nullptr);
+    EXPECT_EQ(2, a->initializer->to<IR::Constant>()->asInt());
+}
+
+TEST_F(P4C_PassManager, PassRepeated) {
+    auto rewrite = new RewriteOnes;
+    PassRepeated repeated({ rewrite });
+    auto program = makeProgram()->apply(repeated);
+    ASSERT_TRUE(program != nullptr);
+    EXPECT_EQ(2u, repeated.getIterations());
+
+    // without change-driven mode every iteration visits everything
+    std::vector<cstring> expected = { "a", "b", "c", "a", "b", "c" };
+    EXPECT_EQ(expected, rewrite->visited);
+}
+
+}  // namespace Test
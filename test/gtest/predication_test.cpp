@@ -0,0 +1,139 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <boost/optional.hpp>
+
+#include "gtest/gtest.h"
+#include "ir/ir.h"
+#include "helpers.h"
+
+#include "frontends/common/resolveReferences/referenceMap.h"
+#include "frontends/common/resolveReferences/resolveReferences.h"
+#include "midend/predication.h"
+
+using namespace P4;
+
+namespace Test {
+
+namespace {
+
+boost::optional<FrontendTestCase> createActions() {
+    return FrontendTestCase::create(P4_SOURCE(P4Headers::V1MODEL, R"(
+header H { bit<8> a; bit<8> b; bit<8> c; }
+struct Headers { H h; }
+struct Metadata { }
+
+parser parse(packet_in packet, out Headers headers, inout Metadata meta,
+             inout standard_metadata_t sm) {
+    state start { packet.extract(headers.h); transition accept; }
+}
+
+control verifyChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control ingress(inout Headers headers, inout Metadata meta,
+                inout standard_metadata_t sm) {
+    action single() {
+        if (headers.h.c == 0) { headers.h.a = 1; }
+    }
+    action twoMuxes() {
+        if (headers.h.c == 0) {
+            headers.h.a = 1; headers.h.b = 2;
+        } else {
+            headers.h.a = 3; headers.h.b = 4;
+        }
+    }
+    action sameValue() {
+        if (headers.h.a == 1) {
+            headers.h.a = 5; headers.h.b = 1;
+        } else {
+            headers.h.a = 5; headers.h.b = 2;
+        }
+    }
+    table t {
+        actions = { single; twoMuxes; sameValue; }
+        default_action = single();
+    }
+    apply { t.apply(); }
+}
+control egress(inout Headers headers, inout Metadata meta,
+               inout standard_metadata_t sm) { apply { } }
+control computeChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control deparse(packet_out packet, in Headers headers) {
+    apply { packet.emit(headers.h); }
+}
+
+V1Switch(parse(), verifyChecksum(), ingress(), egress(),
+         computeChecksum(), deparse()) main;
+    )"), CompilerOptions::FrontendVersion::P4_16);
+}
+
+/// The assignments of each action after predication
+std::map<cstring, std::vector<const IR::AssignmentStatement*>>
+predicate(const IR::P4Program* program, bool optimized) {
+    ReferenceMap refMap;
+    program = program->apply(ResolveReferences(&refMap));
+    program = program->apply(Predication(&refMap, optimized));
+    std::map<cstring, std::vector<const IR::AssignmentStatement*>> result;
+    forAllMatching<IR::P4Action>(program, [&](const IR::P4Action* action) {
+        auto& assignments = result[action->externalName()];
+        forAllMatching<IR::AssignmentStatement>(action->body,
+                [&](const IR::AssignmentStatement* assign) {
+            assignments.push_back(assign); });
+    });
+    return result;
+}
+
+}  // namespace
+
+class P4CPredication : public P4CTest { };
+
+TEST_F(P4CPredication, AssignmentCounts) {
+    auto test = createActions();
+    ASSERT_TRUE(test);
+    auto before = predicate(test->program, false);
+    auto after = predicate(test->program, true);
+    ASSERT_EQ(0u, ::errorCount());
+
+    // single: a = c == 0 ? 1 : a
+    EXPECT_EQ(3u, before["ingress.single"].size());
+    EXPECT_EQ(1u, after["ingress.single"].size());
+    // twoMuxes: cond = c == 0; a = cond ? 1 : 3; b = cond ? 2 : 4
+    EXPECT_EQ(8u, before["ingress.twoMuxes"].size());
+    EXPECT_EQ(3u, after["ingress.twoMuxes"].size());
+    // sameValue: cond = a == 1; a = 5; b = cond ? 1 : 2
+    EXPECT_EQ(8u, before["ingress.sameValue"].size());
+    EXPECT_EQ(3u, after["ingress.sameValue"].size());
+}
+
+// The condition reads a field which is assigned before the mux
+TEST_F(P4CPredication, ConditionSavedBeforeWrite) {
+    auto test = createActions();
+    ASSERT_TRUE(test);
+    auto after = predicate(test->program, true);
+    ASSERT_EQ(0u, ::errorCount());
+
+    auto& assignments = after["ingress.sameValue"];
+    ASSERT_EQ(3u, assignments.size());
+    auto save = assignments.at(0);
+    EXPECT_TRUE(save->left->is<IR::PathExpression>());
+    EXPECT_TRUE(save->right->is<IR::Equ>());
+    EXPECT_EQ("headers.h.a", assignments.at(1)->left->toString());
+    EXPECT_TRUE(assignments.at(1)->right->is<IR::Constant>());
+    auto mux = assignments.at(2)->right->to<IR::Mux>();
+    ASSERT_TRUE(mux != nullptr);
+    EXPECT_TRUE(mux->e0->equiv(*save->left));
+}
+
+}  // namespace Test
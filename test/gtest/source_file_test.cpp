@@ -73,6 +73,12 @@ TEST(UtilSourceFile, InputSources) {
     SourceFileLine original = sources.getSourceLine(3);
     EXPECT_EQ("fakesource.p4", original.fileName);
     EXPECT_EQ(5u, original.sourceLine);
+
+    SourceInfo span(&sources, SourcePosition(1, 6), SourcePosition(2, 3));
+    EXPECT_EQ("First line\nSecond line\n", span.toSourceText());
+    SourceInfo line(&sources, SourcePosition(3, 0), SourcePosition(3, 5));
+    EXPECT_EQ("Third line\n", line.toSourceText());
+    EXPECT_EQ("", SourceInfo().toSourceText());
 }
 
 TEST(UtilSourceFile, SourceInfo) {
@@ -0,0 +1,158 @@
+/*
+Copyright 2013-present Barefoot Networks, Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <boost/optional.hpp>
+
+#include "gtest/gtest.h"
+#include "ir/ir.h"
+#include "helpers.h"
+
+#include "frontends/common/resolveReferences/referenceMap.h"
+#include "frontends/p4/typeMap.h"
+#include "midend/actionSynthesis.h"
+#include "midend/removeParameters.h"
+#include "midend/specializeActions.h"
+
+using namespace P4;
+
+namespace Test {
+
+namespace {
+
+const IR::P4Program* specialize(const IR::P4Program* program) {
+    ReferenceMap refMap;
+    TypeMap typeMap;
+    PassManager passes = {
+        new RemoveActionParameters(&refMap, &typeMap),
+        new MoveActionsToTables(&refMap, &typeMap),
+        new SpecializeConstantActions(&refMap, &typeMap),
+    };
+    return program->apply(passes);
+}
+
+const IR::P4Table* findTable(const IR::P4Program* program, cstring name) {
+    const IR::P4Table* result = nullptr;
+    forAllMatching<IR::P4Table>(program, [&](const IR::P4Table* table) {
+        if (table->name.name == name)
+            result = table; });
+    return result;
+}
+
+/// The action called by the default action of a table
+const IR::MethodCallExpression* defaultCall(const IR::P4Table* table) {
+    auto prop = table->properties->getProperty(
+        IR::TableProperties::defaultActionPropertyName);
+    return prop->value->to<IR::ExpressionValue>()->expression->to<IR::MethodCallExpression>();
+}
+
+/// The name of the action called by 'call'
+cstring called(const IR::MethodCallExpression* call)
+{ return call->method->to<IR::PathExpression>()->path->name.name; }
+
+}  // namespace
+
+class P4CSpecializeActions : public P4CTest { };
+
+TEST_F(P4CSpecializeActions, HiddenTablesOnly) {
+    auto test = FrontendTestCase::create(P4_SOURCE(P4Headers::V1MODEL, R"(
+header H { bit<8> a; }
+struct Headers { H h; }
+struct Metadata { }
+
+parser parse(packet_in packet, out Headers headers, inout Metadata meta,
+             inout standard_metadata_t sm) {
+    state start { packet.extract(headers.h); transition accept; }
+}
+
+control verifyChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control ingress(inout Headers headers, inout Metadata meta,
+                inout standard_metadata_t sm) {
+    action set(bit<8> v) { headers.h.a = v; }
+    table t {
+        key = { headers.h.a : exact; }
+        actions = { set; }
+        const entries = { 0 : set(1); }
+        const default_action = set(2);
+    }
+    @hidden table u {
+        key = { headers.h.a : exact; }
+        actions = { set; }
+        const entries = { 1 : set(3); }
+        const default_action = set(3);
+    }
+    apply {
+        t.apply();
+        u.apply();
+    }
+}
+control egress(inout Headers headers, inout Metadata meta,
+               inout standard_metadata_t sm) { apply { } }
+control computeChecksum(inout Headers headers, inout Metadata meta) { apply { } }
+control deparse(packet_out packet, in Headers headers) {
+    apply { packet.emit(headers.h); }
+}
+
+V1Switch(parse(), verifyChecksum(), ingress(), egress(),
+         computeChecksum(), deparse()) main;
+    )"), CompilerOptions::FrontendVersion::P4_16);
+    ASSERT_TRUE(test);
+    auto program = specialize(test->program);
+    ASSERT_TRUE(program != nullptr);
+    ASSERT_EQ(0u, ::errorCount());
+
+    // t is visible to the control-plane: its entries and default
+    // action still call the original action
+    auto t = findTable(program, "t");
+    ASSERT_TRUE(t != nullptr);
+    EXPECT_EQ(1u, t->getActionList()->size());
+    EXPECT_EQ(1u, defaultCall(t)->arguments->size());
+    auto entries = t->properties->getProperty(IR::TableProperties::entriesPropertyName)
+            ->value->to<IR::EntriesList>();
+    ASSERT_TRUE(entries != nullptr);
+    auto entry = entries->entries.at(0)->action->to<IR::MethodCallExpression>();
+    EXPECT_EQ(1u, entry->arguments->size());
+
+    // The entry and the default action of the hidden table call
+    // the same copy without parameters
+    auto hidden = findTable(program, "u");
+    ASSERT_TRUE(hidden != nullptr);
+    EXPECT_EQ(2u, hidden->getActionList()->size());
+    auto call = defaultCall(hidden);
+    EXPECT_EQ(0u, call->arguments->size());
+    cstring copy = called(call);
+    EXPECT_NE(called(entry), copy);
+    auto hiddenEntries = hidden->properties->getProperty(
+        IR::TableProperties::entriesPropertyName)->value->to<IR::EntriesList>();
+    ASSERT_TRUE(hiddenEntries != nullptr);
+    auto hiddenEntry = hiddenEntries->entries.at(0)->action->to<IR::MethodCallExpression>();
+    EXPECT_EQ(copy, called(hiddenEntry));
+
+    const IR::P4Action* action = nullptr;
+    forAllMatching<IR::P4Action>(program, [&](const IR::P4Action* a) {
+        if (a->name.name == copy)
+            action = a; });
+    ASSERT_TRUE(action != nullptr);
+    EXPECT_TRUE(action->getAnnotation(IR::Annotation::hiddenAnnotation) != nullptr);
+    EXPECT_TRUE(action->parameters->empty());
+    ASSERT_EQ(1u, action->body->components.size());
+    auto assign = action->body->components.at(0)->to<IR::AssignmentStatement>();
+    ASSERT_TRUE(assign != nullptr);
+    auto value = assign->right->to<IR::Constant>();
+    ASSERT_TRUE(value != nullptr);
+    EXPECT_EQ(3, value->asInt());
+}
+
+}  // namespace Test